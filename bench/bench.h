@@ -0,0 +1,168 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   bench.h
+ * \brief  Minimal benchmark harness with hardware counters.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Every benchmark processes a known number of elements per call; the harness
+ * calibrates the number of calls to run for at least `min_time` seconds, keeps
+ * the fastest of several repetitions and reports per-element figures: time,
+ * cycles, IPC, bytes moved and cache and branch misses (if counters exist).
+**/
+
+#ifndef METRIC_BENCH_BENCH_H_
+#define METRIC_BENCH_BENCH_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "perf_counters.h"
+
+namespace metric {
+namespace bench {
+
+/** \brief Prevent the compiler from optimizing away the computation of `v`. **/
+template <typename T>
+inline void do_not_optimize(const T& v) {
+  __asm__ __volatile__("" : : "r"(&v) : "memory");
+}
+
+/** \brief Prevent the compiler from caching memory contents across this point. **/
+inline void clobber_memory() {
+  __asm__ __volatile__("" : : : "memory");
+}
+
+/** \brief Per-element figures of one benchmark. **/
+struct result {
+  std::string name;
+  double ns;                    ///< \brief Nanoseconds per element.
+  double bytes;                 ///< \brief Bytes moved per element.
+  double values[counters];      ///< \brief Counter values per element.
+  bool available[counters];     ///< \brief Availability of counter values.
+};
+
+/**
+ * \brief Runs benchmarks and prints one line of per-element figures each.
+ **/
+class runner {
+ public:
+  /*!
+   * \brief Construct runner.
+   * \param filter Only benchmarks whose name contains `filter` are run.
+   * \param out Stream to print results to.
+   * \param min_time Minimum duration of one repetition in seconds.
+   * \param repetitions Number of repetitions, the fastest is reported.
+   **/
+  explicit runner(std::string filter = std::string(), std::FILE* out = stdout,
+                  double min_time = 0.05, int repetitions = 5)
+    : filter_(std::move(filter)), out_(out), min_time_(min_time), repetitions_(repetitions) {}
+
+  /*!
+   * \brief Run benchmark `name`.
+   * \param name Name of the benchmark.
+   * \param elements Number of elements processed by each call of `body`.
+   * \param bytes Number of bytes read and written per element.
+   * \param body Benchmark kernel.
+   **/
+  template <typename F>
+  void run(const std::string& name, std::size_t elements, double bytes, F body) {
+    if (!filter_.empty() && name.find(filter_) == std::string::npos) return;
+    if (!header_) print_header();
+
+    // calibrate number of calls per repetition
+    std::size_t calls = 1;
+    for (;;) {
+      const double t = time(body, calls);
+      if (t >= min_time_ || calls >= (std::size_t(1) << 30)) break;
+      calls = t <= 0.0 ? calls * 10 : static_cast<std::size_t>(static_cast<double>(calls) * min_time_ / t * 1.2) + 1;
+    }
+
+    result r;
+    r.name = name;
+    r.ns = 0.0;
+    r.bytes = bytes;
+    const double n = static_cast<double>(calls) * static_cast<double>(elements);
+    for (int rep = 0; rep < repetitions_; ++rep) {
+      counters_.start();
+      const double t = time(body, calls);
+      counters_.stop();
+      if (rep > 0 && t * 1e9 / n >= r.ns) continue;
+      r.ns = t * 1e9 / n;
+      for (int c = 0; c < counters; ++c) {
+        r.available[c] = counters_.available(static_cast<counter>(c));
+        r.values[c] = static_cast<double>(counters_[static_cast<counter>(c)]) / n;
+      }
+    }
+    print(r);
+  }
+
+  /*! \brief Return the hardware counters used by this runner. **/
+  const perf_counters& hardware_counters() const noexcept { return counters_; }
+
+ private:
+  template <typename F>
+  static double time(F& body, std::size_t calls) {
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < calls; ++i) {
+      body();
+      clobber_memory();
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void print_header() {
+    header_ = true;
+    if (!counters_.any())
+      std::fprintf(out_, "# hardware counters unavailable, reporting time only\n");
+    std::fprintf(out_, "%-48s %10s %10s %8s %10s %10s %12s %12s\n", "benchmark", "ns/elem",
+                 "cycles/elem", "IPC", "bytes/elem", "GB/s", "llc-miss/elem", "br-miss/elem");
+  }
+
+  void print(const result& r) {
+    char cycles[32] = "-", ipc[32] = "-", misses[32] = "-", branches[32] = "-";
+    const int cy = static_cast<int>(counter::cycles), in = static_cast<int>(counter::instructions);
+    const int cm = static_cast<int>(counter::cache_misses), bm = static_cast<int>(counter::branch_misses);
+    if (r.available[cy]) std::snprintf(cycles, sizeof(cycles), "%.3f", r.values[cy]);
+    if (r.available[cy] && r.available[in] && r.values[cy] > 0.0)
+      std::snprintf(ipc, sizeof(ipc), "%.2f", r.values[in] / r.values[cy]);
+    if (r.available[cm]) std::snprintf(misses, sizeof(misses), "%.5f", r.values[cm]);
+    if (r.available[bm]) std::snprintf(branches, sizeof(branches), "%.5f", r.values[bm]);
+    std::fprintf(out_, "%-48s %10.3f %10s %8s %10.1f %10.2f %12s %12s\n", r.name.c_str(), r.ns,
+                 cycles, ipc, r.bytes, r.ns > 0.0 ? r.bytes / r.ns : 0.0, misses, branches);
+    std::fflush(out_);
+  }
+
+  std::string filter_;
+  std::FILE* out_;
+  double min_time_;
+  int repetitions_;
+  bool header_ = false;
+  perf_counters counters_;
+};
+
+}  // namespace bench
+}  // namespace metric
+
+#endif  // METRIC_BENCH_BENCH_H_
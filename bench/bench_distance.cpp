@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bench.h"
+#include "metric_core.h"
+#include "metric_array.h"
+#include "metric_bulk.h"
+#include "metric_hash.h"
+#include "metric_histogram.h"
+#include "metric_kinematics.h"
+#include "metric_lut.h"
+#include "metric_parallel.h"
+#if __cplusplus >= 202002L
+#include "metric_ranges.h"
+#endif
+#if defined(METRIC_BENCH_KERNELS)
+#include "metric_kernels.h"
+#endif
+#include "metric_series.h"
+#include "metric_tof.h"
+#include "metric_view.h"
+#include "workload.h"
+
+using namespace metric;
+using metric::bench::do_not_optimize;
+
+namespace {
+
+template <typename Repr>
+using yards = distance<Repr, std::ratio<1143, 1250>>;
+
+/* Casts of LiDAR ranges, given in units of `From`. */
+template <typename To, typename From>
+void cast(bench::runner& r, const std::string& name, std::size_t n) {
+  distance_array<From> in;
+  bench::lidar_generator().generate(in, n);
+  distance_array<To> out(n);
+  r.run(name, n, sizeof(From) + sizeof(To), [&] {
+    distance_cast_n<To>(in.data(), n, out.data());
+    do_not_optimize(out.data()[n - 1]);
+  });
+}
+
+/* `distance_cast` specializations: identity, division, multiplication and both. */
+void distance_cast_specializations(bench::runner& r, std::size_t n, const std::string& size) {
+  cast<millimeters<std::int64_t>, millimeters<std::int64_t>>(r, "distance_cast/identity/i64/" + size, n);
+  cast<meters<std::int64_t>, millimeters<std::int64_t>>(r, "distance_cast/divide/i64/" + size, n);
+  cast<millimeters<std::int64_t>, meters<std::int64_t>>(r, "distance_cast/multiply/i64/" + size, n);
+  cast<meters<std::int64_t>, yards<std::int64_t>>(r, "distance_cast/general/i64/" + size, n);
+  cast<meters<std::int32_t>, millimeters<std::int32_t>>(r, "distance_cast/divide/i32/" + size, n);
+  cast<millimeters<double>, meters<double>>(r, "distance_cast/multiply/f64/" + size, n);
+  cast<meters<double>, yards<double>>(r, "distance_cast/general/f64/" + size, n);
+  cast<meters<double>, millimeters<std::int64_t>>(r, "distance_cast/divide/i64-f64/" + size, n);
+}
+
+/* Bulk kernels on contiguous and strided (LAS record) input. */
+void bulk_kernels(bench::runner& r, std::size_t n, const std::string& size) {
+  // x coordinates of a point cloud in mm, contiguous and in LAS format 0 records
+  point_array<millimeters<std::int32_t>, 3> cloud;
+  bench::point_cloud_generator().generate(cloud, n);
+  std::vector<std::int32_t> c(n);
+  for (std::size_t i = 0; i < n; ++i) c[i] = cloud.x()[i].count();
+  constexpr std::size_t record = 20;
+  std::vector<unsigned char> records(n * record);
+  for (std::size_t i = 0; i < n; ++i) std::memcpy(&records[i * record], &c[i], sizeof(std::int32_t));
+  const strided_view<const millimeters<std::int32_t>> strided(records.data(), record, n);
+  const strided_view<const std::int32_t> strided_counts(records.data(), record, n);
+  distance_array<meters<double>> out(n);
+  distance_array<millimeters<std::int32_t>> out_i(n);
+  const linear_calibration<> cal { 0.001, 4500.0 };
+
+  r.run("distance_cast_n/strided/i32-f64/" + size, n, record + sizeof(meters<double>), [&] {
+    distance_cast_n<meters<double>>(strided, out.data());
+    do_not_optimize(out.data()[n - 1]);
+  });
+  r.run("calibrated_cast_n/contiguous/i32-f64/" + size, n, sizeof(std::int32_t) + sizeof(meters<double>), [&] {
+    calibrated_cast_n(c.data(), n, cal, out.data());
+    do_not_optimize(out.data()[n - 1]);
+  });
+  r.run("calibrated_cast_n/contiguous/i32-i32/" + size, n, 2 * sizeof(std::int32_t), [&] {
+    calibrated_cast_n(c.data(), n, cal, out_i.data());
+    do_not_optimize(out_i.data()[n - 1]);
+  });
+  r.run("calibrated_cast_n/strided/i32-f64/" + size, n, record + sizeof(meters<double>), [&] {
+    calibrated_cast_n(strided_counts, cal, out.data());
+    do_not_optimize(out.data()[n - 1]);
+  });
+  const fixed_bins<millimeters<std::int32_t>> bins(meters<int>(-100), centimeters<int>(10), 2000);
+  std::vector<std::uint64_t> counts(bins.bins() + 2);
+  r.run("histogram_n/strided/i32/" + size, n, record, [&] {
+    histogram_n(strided, bins, counts.data());
+    do_not_optimize(counts[1]);
+  });
+}
+
+/* Dead reckoning: differentiation of odometer readings and integration of the velocities. */
+void kinematics(bench::runner& r, std::size_t n, const std::string& size) {
+  distance_array<millimeters<std::int64_t>> odo;
+  bench::odometer_generator().generate(odo, n);
+  std::vector<std::chrono::milliseconds> t(n);
+  for (std::size_t i = 0; i < n; ++i) t[i] = std::chrono::milliseconds(100 * static_cast<std::int64_t>(i));
+  std::vector<millimeters_per_second<std::int64_t>> v(n);
+  distance_array<millimeters<std::int64_t>> x(n);
+  const std::size_t record = sizeof(std::chrono::milliseconds) + 2 * sizeof(std::int64_t);
+
+  r.run("differentiate/i64/" + size, n, record, [&] {
+    differentiate(t.data(), odo.data(), n, v.data());
+    do_not_optimize(v[n - 1]);
+  });
+  r.run("integrate_trapezoid/i64/" + size, n, record, [&] {
+    integrate_trapezoid(t.data(), v.data(), n, x.data());
+    do_not_optimize(x.data()[n - 1]);
+  });
+  r.run("integrate_simpson/i64/" + size, n, 2 * sizeof(std::int64_t), [&] {
+    integrate_simpson(v.data(), n, std::chrono::milliseconds(100), x.data());
+    do_not_optimize(x.data()[0]);
+  });
+}
+
+/* As-of lookups and interpolation of random query times in an odometer series. */
+void series_lookups(bench::runner& r, std::size_t n, const std::string& size) {
+  using series = distance_series<millimeters<std::int64_t>>;
+  distance_array<millimeters<std::int64_t>> odo;
+  bench::odometer_generator().generate(odo, n);
+  series s;
+  s.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+    s.push_back(series::time_point(std::chrono::milliseconds(100 * static_cast<std::int64_t>(i))), odo.data()[i]);
+  const std::size_t m = std::size_t(1) << 16;
+  bench::workload_rng rng;
+  std::vector<series::time_point> q(m);
+  for (series::time_point& t : q)
+    t = series::time_point(std::chrono::milliseconds(static_cast<std::int64_t>(rng.uniform(0.0, 100.0 * n))));
+  std::vector<std::size_t> idx(m);
+  std::vector<millimeters<std::int64_t>> out(m);
+
+  r.run("series/std::upper_bound/" + size, m, sizeof(series::time_point), [&] {
+    for (std::size_t k = 0; k < m; ++k)
+      idx[k] = static_cast<std::size_t>(std::upper_bound(s.times(), s.times() + n, q[k]) - s.times()) - 1;
+    do_not_optimize(idx[m - 1]);
+  });
+  r.run("series/as_of_n/" + size, m, sizeof(series::time_point), [&] {
+    s.as_of_n(q.data(), m, idx.data());
+    do_not_optimize(idx[m - 1]);
+  });
+  r.run("series/interpolate_n/" + size, m, 2 * sizeof(series::time_point) + 2 * sizeof(std::int64_t), [&] {
+    s.interpolate_n(q.data(), m, out.data());
+    do_not_optimize(out[m - 1]);
+  });
+}
+
+/* Round-trip times of LiDAR echoes to ranges: double multiply and cast vs. folded conversion. */
+void time_of_flight(bench::runner& r, std::size_t n, const std::string& size) {
+  distance_array<millimeters<std::int64_t>> ranges;
+  bench::lidar_generator().generate(ranges, n);
+  std::vector<std::chrono::nanoseconds> t(n);
+  for (std::size_t i = 0; i < n; ++i) t[i] = std::chrono::nanoseconds(ranges.data()[i].count() * 1000 / 149896);
+  distance_array<millimeters<std::int32_t>> out(n);
+  distance_array<millimeters<double>> out_f(n);
+  const std::size_t bytes = sizeof(std::chrono::nanoseconds) + sizeof(std::int32_t);
+
+  r.run("tof/multiply-cast/i64-i32/" + size, n, bytes, [&] {
+    for (std::size_t i = 0; i < n; ++i)
+      out.data()[i] = distance_cast<millimeters<std::int32_t>>(meters<double>(t[i].count() * 1e-9 * 299792458.0 / 2));
+    do_not_optimize(out.data()[n - 1]);
+  });
+  r.run("tof_distance_n/i64-i32/" + size, n, bytes, [&] {
+    tof_distance_n<millimeters<std::int32_t>>(t.data(), n, out.data());
+    do_not_optimize(out.data()[n - 1]);
+  });
+  r.run("tof_distance_n/i64-f64/" + size, n, sizeof(std::chrono::nanoseconds) + sizeof(double), [&] {
+    tof_distance_n<millimeters<double>>(t.data(), n, out_f.data());
+    do_not_optimize(out_f.data()[n - 1]);
+  });
+}
+
+/*
+ * Group by range bucket: node-based std::unordered_map vs. flat distance_aggregate;
+ * 10 cm buckets keep the table in the caches, 1 cm buckets do not.
+ */
+void group_by(bench::runner& r, std::size_t n, const std::string& size, std::int64_t bucket_cm) {
+  distance_array<millimeters<std::int32_t>> ranges;
+  bench::lidar_generator().generate(ranges, n);
+  const centimeters<std::int64_t> step(bucket_cm);
+  const std::string suffix = std::to_string(bucket_cm) + "cm/" + size;
+  struct agg { std::size_t count; std::int64_t sum; std::int32_t min, max; };
+
+  r.run("group_by/std::unordered_map/" + suffix, n, sizeof(std::int32_t), [&] {
+    const distance_quantizer<centimeters<std::int64_t>> q(step);
+    std::unordered_map<std::int64_t, agg> m;
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::int32_t v = ranges.data()[i].count();
+      const std::int64_t k = q(ranges.data()[i]);
+      auto it = m.find(k);
+      if (it == m.end()) it = m.emplace(k, agg { 0, 0, v, v }).first;
+      agg& g = it->second;
+      ++g.count;
+      g.sum += v;
+      g.min = std::min(g.min, v);
+      g.max = std::max(g.max, v);
+    }
+    do_not_optimize(m.size());
+  });
+  r.run("group_by/distance_aggregate::add/" + suffix, n, sizeof(std::int32_t), [&] {
+    distance_aggregate<millimeters<std::int32_t>, centimeters<std::int64_t>> a(step);
+    for (std::size_t i = 0; i < n; ++i) a.add(ranges.data()[i]);
+    do_not_optimize(a.size());
+  });
+  r.run("group_by/distance_aggregate::add_n/" + suffix, n, sizeof(std::int32_t), [&] {
+    distance_aggregate<millimeters<std::int32_t>, centimeters<std::int64_t>> a(step);
+    a.add_n(ranges.data(), n);
+    do_not_optimize(a.size());
+  });
+}
+
+/* Range histogram with 10 cm bins: per-element division vs. multiply-shift binning. */
+void histograms(bench::runner& r, std::size_t n, const std::string& size) {
+  distance_array<millimeters<std::int32_t>> ranges;
+  bench::lidar_generator().generate(ranges, n);
+  const fixed_bins<millimeters<std::int32_t>> bins(meters<int>(0), centimeters<int>(10), 2000);
+  std::vector<std::uint64_t> counts(bins.bins() + 2);
+
+  r.run("histogram/operator/ /" + size, n, sizeof(std::int32_t), [&] {
+    const millimeters<std::int32_t> origin(0), width(100);
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::int32_t k = (ranges.data()[i] - origin) / width;
+      ++counts[k < 0 ? 0 : k >= 2000 ? 2001 : k + 1];
+    }
+    do_not_optimize(counts[1]);
+  });
+  r.run("histogram/histogram_n/" + size, n, sizeof(std::int32_t), [&] {
+    histogram_n(ranges.data(), n, bins, counts.data());
+    do_not_optimize(counts[1]);
+  });
+  r.run("histogram/parallel_histogram_n/" + size, n, sizeof(std::int32_t), [&] {
+    parallel_histogram_n(ranges.data(), n, bins, counts.data());
+    do_not_optimize(counts[1]);
+  });
+}
+
+/* Route profile with 256 Ki irregular breakpoints at random points: binary search vs. distance_lut. */
+void profile_lookups(bench::runner& r, std::size_t n, const std::string& size) {
+  const std::size_t m = std::size_t(1) << 18;
+  distance_array<meters<double>> x(m), q(n);
+  std::vector<double> y(m), out(n);
+  std::uint64_t s = 0x9e3779b97f4a7c15ull;
+  double t = 0.0;
+  for (std::size_t i = 0; i < m; ++i) {
+    s = s * 6364136223846793005ull + 1442695040888963407ull;
+    x.data()[i] = meters<double>(t += 1.0 + static_cast<double>(s >> 54));
+    y[i] = static_cast<double>(s >> 40 & 0xff);
+  }
+  for (std::size_t i = 0; i < n; ++i) {
+    s = s * 6364136223846793005ull + 1442695040888963407ull;
+    q.data()[i] = meters<double>(static_cast<double>(s >> 11) / 9007199254740992.0 * t);
+  }
+  const distance_lut<meters<double>> lut(x.data(), y.data(), m);
+
+  r.run("lut/std::upper_bound/" + size, n, sizeof(double), [&] {
+    for (std::size_t i = 0; i < n; ++i) {
+      const meters<double>* k = std::upper_bound(x.data(), x.data() + m, q.data()[i]);
+      const std::size_t j = k == x.data() ? 0 : static_cast<std::size_t>(k - x.data()) - 1;
+      out[i] = j + 1 == m ? y[j] : y[j] + (y[j + 1] - y[j]) * ((q.data()[i] - x.data()[j]) / (x.data()[j + 1] - x.data()[j]));
+    }
+    do_not_optimize(out[n - 1]);
+  });
+  r.run("lut/operator()/" + size, n, sizeof(double), [&] {
+    for (std::size_t i = 0; i < n; ++i) out[i] = lut(q.data()[i]);
+    do_not_optimize(out[n - 1]);
+  });
+  r.run("lut/batch/" + size, n, sizeof(double), [&] {
+    lut(q.data(), n, out.data());
+    do_not_optimize(out[n - 1]);
+  });
+}
+
+/* Unit change of a raw micrometer buffer: conversion into a new array vs. in place (toggling units). */
+void unit_changes(bench::runner& r, std::size_t n, const std::string& size) {
+  distance_array<micrometers<std::int64_t>> um;
+  for (std::size_t i = 0; i < n; ++i) um.push_back(micrometers<std::int64_t>(static_cast<std::int64_t>(i * 7919 % 100000000)));
+  distance_array<millimeters<std::int64_t>> mm;
+
+  r.run("unit_change/distance_cast_n+new array/i64/" + size, n, 2 * sizeof(std::int64_t), [&] {
+    distance_array<millimeters<std::int64_t>> out;
+    distance_cast_n<millimeters<std::int64_t>>(um.data(), n, out.append_uninitialized(n));
+    do_not_optimize(out.data()[n - 1]);
+  });
+  r.run("unit_change/convert_in_place/i64/" + size, n, 2 * sizeof(std::int64_t), [&] {
+    if (mm.empty()) mm = convert_in_place<millimeters<std::int64_t>>(std::move(um));
+    else um = convert_in_place<micrometers<std::int64_t>>(std::move(mm));
+  });
+  r.run("unit_change/parallel_convert_in_place/i64/" + size, n, 2 * sizeof(std::int64_t), [&] {
+    if (mm.empty()) mm = parallel_convert_in_place<millimeters<std::int64_t>>(std::move(um));
+    else um = parallel_convert_in_place<micrometers<std::int64_t>>(std::move(mm));
+  });
+}
+
+#if __cplusplus >= 202002L
+/* Sum of ranges in meters: conversion into a temporary vs. lazy views, element-wise and fused. */
+void range_reductions(bench::runner& r, std::size_t n, const std::string& size) {
+  distance_array<millimeters<std::int32_t>> ranges;
+  bench::lidar_generator().generate(ranges, n);
+  std::vector<meters<double>> tmp;
+
+  r.run("sum/std::transform+loop/" + size, n, sizeof(std::int32_t), [&] {
+    tmp.resize(n);
+    std::transform(ranges.begin(), ranges.end(), tmp.begin(),
+                   [](const millimeters<std::int32_t>& d) { return distance_cast<meters<double>>(d); });
+    double s = 0.0;
+    for (const auto& d : tmp) s += d.count();
+    do_not_optimize(s);
+  });
+  r.run("sum/range-for/" + size, n, sizeof(std::int32_t), [&] {
+    double s = 0.0;
+    for (const auto& d : ranges | views::as<meters<double>>) s += d.count();
+    do_not_optimize(s);
+  });
+  r.run("sum/ranges::sum/" + size, n, sizeof(std::int32_t), [&] {
+    do_not_optimize(ranges::sum(ranges | views::as<meters<double>>));
+  });
+}
+#endif
+
+#if defined(METRIC_BENCH_KERNELS)
+/* Compiled kernels of the level selected by `METRIC_KERNELS_ISA` vs. the header-only kernels. */
+void compiled_kernels(bench::runner& r, std::size_t n, const std::string& size) {
+  distance_array<millimeters<std::int32_t>> in;
+  bench::lidar_generator().generate(in, n);
+  distance_array<meters<double>> out(n);
+  const std::string isa = kernels::isa_name(kernels::active_isa());
+
+  r.run("distance_cast_n/i32-f64/" + size, n, sizeof(std::int32_t) + sizeof(double), [&] {
+    distance_cast_n<meters<double>>(in.data(), n, out.data());
+    do_not_optimize(out.data()[n - 1]);
+  });
+  r.run("kernels::cast_n/" + isa + "/i32-f64/" + size, n, sizeof(std::int32_t) + sizeof(double), [&] {
+    kernels::cast_n(in.data(), n, out.data());
+    do_not_optimize(out.data()[n - 1]);
+  });
+  r.run("kernels::sum/" + isa + "/f64/" + size, n, sizeof(double), [&] {
+    do_not_optimize(kernels::sum(out.data(), n));
+  });
+  r.run("kernels::minmax/" + isa + "/i32/" + size, n, sizeof(std::int32_t), [&] {
+    do_not_optimize(kernels::minmax(in.data(), n));
+  });
+}
+#endif
+
+}  // namespace
+
+/*
+ * usage: metric-bench [filter]
+ * Runs all benchmarks whose name contains `filter`, once on cache-resident
+ * (16 Ki elements) and once on memory-resident data (4 Mi elements).
+ */
+int main(int argc, char** argv) {
+  bench::runner r(argc > 1 ? argv[1] : "");
+  distance_cast_specializations(r, std::size_t(1) << 14, "16K");
+  distance_cast_specializations(r, std::size_t(1) << 22, "4M");
+  bulk_kernels(r, std::size_t(1) << 14, "16K");
+  bulk_kernels(r, std::size_t(1) << 22, "4M");
+  kinematics(r, std::size_t(1) << 14, "16K");
+  kinematics(r, std::size_t(1) << 22, "4M");
+  series_lookups(r, std::size_t(1) << 14, "16K");
+  series_lookups(r, std::size_t(1) << 22, "4M");
+  time_of_flight(r, std::size_t(1) << 14, "16K");
+  time_of_flight(r, std::size_t(1) << 22, "4M");
+  group_by(r, std::size_t(1) << 14, "16K", 10);
+  group_by(r, std::size_t(1) << 22, "4M", 10);
+  group_by(r, std::size_t(1) << 14, "16K", 1);
+  group_by(r, std::size_t(1) << 22, "4M", 1);
+  histograms(r, std::size_t(1) << 14, "16K");
+  histograms(r, std::size_t(1) << 22, "4M");
+  profile_lookups(r, std::size_t(1) << 14, "16K");
+  profile_lookups(r, std::size_t(1) << 22, "4M");
+  unit_changes(r, std::size_t(1) << 14, "16K");
+  unit_changes(r, std::size_t(1) << 22, "4M");
+#if __cplusplus >= 202002L
+  range_reductions(r, std::size_t(1) << 14, "16K");
+  range_reductions(r, std::size_t(1) << 22, "4M");
+#endif
+#if defined(METRIC_BENCH_KERNELS)
+  compiled_kernels(r, std::size_t(1) << 14, "16K");
+  compiled_kernels(r, std::size_t(1) << 22, "4M");
+#endif
+  return 0;
+}
@@ -0,0 +1,36 @@
+#!/bin/sh
+# usage: compile_time.sh [compiler] [include dir] [repetitions]
+# Compares preprocessed size and compile time of a translation unit that only
+# includes a metric header, for the umbrella header and the core header.
+# The compiler may be given with flags, e.g. "clang++ -stdlib=libc++". The
+# headers use libc++ internals (std::__is_ratio), so the standard library must
+# be libc++; other toolchains are rejected up front.
+set -e
+CXX=${1:-${CXX:-c++}}
+INCLUDE=${2:-$(dirname "$0")/../include}
+REPS=${3:-20}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+ms() { echo $(( $(date +%s%N) / 1000000 )); }
+
+printf '#include "metric.h"\n' > "$TMP/probe.cpp"
+if ! $CXX -std=c++11 -I"$INCLUDE" -fsyntax-only "$TMP/probe.cpp" 2> /dev/null; then
+  echo "compile_time.sh: $CXX cannot compile the metric headers, which require libc++" >&2
+  echo "  (e.g. compile_time.sh \"clang++ -stdlib=libc++\")" >&2
+  exit 1
+fi
+
+echo "# $($CXX --version | head -n 1)"
+printf '%-16s %12s %14s\n' header "pp lines" "ms/compile"
+for h in metric.h metric_core.h metric_io.h; do
+  printf '#include "%s"\nint main() { return metric::meters<int>(1).count() - 1; }\n' "$h" > "$TMP/tu.cpp"
+  lines=$($CXX -std=c++11 -I"$INCLUDE" -E "$TMP/tu.cpp" | wc -l)
+  start=$(ms)
+  i=0
+  while [ $i -lt "$REPS" ]; do
+    $CXX -std=c++11 -I"$INCLUDE" -fsyntax-only "$TMP/tu.cpp"
+    i=$((i + 1))
+  done
+  printf '%-16s %12d %14s\n' "$h" "$lines" "$(awk "BEGIN { printf \"%.1f\", ($(ms) - $start) / $REPS }")"
+done
@@ -0,0 +1,151 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   perf_counters.h
+ * \brief  Hardware performance counters for the benchmark harness.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Thin wrapper around Linux `perf_event_open`, counting user-space cycles,
+ * instructions, cache misses and branch misses of the calling thread and the
+ * threads it creates, e.g., the workers of the parallel kernels. Linux adds
+ * the counts of such threads when they exit, so they must be joined before
+ * `stop()`. Each counter is opened separately, so counters the PMU (or a
+ * virtual machine) does not provide are skipped individually; on other
+ * systems, or if `METRIC_BENCH_NO_COUNTERS` is set, none are available.
+**/
+
+#ifndef METRIC_BENCH_PERF_COUNTERS_H_
+#define METRIC_BENCH_PERF_COUNTERS_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace metric {
+namespace bench {
+
+/** \brief Hardware counters read around each benchmark. **/
+enum class counter { cycles = 0, instructions, cache_misses, branch_misses };
+
+/** \brief Number of `counter` values. **/
+constexpr int counters = 4;
+
+/**
+ * \brief Set of hardware counters of the calling thread and its child threads.
+ *
+ * Counters are read with multiplexing correction, i.e., scaled by the ratio of
+ * enabled to running time, if the kernel had to time-share the PMU.
+ **/
+class perf_counters {
+ public:
+  perf_counters() {
+    for (int i = 0; i < counters; ++i) fds_[i] = -1;
+#if defined(__linux__)
+    if (std::getenv("METRIC_BENCH_NO_COUNTERS")) return;
+    static const std::uint64_t config[counters] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+    };
+    for (int i = 0; i < counters; ++i) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = config[i];
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.inherit = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+  }
+
+  ~perf_counters() {
+#if defined(__linux__)
+    for (int i = 0; i < counters; ++i)
+      if (fds_[i] >= 0) close(fds_[i]);
+#endif
+  }
+
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  /*! \brief Return true, if counter `c` could be opened. **/
+  bool available(counter c) const noexcept { return fds_[static_cast<int>(c)] >= 0; }
+
+  /*! \brief Return true, if any counter could be opened. **/
+  bool any() const noexcept {
+    for (int i = 0; i < counters; ++i)
+      if (fds_[i] >= 0) return true;
+    return false;
+  }
+
+  /*! \brief Reset and start all available counters. **/
+  void start() noexcept {
+#if defined(__linux__)
+    for (int i = 0; i < counters; ++i)
+      if (fds_[i] >= 0) {
+        // resetting does not clear the counts of exited child threads, so they are subtracted
+        if (read(fds_[i], base_[i], sizeof(base_[i])) != static_cast<ssize_t>(sizeof(base_[i])))
+          std::memset(base_[i], 0, sizeof(base_[i]));
+        ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0);
+      }
+#endif
+  }
+
+  /*! \brief Stop all available counters and latch their values. **/
+  void stop() noexcept {
+#if defined(__linux__)
+    for (int i = 0; i < counters; ++i)
+      if (fds_[i] >= 0) ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+    for (int i = 0; i < counters; ++i) {
+      values_[i] = 0;
+      std::uint64_t v[3];  // value, time enabled, time running
+      if (fds_[i] < 0 || read(fds_[i], v, sizeof(v)) != static_cast<ssize_t>(sizeof(v))) continue;
+      for (int k = 0; k < 3; ++k) v[k] -= base_[i][k];
+      values_[i] = v[2] == 0 ? 0 : v[2] == v[1] ? v[0] :
+          static_cast<std::uint64_t>(static_cast<double>(v[0]) * static_cast<double>(v[1]) /
+                                     static_cast<double>(v[2]));
+    }
+#endif
+  }
+
+  /*! \brief Return value of counter `c` latched by the last `stop()`. **/
+  std::uint64_t operator[](counter c) const noexcept { return values_[static_cast<int>(c)]; }
+
+ private:
+  int fds_[counters];
+  std::uint64_t values_[counters] = {};
+  std::uint64_t base_[counters][3] = {};  // values read by start()
+};
+
+}  // namespace bench
+}  // namespace metric
+
+#endif  // METRIC_BENCH_PERF_COUNTERS_H_
@@ -0,0 +1,53 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include "workload.h"
+
+using namespace metric::bench;
+
+namespace {
+
+/* Parse element count with optional K, M or G (binary) suffix. */
+bool parse_count(const char* s, std::uint64_t& n) {
+  char* end = nullptr;
+  n = std::strtoull(s, &end, 10);
+  if (end == s) return false;
+  switch (*end) {
+    case 'K': n <<= 10; ++end; break;
+    case 'M': n <<= 20; ++end; break;
+    case 'G': n <<= 30; ++end; break;
+    default: break;
+  }
+  return *end == '\0';
+}
+
+}  // namespace
+
+/*
+ * usage: metric-workload <ndjson|csv|las> <count>[K|M|G] <path> [seed]
+ * Writes `count` records (text) or points (LAS) of the synthetic workload;
+ * e.g., `metric-workload las 1G cloud.las` writes a 20 GiB point cloud.
+ */
+int main(int argc, char** argv) {
+  std::uint64_t n = 0, seed = workload_default_seed;
+  if (argc < 4 || !parse_count(argv[2], n) || (argc > 4 && !parse_count(argv[4], seed))) {
+    std::fprintf(stderr, "usage: %s <ndjson|csv|las> <count>[K|M|G] <path> [seed]\n", argv[0]);
+    return 2;
+  }
+  const std::string kind = argv[1];
+  try {
+    if (kind == "ndjson") write_ndjson(argv[3], n, seed);
+    else if (kind == "csv") write_csv(argv[3], n, seed);
+    else if (kind == "las") write_las(argv[3], n, seed);
+    else {
+      std::fprintf(stderr, "%s: unknown workload '%s'\n", argv[0], argv[1]);
+      return 2;
+    }
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,527 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   workload.h
+ * \brief  Deterministic synthetic datasets for the benchmark suite.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Generators model the data the library is used on, rather than uniform
+ * random numbers:
+ *
+ * - `gps_generator`: 1 Hz tracks switching between standing, walking and
+ *   driving, with smooth headings, occasional turns and receiver noise,
+ * - `lidar_generator`: rotating range scans of a street canyon with poles,
+ *   range noise and dropouts,
+ * - `odometer_generator`: monotone 10 Hz odometer readings with stops,
+ * - `point_cloud_generator`: terrain with buildings and vegetation,
+ * - `text_generator`: mixed-unit (m, cm, mm) NDJSON and CSV records.
+ *
+ * Every generator is a stream: successive calls continue the dataset, so files
+ * of any size (see `write_ndjson`, `write_csv` and `write_las`) are written in
+ * blocks of bounded memory. For a given seed, the output is reproducible; only
+ * the last bits of values computed with `std::log`, `std::sin` and `std::cos`
+ * may differ between math libraries.
+**/
+
+#ifndef METRIC_BENCH_WORKLOAD_H_
+#define METRIC_BENCH_WORKLOAD_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "metric_core.h"
+#include "metric_array.h"
+
+namespace metric {
+namespace bench {
+
+/** \brief Default seed of all generators. **/
+constexpr std::uint64_t workload_default_seed = 0x6d657472696331ULL;
+
+/**
+ * \brief xoshiro256** generator, seeded via splitmix64.
+ **/
+class workload_rng {
+ public:
+  explicit workload_rng(std::uint64_t seed = workload_default_seed) noexcept {
+    for (std::uint64_t& s : s_) {
+      seed += 0x9e3779b97f4a7c15ULL;
+      std::uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      s = z ^ (z >> 31);
+    }
+  }
+
+  /*! \brief Return next 64 random bits. **/
+  std::uint64_t operator()() noexcept {
+    const std::uint64_t r = rotl(s_[1] * 5, 7) * 9;
+    const std::uint64_t t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = rotl(s_[3], 45);
+    return r;
+  }
+
+  /*! \brief Return uniform value in [0, 1). **/
+  double uniform() noexcept { return static_cast<double>((*this)() >> 11) * (1.0 / 9007199254740992.0); }
+
+  /*! \brief Return uniform value in [lo, hi). **/
+  double uniform(double lo, double hi) noexcept { return lo + (hi - lo) * uniform(); }
+
+  /*! \brief Return true with probability `p`. **/
+  bool chance(double p) noexcept { return uniform() < p; }
+
+  /*! \brief Return standard normal value (Marsaglia polar method). **/
+  double normal() noexcept {
+    if (has_spare_) {
+      has_spare_ = false;
+      return spare_;
+    }
+    double u, v, s;
+    do {
+      u = uniform(-1.0, 1.0);
+      v = uniform(-1.0, 1.0);
+      s = u * u + v * v;
+    } while (s >= 1.0 || s == 0.0);
+    const double f = std::sqrt(-2.0 * std::log(s) / s);
+    spare_ = v * f;
+    has_spare_ = true;
+    return u * f;
+  }
+
+  /*! \brief Return normal value with mean `mu` and standard deviation `sigma`. **/
+  double normal(double mu, double sigma) noexcept { return mu + sigma * normal(); }
+
+ private:
+  static std::uint64_t rotl(std::uint64_t x, int k) noexcept { return (x << k) | (x >> (64 - k)); }
+
+  std::uint64_t s_[4];
+  double spare_ = 0.0;
+  bool has_spare_ = false;
+};
+
+/* @{ implementation details */
+
+constexpr double __workload_pi = 3.14159265358979323846;
+
+/* Return `m` meters as `Distance`, rounded to nearest for integral representations. */
+template <typename Distance>
+inline Distance __workload_distance(double m) {
+  using R = typename Distance::repr;
+  const double v = m * static_cast<double>(Distance::ratio::den) / static_cast<double>(Distance::ratio::num);
+  return Distance(static_cast<R>(std::is_floating_point<R>::value ? v : std::floor(v + 0.5)));
+}
+
+/* Buffered writer of large files. */
+class __workload_file {
+ public:
+  explicit __workload_file(const std::string& path) : path_(path), f_(std::fopen(path.c_str(), "wb")) {
+    if (!f_) throw std::system_error(errno, std::generic_category(), "metric: cannot create " + path);
+  }
+  ~__workload_file() { if (f_) std::fclose(f_); }
+  __workload_file(const __workload_file&) = delete;
+  __workload_file& operator=(const __workload_file&) = delete;
+
+  void write(const void* p, std::size_t n) {
+    if (n && std::fwrite(p, 1, n, f_) != n)
+      throw std::system_error(errno, std::generic_category(), "metric: cannot write " + path_);
+  }
+  void write(const std::string& s) { write(s.data(), s.size()); }
+  void seek(long off) {
+    if (std::fseek(f_, off, SEEK_SET) != 0)
+      throw std::system_error(errno, std::generic_category(), "metric: cannot seek " + path_);
+  }
+  void close() {
+    std::FILE* f = f_;
+    f_ = nullptr;
+    if (std::fclose(f) != 0)
+      throw std::system_error(errno, std::generic_category(), "metric: cannot write " + path_);
+  }
+
+ private:
+  std::string path_;
+  std::FILE* f_;
+};
+
+/* Number of elements generated per block when writing files. */
+constexpr std::size_t __workload_block = std::size_t(1) << 20;
+
+/* implementation details @} */
+
+/**
+ * \brief GPS tracks in a local metric frame (x east, y north), sampled at 1 Hz.
+ *
+ * The receiver switches between standing, walking and driving with a Markov
+ * chain; headings drift smoothly with occasional right-angle turns, and every
+ * fix carries normal noise of 2.5 m. Steps are thus mostly small, with rare
+ * large jumps, like recorded tracks.
+ **/
+class gps_generator {
+ public:
+  explicit gps_generator(std::uint64_t seed = workload_default_seed) : rng_(seed) {}
+
+  /*! \brief Append `n` fixes to `out`. **/
+  template <typename Distance, std::size_t Dims, typename Alloc>
+  void generate(point_array<Distance, Dims, Alloc>& out, std::size_t n) {
+    static_assert(Dims >= 2, "GPS tracks require two coordinates");
+    const std::size_t base = out.size();
+    out.append_uninitialized(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      step();
+      out.column(0)[base + i] = __workload_distance<Distance>(x_ + rng_.normal(0.0, 2.5));
+      out.column(1)[base + i] = __workload_distance<Distance>(y_ + rng_.normal(0.0, 2.5));
+      for (std::size_t d = 2; d < Dims; ++d) out.column(d)[base + i] = __workload_distance<Distance>(0.0);
+    }
+  }
+
+  /*! \brief Advance by one second and return the true position in meters. **/
+  void step(double* x = nullptr, double* y = nullptr) {
+    static const double cruise[] = { 0.0, 1.4, 13.9 };  // m/s: standing, walking, driving
+    if (rng_.chance(0.002)) mode_ = static_cast<int>(rng_() % 3);
+    if (mode_ == 2 && rng_.chance(0.01)) mode_ = 0;    // traffic light
+    else if (mode_ == 0 && rng_.chance(0.05)) mode_ = 2;
+    speed_ += 0.2 * (cruise[mode_] - speed_) + (mode_ ? rng_.normal(0.0, 0.1 * cruise[mode_]) : 0.0);
+    if (speed_ < 0.0) speed_ = 0.0;
+    heading_ += rng_.normal(0.0, 0.02);
+    if (mode_ && rng_.chance(0.005)) heading_ += rng_.chance(0.5) ? __workload_pi / 2 : -__workload_pi / 2;
+    x_ += speed_ * std::cos(heading_);
+    y_ += speed_ * std::sin(heading_);
+    if (x) *x = x_;
+    if (y) *y = y_;
+  }
+
+  /*! \brief Return current speed in m/s. **/
+  double speed() const noexcept { return speed_; }
+
+ private:
+  workload_rng rng_;
+  int mode_ = 2;
+  double x_ = 0.0, y_ = 0.0, heading_ = 0.0, speed_ = 0.0;
+};
+
+/**
+ * \brief Range scans of a rotating LiDAR driving through a street canyon.
+ *
+ * Each revolution has `beams` ranges of the walls of a street (10 to 30 m
+ * wide), with poles occluding some beams, 2 cm range noise and 2% dropouts.
+ * Beams without return (dropouts and beyond 120 m) are reported as zero.
+ **/
+class lidar_generator {
+ public:
+  explicit lidar_generator(std::uint64_t seed = workload_default_seed, std::size_t beams = 2048)
+    : rng_(seed), beams_(beams) { revolution(); }
+
+  /*! \brief Append `n` ranges to `out`. **/
+  template <typename Distance, typename Alloc>
+  void generate(distance_array<Distance, Alloc>& out, std::size_t n) {
+    Distance* p = out.append_uninitialized(n);
+    for (std::size_t i = 0; i < n; ++i) p[i] = __workload_distance<Distance>(next());
+  }
+
+  /*! \brief Return next range in meters (zero for dropouts). **/
+  double next() {
+    if (beam_ == beams_) revolution();
+    const double a = 2.0 * __workload_pi * static_cast<double>(beam_++) / static_cast<double>(beams_);
+    if (rng_.chance(0.02)) return 0.0;
+    const double c = std::cos(a), s = std::sin(a);
+    // distance to the walls at y = left / -right, limited by the maximum range
+    double r = 120.0;
+    if (s > 1e-9) r = std::min(r, left_ / s);
+    if (s < -1e-9) r = std::min(r, -right_ / s);
+    if (std::fabs(c) > 0.9 && pole_ > 0.0) r = std::min(r, pole_ / std::fabs(c));
+    if (r >= 120.0) return 0.0;  // along the street: no return
+    return std::max(0.5, r + rng_.normal(0.0, 0.02));
+  }
+
+ private:
+  void revolution() {
+    beam_ = 0;
+    left_ = rng_.uniform(5.0, 15.0);
+    right_ = rng_.uniform(5.0, 15.0);
+    pole_ = rng_.chance(0.3) ? rng_.uniform(2.0, 60.0) : 0.0;
+  }
+
+  workload_rng rng_;
+  std::size_t beams_;
+  std::size_t beam_ = 0;
+  double left_ = 0.0, right_ = 0.0, pole_ = 0.0;
+};
+
+/**
+ * \brief Monotone odometer readings, sampled at 10 Hz, of a vehicle in traffic.
+ *
+ * Readings never decrease; stops produce runs of equal values.
+ **/
+class odometer_generator {
+ public:
+  explicit odometer_generator(std::uint64_t seed = workload_default_seed) : gps_(seed) {}
+
+  /*! \brief Append `n` readings to `out`. **/
+  template <typename Distance, typename Alloc>
+  void generate(distance_array<Distance, Alloc>& out, std::size_t n) {
+    Distance* p = out.append_uninitialized(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      if (tick_++ % 10 == 0) gps_.step();
+      total_ += gps_.speed() * 0.1;
+      p[i] = __workload_distance<Distance>(total_);
+    }
+  }
+
+ private:
+  gps_generator gps_;
+  std::uint64_t tick_ = 0;
+  double total_ = 0.0;
+};
+
+/**
+ * \brief Airborne point cloud of a 1 km x 1 km tile: terrain, buildings, trees.
+ **/
+class point_cloud_generator {
+ public:
+  explicit point_cloud_generator(std::uint64_t seed = workload_default_seed) : rng_(seed) {
+    for (building& b : buildings_) {
+      b.x = rng_.uniform(0.0, 1000.0);
+      b.y = rng_.uniform(0.0, 1000.0);
+      b.w = rng_.uniform(8.0, 40.0);
+      b.d = rng_.uniform(8.0, 40.0);
+      b.h = rng_.uniform(3.0, 30.0);
+    }
+  }
+
+  /*! \brief Append `n` points to `out`. **/
+  template <typename Distance, std::size_t Dims, typename Alloc>
+  void generate(point_array<Distance, Dims, Alloc>& out, std::size_t n) {
+    static_assert(Dims >= 3, "point clouds require three coordinates");
+    const std::size_t base = out.size();
+    out.append_uninitialized(n);
+    double xyz[3];
+    for (std::size_t i = 0; i < n; ++i) {
+      next(xyz);
+      for (std::size_t d = 0; d < 3; ++d) out.column(d)[base + i] = __workload_distance<Distance>(xyz[d]);
+      for (std::size_t d = 3; d < Dims; ++d) out.column(d)[base + i] = __workload_distance<Distance>(0.0);
+    }
+  }
+
+  /*! \brief Return next point in meters; returns classification (2 ground, 5 vegetation, 6 building). **/
+  int next(double* xyz) {
+    const double x = rng_.uniform(0.0, 1000.0);
+    const double y = rng_.uniform(0.0, 1000.0);
+    double z = 120.0 + 8.0 * std::sin(x / 170.0) * std::cos(y / 230.0) + 2.0 * std::sin(x / 37.0 + y / 53.0);
+    int cls = 2;
+    for (const building& b : buildings_)
+      if (x >= b.x && x < b.x + b.w && y >= b.y && y < b.y + b.d) {
+        z += b.h;
+        cls = 6;
+        break;
+      }
+    if (cls == 2 && rng_.chance(0.15)) {
+      z += rng_.uniform(0.0, 18.0);
+      cls = 5;
+    }
+    xyz[0] = x;
+    xyz[1] = y;
+    xyz[2] = z + rng_.normal(0.0, 0.05);
+    return cls;
+  }
+
+ private:
+  struct building { double x, y, w, d, h; };
+  workload_rng rng_;
+  building buildings_[200];
+};
+
+/**
+ * \brief Mixed-unit text records of LiDAR and GPS measurements.
+ *
+ * Fields are `id`, `range_m` (meters, 3 decimals), `offset_cm` (integral
+ * centimeters), `height_mm` (integral millimeters) and `source` (a string).
+ **/
+class text_generator {
+ public:
+  explicit text_generator(std::uint64_t seed = workload_default_seed)
+    : lidar_(seed), rng_(seed ^ 0x5bd1e995ULL) {}
+
+  /*! \brief Append `n` NDJSON records to `out`. **/
+  void ndjson(std::string& out, std::size_t n) {
+    char buf[160];
+    for (std::size_t i = 0; i < n; ++i) {
+      double range, offset, height;
+      const char* source = next(range, offset, height);
+      const int len = std::snprintf(buf, sizeof(buf),
+          "{\"id\":%llu,\"range_m\":%.3f,\"offset_cm\":%.0f,\"source\":\"%s\",\"height_mm\":%.0f}\n",
+          static_cast<unsigned long long>(id_++), range, offset, source, height);
+      out.append(buf, static_cast<std::size_t>(len));
+    }
+  }
+
+  /*! \brief Return header line of the CSV records. **/
+  static const char* csv_header() noexcept { return "id,range_m,offset_cm,height_mm,source\n"; }
+
+  /*! \brief Append `n` CSV records (without header) to `out`. **/
+  void csv(std::string& out, std::size_t n) {
+    char buf[128];
+    for (std::size_t i = 0; i < n; ++i) {
+      double range, offset, height;
+      const char* source = next(range, offset, height);
+      const int len = std::snprintf(buf, sizeof(buf), "%llu,%.3f,%.0f,%.0f,%s\n",
+          static_cast<unsigned long long>(id_++), range, offset, height, source);
+      out.append(buf, static_cast<std::size_t>(len));
+    }
+  }
+
+ private:
+  const char* next(double& range, double& offset, double& height) {
+    static const char* sources[] = { "lidar", "lidar", "lidar", "gps" };
+    range = lidar_.next();
+    offset = std::floor(rng_.normal(0.0, 40.0) + 0.5);
+    height = std::floor(rng_.normal(1800.0, 250.0) + 0.5);
+    return sources[rng_() % 4];
+  }
+
+  lidar_generator lidar_;
+  workload_rng rng_;
+  std::uint64_t id_ = 0;
+};
+
+/* @{ file output */
+
+/**
+ * \brief Write `records` NDJSON records of a `text_generator` to `path`.
+ * \throws std::system_error if the file cannot be written.
+ **/
+inline void write_ndjson(const std::string& path, std::uint64_t records,
+                         std::uint64_t seed = workload_default_seed) {
+  __workload_file f(path);
+  text_generator gen(seed);
+  std::string buf;
+  for (std::uint64_t done = 0; done < records; done += __workload_block) {
+    buf.clear();
+    gen.ndjson(buf, static_cast<std::size_t>(std::min<std::uint64_t>(__workload_block, records - done)));
+    f.write(buf);
+  }
+  f.close();
+}
+
+/**
+ * \brief Write `records` CSV records (plus header) of a `text_generator` to `path`.
+ * \throws std::system_error if the file cannot be written.
+ **/
+inline void write_csv(const std::string& path, std::uint64_t records,
+                      std::uint64_t seed = workload_default_seed) {
+  __workload_file f(path);
+  text_generator gen(seed);
+  std::string buf = text_generator::csv_header();
+  for (std::uint64_t done = 0; done < records; done += __workload_block) {
+    gen.csv(buf, static_cast<std::size_t>(std::min<std::uint64_t>(__workload_block, records - done)));
+    f.write(buf);
+    buf.clear();
+  }
+  f.write(buf);
+  f.close();
+}
+
+/**
+ * \brief Write `points` points of a `point_cloud_generator` to `path` as LAS 1.2.
+ *
+ * Uses point data format 0 with millimeter resolution; 20 bytes per point.
+ *
+ * \throws std::invalid_argument if `points` exceeds the LAS 1.2 limit of 2^32 - 1.
+ * \throws std::system_error if the file cannot be written.
+ **/
+inline void write_las(const std::string& path, std::uint64_t points,
+                      std::uint64_t seed = workload_default_seed) {
+  if (points > std::numeric_limits<std::uint32_t>::max())
+    throw std::invalid_argument("metric: LAS 1.2 files hold at most 2^32 - 1 points");
+  constexpr std::size_t header = 227, record = 20;
+  unsigned char h[header] = {};
+  auto put = [&h](std::size_t off, const void* v, std::size_t n) { std::memcpy(h + off, v, n); };
+  __workload_file f(path);
+  f.write(h, header);  // placeholder until bounds are known
+
+  point_cloud_generator gen(seed);
+  double lo[3], hi[3];
+  for (int a = 0; a < 3; ++a) {
+    lo[a] = std::numeric_limits<double>::max();
+    hi[a] = std::numeric_limits<double>::lowest();
+  }
+  std::string buf;
+  for (std::uint64_t done = 0; done < points; done += __workload_block) {
+    const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(__workload_block, points - done));
+    buf.assign(n * record, '\0');
+    for (std::size_t i = 0; i < n; ++i) {
+      double xyz[3];
+      const std::uint8_t cls = static_cast<std::uint8_t>(gen.next(xyz));
+      char* r = &buf[i * record];
+      for (int a = 0; a < 3; ++a) {
+        const std::int32_t c = static_cast<std::int32_t>(std::floor(xyz[a] * 1000.0 + 0.5));
+        std::memcpy(r + 4 * a, &c, sizeof(c));
+        lo[a] = std::min(lo[a], c * 0.001);
+        hi[a] = std::max(hi[a], c * 0.001);
+      }
+      r[15] = static_cast<char>(cls);
+    }
+    f.write(buf);
+  }
+
+  const std::uint8_t version[2] = { 1, 2 };
+  const std::uint16_t header_size = header, record_length = record;
+  const std::uint32_t offset = header, count = static_cast<std::uint32_t>(points);
+  const std::uint8_t format = 0;
+  const double scale = 0.001, zero = 0.0;
+  put(0, "LASF", 4);
+  put(24, version, 2);
+  std::memcpy(h + 26, "metric synthetic workload", 25);
+  put(94, &header_size, 2);
+  put(96, &offset, 4);
+  put(104, &format, 1);
+  put(105, &record_length, 2);
+  put(107, &count, 4);
+  for (int a = 0; a < 3; ++a) {
+    put(131 + 8 * a, &scale, 8);
+    put(155 + 8 * a, &zero, 8);
+    const double mx = points ? hi[a] : 0.0, mn = points ? lo[a] : 0.0;
+    put(179 + 16 * a, &mx, 8);
+    put(187 + 16 * a, &mn, 8);
+  }
+  f.seek(0);
+  f.write(h, header);
+  f.close();
+}
+
+/* file output @} */
+
+}  // namespace bench
+}  // namespace metric
+
+#endif  // METRIC_BENCH_WORKLOAD_H_
@@ -0,0 +1,494 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_array.h
+ * \brief  Contiguous containers for distances and points.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Arrays can change their unit without a second buffer: `convert_in_place`
+ * converts the elements within the storage of the array and returns it as an
+ * array of the new type, as long as the new representation is not wider:
+ *
+ * ~~~{.cpp}
+ * metric::distance_array<metric::micrometers<int64_t>> raw = ...;
+ * auto mm = metric::convert_in_place<metric::millimeters<int32_t>>(std::move(raw));
+ * ~~~
+**/
+
+#ifndef METRIC_METRIC_ARRAY_H_
+#define METRIC_METRIC_ARRAY_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "metric_core.h"
+#include "metric_bulk.h"
+#include "metric_view.h"
+
+namespace metric {
+
+/* @{ distance_array */
+
+template <typename Distance, typename Alloc>
+class distance_array;
+
+template <typename To, typename From, typename Alloc, typename F>
+distance_array<To, typename std::allocator_traits<Alloc>::template rebind_alloc<To>>
+__convert_in_place(distance_array<From, Alloc>&& a, F convert);
+
+/**
+ * \brief Contiguous, growable array of `distance` values.
+ *
+ * `distance_array` behaves like a `std::vector` restricted to (trivially
+ * copyable) distances, which allows it to relocate with `std::memcpy` and to
+ * grow without initializing the new elements (`append_uninitialized`), so bulk
+ * decoders can write their results directly into it.
+ *
+ * \tparam Distance `distance` type of the elements.
+ * \tparam Alloc Allocator type.
+ **/
+template <typename Distance, typename Alloc = std::allocator<Distance>>
+class distance_array {
+  static_assert(is_distance<Distance>::value, "distance_array requires a distance type");
+  static_assert(std::is_trivially_copyable<Distance>::value, "distance_array requires trivially copyable distances");
+
+  using alloc_traits = std::allocator_traits<Alloc>;
+
+ public:
+  using value_type = Distance;                  ///< \brief Element type.
+  using allocator_type = Alloc;                 ///< \brief Allocator type.
+  using size_type = std::size_t;                ///< \brief Size type.
+  using difference_type = std::ptrdiff_t;       ///< \brief Difference type.
+  using reference = Distance&;                  ///< \brief Element reference.
+  using const_reference = const Distance&;      ///< \brief Element const reference.
+  using pointer = Distance*;                    ///< \brief Element pointer.
+  using const_pointer = const Distance*;        ///< \brief Element const pointer.
+  using iterator = Distance*;                   ///< \brief Iterator type.
+  using const_iterator = const Distance*;       ///< \brief Const iterator type.
+
+  /*! \brief Construct empty array. **/
+  distance_array() noexcept(noexcept(Alloc())) : distance_array(Alloc()) {}
+
+  /*! \brief Construct empty array using allocator `a`. **/
+  explicit distance_array(const Alloc& a) noexcept
+    : alloc_(a), data_(nullptr), size_(0), capacity_(0) {}
+
+  /*! \brief Construct array of `n` zero distances. **/
+  explicit distance_array(size_type n, const Alloc& a = Alloc()) : distance_array(a) {
+    resize(n);
+  }
+
+  /*! \brief Construct array of `n` copies of `v`. **/
+  distance_array(size_type n, const Distance& v, const Alloc& a = Alloc()) : distance_array(a) {
+    resize(n, v);
+  }
+
+  /*! \brief Construct array from initializer list. **/
+  distance_array(std::initializer_list<Distance> il, const Alloc& a = Alloc()) : distance_array(a) {
+    assign(il.begin(), il.size());
+  }
+
+  /*! \brief Copy constructor. **/
+  distance_array(const distance_array& other)
+    : distance_array(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+    assign(other.data_, other.size_);
+  }
+
+  /*! \brief Move constructor. **/
+  distance_array(distance_array&& other) noexcept
+    : alloc_(std::move(other.alloc_)), data_(other.data_), size_(other.size_),
+      capacity_(other.capacity_) {
+    other.data_ = nullptr;
+    other.size_ = other.capacity_ = 0;
+  }
+
+  /*! \brief Copy assignment. **/
+  distance_array& operator=(const distance_array& other) {
+    if (this != &other) assign(other.data_, other.size_);
+    return *this;
+  }
+
+  /*! \brief Move assignment. **/
+  distance_array& operator=(distance_array&& other) noexcept {
+    if (this != &other) {
+      deallocate();
+      alloc_ = std::move(other.alloc_);
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = nullptr;
+      other.size_ = other.capacity_ = 0;
+    }
+    return *this;
+  }
+
+  ~distance_array() { deallocate(); }
+
+  /*! \brief Replace contents by `n` elements starting at `first`. **/
+  void assign(const Distance* first, size_type n) {
+    size_ = 0;
+    reserve(n);
+    if (n) std::memcpy(static_cast<void*>(data_), first, n * sizeof(Distance));
+    size_ = n;
+  }
+
+  /*! \brief Return allocator. **/
+  allocator_type get_allocator() const noexcept { return alloc_; }
+
+  /*! \brief Return pointer to first element. **/
+  pointer data() noexcept { return data_; }
+  /*! \brief Return pointer to first element. **/
+  const_pointer data() const noexcept { return data_; }
+
+  /*! \brief Return number of elements. **/
+  size_type size() const noexcept { return size_; }
+  /*! \brief Return number of elements that fit without reallocation. **/
+  size_type capacity() const noexcept { return capacity_; }
+  /*! \brief Return true, iff. the array has no elements. **/
+  bool empty() const noexcept { return size_ == 0; }
+
+  /*! \brief Return iterator to first element. **/
+  iterator begin() noexcept { return data_; }
+  /*! \brief Return iterator past the last element. **/
+  iterator end() noexcept { return data_ + size_; }
+  /*! \brief Return iterator to first element. **/
+  const_iterator begin() const noexcept { return data_; }
+  /*! \brief Return iterator past the last element. **/
+  const_iterator end() const noexcept { return data_ + size_; }
+
+  /*! \brief Return `i`-th element. **/
+  reference operator[](size_type i) noexcept { return data_[i]; }
+  /*! \brief Return `i`-th element. **/
+  const_reference operator[](size_type i) const noexcept { return data_[i]; }
+
+  /*! \brief Return `i`-th element. \throws std::out_of_range if `i >= size()`. **/
+  reference at(size_type i) {
+    if (i >= size_) throw std::out_of_range("metric: distance_array index out of range");
+    return data_[i];
+  }
+  /*! \brief Return `i`-th element. \throws std::out_of_range if `i >= size()`. **/
+  const_reference at(size_type i) const {
+    if (i >= size_) throw std::out_of_range("metric: distance_array index out of range");
+    return data_[i];
+  }
+
+  /*! \brief Return first element. **/
+  reference front() noexcept { return data_[0]; }
+  /*! \brief Return first element. **/
+  const_reference front() const noexcept { return data_[0]; }
+  /*! \brief Return last element. **/
+  reference back() noexcept { return data_[size_ - 1]; }
+  /*! \brief Return last element. **/
+  const_reference back() const noexcept { return data_[size_ - 1]; }
+
+  /*! \brief Return read-only strided view of all elements. **/
+  strided_distance_view<const Distance> view() const noexcept {
+    return strided_distance_view<const Distance>(data_, size_);
+  }
+
+  /*! \brief Return mutable strided view of all elements. **/
+  strided_distance_view<Distance> view() noexcept {
+    return strided_distance_view<Distance>(data_, size_);
+  }
+
+  /*! \brief Ensure capacity for at least `n` elements. **/
+  void reserve(size_type n) {
+    if (n > capacity_) reallocate(n);
+  }
+
+  /*! \brief Release unused capacity. **/
+  void shrink_to_fit() {
+    if (capacity_ > size_) reallocate(size_);
+  }
+
+  /*! \brief Resize to `n` elements; new elements are zero. **/
+  void resize(size_type n) { resize(n, Distance::zero()); }
+
+  /*! \brief Resize to `n` elements; new elements are copies of `v`. **/
+  void resize(size_type n, const Distance& v) {
+    if (n > size_) {
+      const Distance x = v;  // `v` may refer to an element, which growing frees
+      pointer p = append_uninitialized(n - size_);
+      std::fill(p, data_ + n, x);
+    }
+    size_ = n;
+  }
+
+  /*!
+   * \brief Append `n` elements with indeterminate values.
+   * \return Pointer to the first appended element.
+   **/
+  pointer append_uninitialized(size_type n) {
+    if (size_ + n > capacity_) reallocate(std::max(size_ + n, 2 * capacity_));
+    pointer p = data_ + size_;
+    size_ += n;
+    return p;
+  }
+
+  /*! \brief Append `v`. **/
+  void push_back(const Distance& v) {
+    const Distance x = v;  // `v` may refer to an element, which growing frees
+    if (size_ == capacity_) reallocate(capacity_ ? 2 * capacity_ : 8);
+    data_[size_++] = x;
+  }
+
+  /*! \brief Remove last element. **/
+  void pop_back() noexcept { --size_; }
+
+  /*! \brief Remove all elements (capacity is retained). **/
+  void clear() noexcept { size_ = 0; }
+
+  /*! \brief Swap contents with `other`. **/
+  void swap(distance_array& other) noexcept {
+    using std::swap;
+    swap(alloc_, other.alloc_);
+    swap(data_, other.data_);
+    swap(size_, other.size_);
+    swap(capacity_, other.capacity_);
+  }
+
+ private:
+  template <typename To, typename From, typename A, typename F>
+  friend distance_array<To, typename std::allocator_traits<A>::template rebind_alloc<To>>
+  __convert_in_place(distance_array<From, A>&& a, F convert);
+
+  /* Take ownership of storage for `capacity` elements allocated by `a`. */
+  distance_array(const Alloc& a, pointer data, size_type size, size_type capacity) noexcept
+    : alloc_(a), data_(data), size_(size), capacity_(capacity) {}
+
+  void reallocate(size_type n) {
+    pointer p = n ? alloc_traits::allocate(alloc_, n) : nullptr;
+    if (size_) std::memcpy(static_cast<void*>(p), data_, size_ * sizeof(Distance));
+    deallocate();
+    data_ = p;
+    capacity_ = n;
+  }
+
+  void deallocate() noexcept {
+    if (data_) alloc_traits::deallocate(alloc_, data_, capacity_);
+    data_ = nullptr;
+    capacity_ = 0;
+  }
+
+  Alloc alloc_;
+  pointer data_;
+  size_type size_;
+  size_type capacity_;
+};
+
+/**
+ * \brief Element-wise equality of two distance arrays (cf. `distance` equality).
+ **/
+template <typename D1, typename A1, typename D2, typename A2>
+bool operator==(const distance_array<D1, A1>& lhs, const distance_array<D2, A2>& rhs) {
+  if (lhs.size() != rhs.size()) return false;
+  for (std::size_t i = 0; i < lhs.size(); ++i)
+    if (lhs[i] != rhs[i]) return false;
+  return true;
+}
+
+/**
+ * \brief Element-wise inequality of two distance arrays.
+ **/
+template <typename D1, typename A1, typename D2, typename A2>
+bool operator!=(const distance_array<D1, A1>& lhs, const distance_array<D2, A2>& rhs) {
+  return !(lhs == rhs);
+}
+
+/* distance_array @} */
+
+/* @{ in-place conversion */
+
+/*
+ * Hand the storage of `a` to an array of `To` after `convert(p, n)` replaced
+ * the `n` elements at `p` by the bytes of their conversions.
+ */
+template <typename To, typename From, typename Alloc, typename F>
+distance_array<To, typename std::allocator_traits<Alloc>::template rebind_alloc<To>>
+__convert_in_place(distance_array<From, Alloc>&& a, F convert) {
+  static_assert(is_distance<To>::value, "convert_in_place requires a distance type");
+  static_assert(sizeof(To) <= sizeof(From) && sizeof(From) % sizeof(To) == 0 && alignof(To) <= alignof(From),
+                "convert_in_place cannot widen the elements; use distance_cast_n into a new array");
+  using ToAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<To>;
+  From* p = a.data_;
+  const std::size_t n = a.size_;
+  distance_array<To, ToAlloc> r(ToAlloc(a.alloc_), reinterpret_cast<To*>(p), n,
+                                a.capacity_ * (sizeof(From) / sizeof(To)));
+  a.data_ = nullptr;
+  a.size_ = a.capacity_ = 0;
+  if (n) convert(p, n);
+  return r;
+}
+
+namespace {  // anonymous namespace for in-place conversion helpers
+
+/*
+ * Convert the `e - b` elements starting at `p[b]` and store them to `out`,
+ * which may overlap the input as long as it does not lie behind `p + b`.
+ * Narrowing conversions go through a block on the stack.
+ */
+template <typename To, typename From>
+inline void __convert_compact(From* p, std::size_t b, std::size_t e, unsigned char* out) noexcept {
+  if (sizeof(To) == sizeof(From)) {
+    distance_cast_n<To>(p + b, e - b, reinterpret_cast<To*>(out));
+    return;
+  }
+  constexpr std::size_t block = __strided_block_bytes / sizeof(To);
+  To buf[block];
+  for (std::size_t i = b; i < e; i += block) {
+    const std::size_t m = e - i < block ? e - i : block;
+    distance_cast_n<To>(p + i, m, buf);
+    std::memcpy(out + (i - b) * sizeof(To), buf, m * sizeof(To));
+  }
+}
+
+}  // namespace
+
+/**
+ * \brief Convert all elements of `a` to `To` within its storage and return it
+ *        as an array of `To`.
+ *
+ * `To` must not be larger than the element type of `a` (nor require stricter
+ * alignment): elements of the same size are converted in place, narrower ones
+ * are compacted towards the front. Nothing is allocated, the capacity in bytes
+ * is retained. The allocator of `a` is rebound to `To` and must accept the
+ * storage back as the same number of bytes of `To`, which holds for
+ * `std::allocator` and `tracking_allocator`.
+ *
+ * \tparam To `distance` type to convert to.
+ * \param a Array to convert; empty afterwards.
+ * \return Array of the converted elements.
+ **/
+template <typename To, typename From, typename Alloc>
+inline distance_array<To, typename std::allocator_traits<Alloc>::template rebind_alloc<To>>
+convert_in_place(distance_array<From, Alloc>&& a) {
+  return __convert_in_place<To>(std::move(a), [](From* p, std::size_t n) {
+    __convert_compact<To>(p, 0, n, reinterpret_cast<unsigned char*>(p));
+  });
+}
+
+/* in-place conversion @} */
+
+/* @{ point_array */
+
+/**
+ * \brief Structure-of-arrays storage for points with `Dims` distance coordinates.
+ *
+ * Each coordinate is stored in its own `distance_array`, so that the columns
+ * can be handed to bulk kernels without de-interleaving.
+ *
+ * \tparam Distance `distance` type of the coordinates.
+ * \tparam Dims Number of coordinates per point.
+ * \tparam Alloc Allocator type of the columns.
+ **/
+template <typename Distance, std::size_t Dims = 2, typename Alloc = std::allocator<Distance>>
+class point_array {
+  static_assert(Dims > 0, "point_array requires at least one dimension");
+
+ public:
+  using distance_type = Distance;                           ///< \brief Coordinate type.
+  using column_type = distance_array<Distance, Alloc>;      ///< \brief Column type.
+  using size_type = std::size_t;                            ///< \brief Size type.
+  static constexpr std::size_t dimensions = Dims;           ///< \brief Coordinates per point.
+
+  /*! \brief Construct empty point array. **/
+  point_array() = default;
+
+  /*! \brief Construct empty point array using allocator `a` for all columns. **/
+  explicit point_array(const Alloc& a) {
+    for (std::size_t d = 0; d < Dims; ++d) columns_[d] = column_type(a);
+  }
+
+  /*! \brief Return number of points. **/
+  size_type size() const noexcept { return columns_[0].size(); }
+
+  /*! \brief Return true, iff. there are no points. **/
+  bool empty() const noexcept { return columns_[0].empty(); }
+
+  /*! \brief Return column of `d`-th coordinate. **/
+  column_type& column(std::size_t d) noexcept { return columns_[d]; }
+  /*! \brief Return column of `d`-th coordinate. **/
+  const column_type& column(std::size_t d) const noexcept { return columns_[d]; }
+
+  /*! \brief Return column of first coordinate. **/
+  column_type& x() noexcept { return columns_[0]; }
+  /*! \brief Return column of first coordinate. **/
+  const column_type& x() const noexcept { return columns_[0]; }
+
+  /*! \brief Return column of second coordinate. **/
+  column_type& y() noexcept { static_assert(Dims > 1, "point_array has no y"); return columns_[1]; }
+  /*! \brief Return column of second coordinate. **/
+  const column_type& y() const noexcept { static_assert(Dims > 1, "point_array has no y"); return columns_[1]; }
+
+  /*! \brief Return column of third coordinate. **/
+  column_type& z() noexcept { static_assert(Dims > 2, "point_array has no z"); return columns_[2]; }
+  /*! \brief Return column of third coordinate. **/
+  const column_type& z() const noexcept { static_assert(Dims > 2, "point_array has no z"); return columns_[2]; }
+
+  /*! \brief Ensure capacity for at least `n` points. **/
+  void reserve(size_type n) {
+    for (std::size_t d = 0; d < Dims; ++d) columns_[d].reserve(n);
+  }
+
+  /*! \brief Resize to `n` points; new coordinates are zero. **/
+  void resize(size_type n) {
+    for (std::size_t d = 0; d < Dims; ++d) columns_[d].resize(n);
+  }
+
+  /*! \brief Append `n` points with indeterminate coordinates. **/
+  void append_uninitialized(size_type n) {
+    for (std::size_t d = 0; d < Dims; ++d) columns_[d].append_uninitialized(n);
+  }
+
+  /*! \brief Append point with given coordinates. **/
+  void push_back(std::initializer_list<Distance> p) {
+    if (p.size() != Dims) throw std::invalid_argument("metric: point has wrong number of coordinates");
+    std::size_t d = 0;
+    for (const Distance& c : p) columns_[d++].push_back(c);
+  }
+
+  /*! \brief Remove all points. **/
+  void clear() noexcept {
+    for (std::size_t d = 0; d < Dims; ++d) columns_[d].clear();
+  }
+
+  /*! \brief Release unused capacity of all columns. **/
+  void shrink_to_fit() {
+    for (std::size_t d = 0; d < Dims; ++d) columns_[d].shrink_to_fit();
+  }
+
+ private:
+  column_type columns_[Dims];
+};
+
+template <typename Distance, std::size_t Dims, typename Alloc>
+constexpr std::size_t point_array<Distance, Dims, Alloc>::dimensions;
+
+/* point_array @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_ARRAY_H_
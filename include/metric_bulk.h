@@ -0,0 +1,220 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_bulk.h
+ * \brief  Bulk conversion kernels over arrays of distances.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * The kernels in this header are plain loops over contiguous memory with all
+ * unit ratios folded at compile-time, so that the compiler can vectorize them.
+ * Strided inputs (see `strided_view`) are accepted as well; they are forwarded
+ * to the contiguous loops whenever the data allows.
+**/
+
+#ifndef METRIC_METRIC_BULK_H_
+#define METRIC_METRIC_BULK_H_
+
+#include <cstddef>
+#include <cstring>
+#include <ratio>
+#include <type_traits>
+
+#include "metric_core.h"
+#include "metric_view.h"
+
+namespace metric {
+
+/* @{ distance_cast_n */
+
+namespace {  // anonymous namespace for lane helpers
+
+/* True, if distances of `Repr` should be processed as distances of their `simd_lane` type. */
+template <typename Repr>
+struct __use_lane : std::integral_constant<bool,
+  !std::is_void<typename simd_lane<Repr>::type>::value &&
+  !std::is_same<typename simd_lane<Repr>::type, Repr>::value> {};
+
+template <class ToDistance, class FromDistance>
+inline void __distance_cast_n(const FromDistance* first, std::size_t n, ToDistance* out, std::false_type) {
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = distance_cast<ToDistance>(first[i]);
+}
+
+/* Elements are copied through their lane types, which compilers lower to plain vector loads and stores. */
+template <class ToDistance, class FromDistance>
+inline void __distance_cast_n(const FromDistance* first, std::size_t n, ToDistance* out, std::true_type) {
+  using FromLane = typename simd_lane<typename FromDistance::repr>::type;
+  using ToLane = typename simd_lane<typename ToDistance::repr>::type;
+  static_assert(sizeof(FromLane) == sizeof(FromDistance) && sizeof(ToLane) == sizeof(ToDistance),
+                "simd_lane type must have the size of the representation");
+  for (std::size_t i = 0; i < n; ++i) {
+    FromLane x;
+    std::memcpy(&x, static_cast<const void*>(first + i), sizeof(x));
+    const ToLane y = distance_cast<distance<ToLane, typename ToDistance::ratio>>(
+      distance<FromLane, typename FromDistance::ratio>(x)).count();
+    std::memcpy(static_cast<void*>(out + i), &y, sizeof(y));
+  }
+}
+
+}  // namespace
+
+/**
+ * \brief Cast `n` distances starting at `first` to `ToDistance` and store them to `out`.
+ *
+ * User-defined representations with a `simd_lane` type are processed as
+ * distances of their lane types, i.e., with the loops of the built-in types.
+ *
+ * \tparam ToDistance `distance` type to cast to.
+ * \tparam Repr Unit value representative of the input.
+ * \tparam Ratio Ratio of the input.
+ * \param first Pointer to first input element.
+ * \param n Number of elements.
+ * \param out Pointer to first output element; may alias `first` iff. both types
+ *            have the same size.
+ **/
+template <class ToDistance, class Repr, class Ratio>
+inline typename std::enable_if<is_distance<ToDistance>::value>::type
+distance_cast_n(const distance<Repr, Ratio>* first, std::size_t n, ToDistance* out) {
+  using ToRepr = typename ToDistance::repr;
+  using lanes = std::integral_constant<bool,
+    (__use_lane<Repr>::value || __use_lane<ToRepr>::value) &&
+    !std::is_void<typename simd_lane<Repr>::type>::value &&
+    !std::is_void<typename simd_lane<ToRepr>::type>::value>;
+  __distance_cast_n(first, n, out, lanes());
+}
+
+/**
+ * \brief Cast all distances in `in` to `ToDistance` and store them to `out`.
+ * \tparam ToDistance `distance` type to cast to.
+ * \tparam FromDistance `distance` type of the input (may be `const`).
+ * \param in View of input elements.
+ * \param out Pointer to first output element.
+ **/
+template <class ToDistance, class FromDistance>
+inline typename std::enable_if<is_distance<ToDistance>::value && is_distance<FromDistance>::value>::type
+distance_cast_n(strided_view<FromDistance> in, ToDistance* out) {
+  using From = typename std::remove_cv<FromDistance>::type;
+  if (in.is_contiguous()) {
+    distance_cast_n<ToDistance>(reinterpret_cast<const From*>(in.data()), in.size(), out);
+  } else {
+    for (std::size_t i = 0; i < in.size(); ++i)
+      out[i] = distance_cast<ToDistance>(in[i]);
+  }
+}
+
+/* distance_cast_n @} */
+
+/* @{ calibrated conversion */
+
+/**
+ * \brief Affine relation between raw sensor or file counts and distances.
+ *
+ * A raw count `c` denotes the distance `c * scale + offset` in units of `Ratio`,
+ * i.e., `linear_calibration` is a `distance` with a runtime ratio and an origin.
+ *
+ * \tparam Ratio `std::ratio` of the unit `scale` and `offset` are given in.
+ **/
+template <typename Ratio = std::ratio<1>>
+struct linear_calibration {
+  static_assert(std::__is_ratio<Ratio>::value, "template parameter of linear_calibration must be std::ratio");
+  using ratio = Ratio;  ///< \brief Unit of `scale` and `offset`.
+  double scale;         ///< \brief Length of one count.
+  double offset;        ///< \brief Distance of count zero from the origin.
+};
+
+namespace {  // anonymous namespace for calibration helpers
+
+template <typename Repr, bool = treat_as_floating_point<Repr>::value>
+struct __calibrated_round {
+  inline Repr operator()(double v) const { return static_cast<Repr>(v); }
+};
+
+template <typename Repr>
+struct __calibrated_round<Repr, false> {
+  inline Repr operator()(double v) const {
+    return static_cast<Repr>(v < 0.0 ? v - 0.5 : v + 0.5);
+  }
+};
+
+template <typename FromRatio, typename ToRatio>
+inline constexpr double __calibrated_factor() {
+  using R = typename std::ratio_divide<FromRatio, ToRatio>::type;
+  return static_cast<double>(R::num) / static_cast<double>(R::den);
+}
+
+}  // namespace
+
+/**
+ * \brief Convert `n` raw counts starting at `first` to `ToDistance` using `cal`.
+ *
+ * The unit conversion is folded into the calibration once, so every element
+ * costs a single fused multiply-add (and rounding for integral `ToDistance`).
+ *
+ * \tparam ToDistance `distance` type to convert to.
+ * \tparam Count Type of raw counts.
+ * \tparam Ratio Unit of the calibration.
+ * \param first Pointer to first raw count.
+ * \param n Number of elements.
+ * \param cal Calibration of the counts.
+ * \param out Pointer to first output element.
+ **/
+template <class ToDistance, class Count, class Ratio>
+inline typename std::enable_if<is_distance<ToDistance>::value>::type
+calibrated_cast_n(const Count* first, std::size_t n, const linear_calibration<Ratio>& cal,
+                  ToDistance* out) {
+  using ToRepr = typename ToDistance::repr;
+  constexpr double f = __calibrated_factor<Ratio, typename ToDistance::ratio>();
+  const double s = cal.scale * f;
+  const double o = cal.offset * f;
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = ToDistance(__calibrated_round<ToRepr>()(static_cast<double>(first[i]) * s + o));
+}
+
+/**
+ * \brief Convert all raw counts in `in` to `ToDistance` using `cal`.
+ * \tparam ToDistance `distance` type to convert to.
+ * \tparam Count Type of raw counts (may be `const`).
+ * \tparam Ratio Unit of the calibration.
+ * \param in View of raw counts.
+ * \param cal Calibration of the counts.
+ * \param out Pointer to first output element.
+ **/
+template <class ToDistance, class Count, class Ratio>
+inline typename std::enable_if<is_distance<ToDistance>::value>::type
+calibrated_cast_n(strided_view<Count> in, const linear_calibration<Ratio>& cal,
+                  ToDistance* out) {
+  using C = typename std::remove_cv<Count>::type;
+  if (in.is_contiguous()) {
+    calibrated_cast_n(reinterpret_cast<const C*>(in.data()), in.size(), cal, out);
+  } else {
+    using ToRepr = typename ToDistance::repr;
+    constexpr double f = __calibrated_factor<Ratio, typename ToDistance::ratio>();
+    const double s = cal.scale * f;
+    const double o = cal.offset * f;
+    for (std::size_t i = 0; i < in.size(); ++i)
+      out[i] = ToDistance(__calibrated_round<ToRepr>()(static_cast<double>(in[i]) * s + o));
+  }
+}
+
+/* calibrated conversion @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_BULK_H_
@@ -0,0 +1,277 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_conversions.h
+ * \brief  Instrumentation counting non-identity `distance_cast` conversions.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * When `METRIC_COUNT_CONVERSIONS` is defined (CMake option of the same name),
+ * `metric_core.h` includes this header and every `distance_cast` which
+ * rescales, including the ones performed implicitly by the mixed-unit
+ * operators, is counted per pair of (representation, ratio) of source and
+ * target type. With C++20 `std::source_location` the casts are also counted per
+ * call site, taken from a defaulted argument of `distance_cast`.
+ *
+ * Operators cannot take such an argument, so conversions inside the mixed-unit
+ * operators (`+`, `-`, `==`, `<`, ...) are attributed to the operator in
+ * `metric_core.h`, not to the expression that calls it; only the function name
+ * of the site tells the operand types. To find these implicit conversions in
+ * your code, look up the type pairs in the report, or cast the operands
+ * explicitly with `distance_cast`, which is then recorded at its call site.
+ *
+ * A report sorted by count is written to `stderr` at exit, or to the file named
+ * by the environment variable `METRIC_CONVERSION_REPORT`. Without the macro the
+ * instrumentation compiles to nothing.
+**/
+
+#ifndef METRIC_METRIC_CONVERSIONS_H_
+#define METRIC_METRIC_CONVERSIONS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ratio>
+#include <string>
+#include <tuple>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#define _METRIC_HAS_CXXABI 1
+#endif
+#if __cplusplus >= 202002L && __has_include(<source_location>)
+#include <source_location>
+#if defined(__cpp_lib_source_location)
+#define _METRIC_HAS_SOURCE_LOCATION 1
+#endif
+#endif
+#endif
+
+namespace metric {
+
+/** \brief Number of conversions between a pair of types, or at one call site. **/
+struct conversion_record {
+  std::string from;         ///< \brief Source type, e.g., "long long 1/1000 m".
+  std::string to;           ///< \brief Target type.
+  std::string site;         ///< \brief "file:line:column function" (per-site records only).
+  std::uint64_t count;      ///< \brief Number of conversions.
+};
+
+/* @{ implementation details */
+
+struct __conversion_pair {
+  std::string from;
+  std::string to;
+  std::atomic<std::uint64_t> count;
+};
+
+struct __conversion_site {
+  std::string name;  // "file:line:column function"
+  const __conversion_pair* pair;
+  std::atomic<std::uint64_t> count;
+};
+
+using __conversion_site_key = std::tuple<const char*, unsigned, unsigned, const __conversion_pair*>;
+
+struct __conversion_registry {
+  std::mutex mutex;
+  std::deque<__conversion_pair> pairs;   // stable addresses
+  std::deque<__conversion_site> sites;   // stable addresses
+  std::map<__conversion_site_key, __conversion_site*> site_index;
+};
+
+inline std::string __conversion_type_name(const std::type_info& t) {
+#if defined(_METRIC_HAS_CXXABI)
+  int status = 0;
+  char* s = abi::__cxa_demangle(t.name(), nullptr, nullptr, &status);
+  if (s) {
+    std::string r(s);
+    std::free(s);
+    return r;
+  }
+#endif
+  return t.name();
+}
+
+template <typename Distance>
+inline std::string __conversion_distance_name() {
+  return __conversion_type_name(typeid(typename Distance::repr)) + " " +
+         std::to_string(Distance::ratio::num) + "/" + std::to_string(Distance::ratio::den) + " m";
+}
+
+void print_conversion_report(std::FILE* out);
+
+inline void __conversion_report_at_exit() {
+  const char* path = std::getenv("METRIC_CONVERSION_REPORT");
+  std::FILE* f = path ? std::fopen(path, "w") : nullptr;
+  print_conversion_report(f ? f : stderr);
+  if (f) std::fclose(f);
+}
+
+inline __conversion_registry& __conversion_registry_instance() {
+  // intentionally leaked: conversions may still happen during static destruction
+  static __conversion_registry* r = [] {
+    std::atexit(__conversion_report_at_exit);
+    return new __conversion_registry();
+  }();
+  return *r;
+}
+
+template <typename FromDistance, typename ToDistance>
+inline __conversion_pair& __conversion_pair_instance() {
+  static __conversion_pair& p = [] () -> __conversion_pair& {
+    __conversion_registry& r = __conversion_registry_instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.pairs.emplace_back();
+    r.pairs.back().from = __conversion_distance_name<FromDistance>();
+    r.pairs.back().to = __conversion_distance_name<ToDistance>();
+    r.pairs.back().count = 0;
+    return r.pairs.back();
+  }();
+  return p;
+}
+
+/* Count conversion from `FromDistance` to `ToDistance`, iff. it rescales. */
+template <typename FromDistance, typename ToDistance>
+inline void __count_conversion() {
+  using R = typename std::ratio_divide<typename FromDistance::ratio, typename ToDistance::ratio>::type;
+  if (R::num == 1 && R::den == 1) return;
+  __conversion_pair_instance<FromDistance, ToDistance>().count.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if defined(_METRIC_HAS_SOURCE_LOCATION)
+/*
+ * Return counter of conversions of pair `p` at `site`. Sites are registered
+ * once under the registry lock; afterwards each thread finds them in its own
+ * cache, so that counting takes no lock.
+ */
+inline __conversion_site& __conversion_site_instance(const std::source_location& site, const __conversion_pair& p) {
+  struct cache {
+    __conversion_site_key last_key;
+    __conversion_site* last = nullptr;
+    std::map<__conversion_site_key, __conversion_site*> sites;
+  };
+  thread_local cache c;
+  const __conversion_site_key key(site.file_name(), static_cast<unsigned>(site.line()),
+                                  static_cast<unsigned>(site.column()), &p);
+  if (c.last && c.last_key == key) return *c.last;
+  __conversion_site*& s = c.sites[key];
+  if (!s) {
+    __conversion_registry& r = __conversion_registry_instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    __conversion_site*& g = r.site_index[key];
+    if (!g) {
+      r.sites.emplace_back();
+      g = &r.sites.back();
+      g->name = std::string(site.file_name()) + ":" + std::to_string(site.line()) + ":" +
+                std::to_string(site.column()) + " " + site.function_name();
+      g->pair = &p;
+      g->count = 0;
+    }
+    s = g;
+  }
+  c.last_key = key;
+  c.last = s;
+  return *s;
+}
+
+/* Count conversion from `FromDistance` to `ToDistance` at `site`, iff. it rescales. */
+template <typename FromDistance, typename ToDistance>
+inline void __count_conversion(const std::source_location& site) {
+  using R = typename std::ratio_divide<typename FromDistance::ratio, typename ToDistance::ratio>::type;
+  if (R::num == 1 && R::den == 1) return;
+  __conversion_pair& p = __conversion_pair_instance<FromDistance, ToDistance>();
+  p.count.fetch_add(1, std::memory_order_relaxed);
+  __conversion_site_instance(site, p).count.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+/* implementation details @} */
+
+/**
+ * \brief Return conversion counts per pair of types, sorted by decreasing count.
+ **/
+inline std::vector<conversion_record> conversion_counts() {
+  __conversion_registry& r = __conversion_registry_instance();
+  std::vector<conversion_record> v;
+  {
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const __conversion_pair& p : r.pairs)
+      if (p.count.load(std::memory_order_relaxed))
+        v.push_back(conversion_record { p.from, p.to, std::string(), p.count.load(std::memory_order_relaxed) });
+  }
+  std::stable_sort(v.begin(), v.end(), [](const conversion_record& a, const conversion_record& b) {
+    return a.count > b.count;
+  });
+  return v;
+}
+
+/**
+ * \brief Return conversion counts per call site, sorted by decreasing count.
+ *
+ * Empty unless compiled as C++20 with `std::source_location`.
+ **/
+inline std::vector<conversion_record> conversion_sites() {
+  __conversion_registry& r = __conversion_registry_instance();
+  std::vector<conversion_record> v;
+  {
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const __conversion_site& s : r.sites)
+      if (s.count.load(std::memory_order_relaxed))
+        v.push_back(conversion_record { s.pair->from, s.pair->to, s.name, s.count.load(std::memory_order_relaxed) });
+  }
+  std::stable_sort(v.begin(), v.end(), [](const conversion_record& a, const conversion_record& b) {
+    return a.count > b.count;
+  });
+  return v;
+}
+
+/** \brief Reset all conversion counts to zero. **/
+inline void reset_conversion_counts() {
+  __conversion_registry& r = __conversion_registry_instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (__conversion_pair& p : r.pairs) p.count.store(0, std::memory_order_relaxed);
+  for (__conversion_site& s : r.sites) s.count.store(0, std::memory_order_relaxed);
+}
+
+/** \brief Write conversion report (per type pair and per call site) to `out`. **/
+inline void print_conversion_report(std::FILE* out) {
+  std::fprintf(out, "metric: distance conversion report\n%20s  %s\n", "count", "from -> to");
+  for (const conversion_record& c : conversion_counts())
+    std::fprintf(out, "%20llu  %s -> %s\n", static_cast<unsigned long long>(c.count),
+                 c.from.c_str(), c.to.c_str());
+  const std::vector<conversion_record> sites = conversion_sites();
+  if (sites.empty()) return;
+  std::fprintf(out, "\n%20s  %s\n", "count", "site: from -> to");
+  for (const conversion_record& c : sites)
+    std::fprintf(out, "%20llu  %s: %s -> %s\n", static_cast<unsigned long long>(c.count),
+                 c.site.c_str(), c.from.c_str(), c.to.c_str());
+}
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_CONVERSIONS_H_
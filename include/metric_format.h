@@ -0,0 +1,356 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_format.h
+ * \brief  Formatting of metric distances, experimental `std::format` support.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Provides `format_distance` and, experimentally, `std::formatter<metric::distance<Repr, Ratio>>`
+ * with the format specification
+ *
+ *     [[fill]align][#][width][.precision][unit]
+ *
+ * - `align` is one of `<`, `>` (default) or `^`, `fill` any character but `{`
+ *   and `}`,
+ * - `#` omits the unit symbol,
+ * - `precision` gives the number of fractional digits (fixed notation); it
+ *   requires a floating-point representation or a unit,
+ * - `unit` is one of `nm`, `um`, `mm`, `cm`, `dm`, `m`, `km`, `Mm` to convert
+ *   to that unit, or `a` to select the unit automatically from the magnitude
+ *   (`nm`, `um`, `mm`, `m`, `km` or `Mm`). Converted values are `double`.
+ *
+ * Without `unit` the output matches the stream operators of metric_io.h:
+ *
+ * ~~~{.cpp}
+ * std::format("{}", metric::millimeters<int>(1500));         // "1500 mm"
+ * std::format("{:.2m}", metric::millimeters<int>(1500));     // "1.50 m"
+ * std::format("{:a}", metric::meters<double>(0.0042));       // "4.2 mm"
+ * std::format("{:>#8.1km}", metric::meters<int>(12345));     // "    12.3"
+ * ~~~
+ *
+ * Specifications are parsed by the constexpr `format_spec::parse`, so invalid
+ * ones are compile-time errors with `std::format`. The digits are produced by
+ * `std::to_chars` into a stack buffer and copied to the output iterator; no
+ * strings or streams are created. `format_distance` exposes the same formatting
+ * for other output iterators, e.g., without `<format>`. Requires C++17.
+ *
+ * The `std::formatter` specialization is experimental: it has not been compiled
+ * by a toolchain with `<format>` yet. Define `METRIC_EXPERIMENTAL_FORMATTER` to
+ * enable it where the standard library provides `<format>`; `format_distance`
+ * is tested and does not depend on it.
+**/
+
+#ifndef METRIC_METRIC_FORMAT_H_
+#define METRIC_METRIC_FORMAT_H_
+
+#if __cplusplus < 201703L
+#error "metric_format.h requires C++17"
+#endif
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <system_error>
+#include <type_traits>
+
+#if defined(METRIC_EXPERIMENTAL_FORMATTER) && __has_include(<format>)
+#include <format>
+#endif
+
+#include "metric_core.h"
+
+namespace metric {
+
+/* @{ format specifications */
+
+/** \brief Unit selection of a `format_spec`. **/
+enum class format_unit : unsigned char {
+  native,     ///< \brief Unit of the distance type (default).
+  automatic,  ///< \brief Unit selected from the magnitude (`a`).
+  nm, um, mm, cm, dm, m, km, Mm,
+};
+
+/** \brief Return the symbol of `u`, or an empty string for `native` and `automatic`. **/
+constexpr const char* format_unit_symbol(format_unit u) noexcept {
+  switch (u) {
+  case format_unit::nm: return "nm";
+  case format_unit::um: return "um";
+  case format_unit::mm: return "mm";
+  case format_unit::cm: return "cm";
+  case format_unit::dm: return "dm";
+  case format_unit::m:  return "m";
+  case format_unit::km: return "km";
+  case format_unit::Mm: return "Mm";
+  default:              return "";
+  }
+}
+
+/**
+ * \brief Parsed format specification of a distance (see metric_format.h).
+ **/
+struct format_spec {
+  static constexpr unsigned max_width = 255;     ///< \brief Largest accepted width.
+  static constexpr int max_precision = 100;      ///< \brief Largest accepted precision.
+
+  char fill = ' ';                               ///< \brief Fill character.
+  char align = '>';                              ///< \brief Alignment: `<`, `>` or `^`.
+  bool bare = false;                             ///< \brief Omit unit symbol (`#`).
+  unsigned width = 0;                            ///< \brief Minimum width.
+  int precision = -1;                            ///< \brief Fractional digits, or -1 for shortest.
+  format_unit unit = format_unit::native;        ///< \brief Unit of the output.
+  const char* error = nullptr;                   ///< \brief Error message of last `parse`, if any.
+
+  /**
+   * \brief Parse specification in `[first, last)` up to the closing `}`.
+   * \param first Iterator to first character after the `:`.
+   * \param last End of the format string.
+   * \param integral True, if the representation is integral (and does not
+   *        accept a precision without unit).
+   * \return Iterator to the closing `}` (or `last`); `error` is set on errors.
+   **/
+  template <typename It>
+  constexpr It parse(It first, It last, bool integral = false) {
+    It it = first;
+    if (it == last || *it == '}') return it;
+    if (last - it >= 2 && __is_align(it[1])) {
+      if (*it == '{' || *it == '}') return fail(it, "metric: invalid fill character in distance format");
+      fill = *it;
+      align = it[1];
+      it += 2;
+    } else if (__is_align(*it)) {
+      align = *it++;
+    }
+    if (it != last && *it == '#') { bare = true; ++it; }
+    while (it != last && *it >= '0' && *it <= '9') {
+      width = width * 10 + static_cast<unsigned>(*it++ - '0');
+      if (width > max_width) return fail(it, "metric: width too large in distance format");
+    }
+    if (it != last && *it == '.') {
+      if (++it == last || *it < '0' || *it > '9') return fail(it, "metric: missing precision in distance format");
+      precision = 0;
+      while (it != last && *it >= '0' && *it <= '9') {
+        precision = precision * 10 + (*it++ - '0');
+        if (precision > max_precision) return fail(it, "metric: precision too large in distance format");
+      }
+    }
+    if (it != last && *it == 'a') {
+      unit = format_unit::automatic;
+      ++it;
+    } else if (it != last && *it != '}') {
+      const auto sym = [&](char c0, char c1) { return *it == c0 && last - it >= 2 && it[1] == c1; };
+      if      (sym('n', 'm')) unit = format_unit::nm;
+      else if (sym('u', 'm')) unit = format_unit::um;
+      else if (sym('m', 'm')) unit = format_unit::mm;
+      else if (sym('c', 'm')) unit = format_unit::cm;
+      else if (sym('d', 'm')) unit = format_unit::dm;
+      else if (sym('k', 'm')) unit = format_unit::km;
+      else if (sym('M', 'm')) unit = format_unit::Mm;
+      it += unit == format_unit::native ? 0 : 2;
+      if (unit == format_unit::native && *it == 'm') { unit = format_unit::m; ++it; }
+    }
+    if (it != last && *it != '}') return fail(it, "metric: invalid distance format specification");
+    if (integral && precision >= 0 && unit == format_unit::native)
+      return fail(it, "metric: precision requires floating-point distance or unit in distance format");
+    return it;
+  }
+
+ private:
+  static constexpr bool __is_align(char c) { return c == '<' || c == '>' || c == '^'; }
+
+  template <typename It>
+  constexpr It fail(It it, const char* msg) {
+    error = msg;
+    return it;
+  }
+};
+
+/* format specifications @} */
+
+namespace {  // anonymous namespace for formatting helpers
+
+/* Buffer for the digits of any `double` with `format_spec::max_precision`. */
+constexpr std::size_t __format_buffer_size = 448;
+
+constexpr std::size_t __format_digits(std::intmax_t v) { return v < 10 ? 1 : 1 + __format_digits(v / 10); }
+
+template <typename Ratio, typename ToRatio>
+constexpr double __format_factor() {
+  using R = typename std::ratio_divide<Ratio, ToRatio>::type;
+  return static_cast<double>(R::num) / static_cast<double>(R::den);
+}
+
+template <typename Ratio>
+constexpr format_unit __native_unit() {
+  return std::ratio_equal<Ratio, std::nano>::value ? format_unit::nm :
+         std::ratio_equal<Ratio, std::micro>::value ? format_unit::um :
+         std::ratio_equal<Ratio, std::milli>::value ? format_unit::mm :
+         std::ratio_equal<Ratio, std::centi>::value ? format_unit::cm :
+         std::ratio_equal<Ratio, std::deci>::value ? format_unit::dm :
+         std::ratio_equal<Ratio, std::ratio<1>>::value ? format_unit::m :
+         std::ratio_equal<Ratio, std::kilo>::value ? format_unit::km :
+         std::ratio_equal<Ratio, std::mega>::value ? format_unit::Mm :
+         format_unit::native;
+}
+
+/* Factor from `Ratio` to unit `u`. */
+template <typename Ratio>
+constexpr double __format_factor(format_unit u) {
+  switch (u) {
+  case format_unit::nm: return __format_factor<Ratio, std::nano>();
+  case format_unit::um: return __format_factor<Ratio, std::micro>();
+  case format_unit::mm: return __format_factor<Ratio, std::milli>();
+  case format_unit::cm: return __format_factor<Ratio, std::centi>();
+  case format_unit::dm: return __format_factor<Ratio, std::deci>();
+  case format_unit::km: return __format_factor<Ratio, std::kilo>();
+  case format_unit::Mm: return __format_factor<Ratio, std::mega>();
+  default:              return __format_factor<Ratio, std::ratio<1>>();
+  }
+}
+
+/* Engineering unit (steps of 1000) of `meters`, so that the value is in [1, 1000) if possible. */
+inline format_unit __automatic_unit(double meters) noexcept {
+  const double a = std::fabs(meters);
+  return a >= 1e6 ? format_unit::Mm : a >= 1e3 ? format_unit::km : a >= 1.0 ? format_unit::m :
+         a >= 1e-3 ? format_unit::mm : a >= 1e-6 ? format_unit::um : a > 0.0 ? format_unit::nm : format_unit::m;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value, char*>::type
+__format_number(char* first, char* last, T v, int) noexcept {
+  return std::to_chars(first, last, v).ptr;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, char*>::type
+__format_number(char* first, char* last, T v, int precision) noexcept {
+  if (precision < 0) return std::to_chars(first, last, v).ptr;
+  const std::to_chars_result r = std::to_chars(first, last, v, std::chars_format::fixed, precision);
+  if (r.ec == std::errc()) return r.ptr;
+  return std::to_chars(first, last, v, std::chars_format::scientific, precision).ptr;
+}
+
+/* Writes the unit suffix " <symbol>", or " <num>/<den> m" if `symbol` is null. */
+template <typename Ratio, typename OutputIt>
+inline OutputIt __format_suffix(OutputIt out, const char* symbol) {
+  *out++ = ' ';
+  if (!symbol) {
+    char r[2 * 20 + 1];
+    char* p = std::to_chars(r, r + 20, Ratio::num).ptr;
+    *p++ = '/';
+    p = std::to_chars(p, p + 20, Ratio::den).ptr;
+    for (const char* c = r; c != p; ++c) *out++ = *c;
+    *out++ = ' ';
+    symbol = "m";
+  }
+  while (*symbol) *out++ = *symbol++;
+  return out;
+}
+
+/* Length of the unit suffix. */
+template <typename Ratio>
+inline std::size_t __format_suffix_size(const char* symbol) noexcept {
+  std::size_t n = 1;
+  if (!symbol) {
+    n += __format_digits(Ratio::num) + 1 + __format_digits(Ratio::den) + 1;
+    symbol = "m";
+  }
+  while (*symbol++) ++n;
+  return n;
+}
+
+template <typename OutputIt>
+inline OutputIt __format_fill(OutputIt out, char fill, std::size_t n) {
+  for (; n; --n) *out++ = fill;
+  return out;
+}
+
+}  // namespace
+
+/* @{ formatting */
+
+/**
+ * \brief Write `d` formatted according to `spec` to `out`.
+ * \tparam OutputIt Output iterator of `char`.
+ * \param out Output iterator.
+ * \param d Distance to format.
+ * \param spec Parsed format specification (see `format_spec`).
+ * \return Iterator past the last written character.
+ **/
+template <typename OutputIt, typename Repr, typename Ratio>
+OutputIt format_distance(OutputIt out, const distance<Repr, Ratio>& d, const format_spec& spec = format_spec()) {
+  static_assert(std::is_arithmetic<Repr>::value, "format_distance requires an arithmetic representation");
+  char buf[__format_buffer_size];
+  char* p;
+  const char* symbol;
+  if (spec.unit == format_unit::native) {
+    p = __format_number(buf, buf + __format_buffer_size, d.count(), spec.precision);
+    constexpr format_unit native = __native_unit<Ratio>();
+    symbol = native != format_unit::native ? format_unit_symbol(native) : nullptr;
+  } else {
+    const format_unit u = spec.unit == format_unit::automatic ?
+      __automatic_unit(static_cast<double>(d.count()) * __format_factor<Ratio, std::ratio<1>>()) : spec.unit;
+    p = __format_number(buf, buf + __format_buffer_size, static_cast<double>(d.count()) * __format_factor<Ratio>(u),
+                        spec.precision);
+    symbol = format_unit_symbol(u);
+  }
+  const std::size_t n = static_cast<std::size_t>(p - buf) + (spec.bare ? 0 : __format_suffix_size<Ratio>(symbol));
+  const std::size_t pad = spec.width > n ? spec.width - n : 0;
+  const std::size_t before = spec.align == '<' ? 0 : spec.align == '^' ? pad / 2 : pad;
+  out = __format_fill(out, spec.fill, before);
+  for (const char* c = buf; c != p; ++c) *out++ = *c;
+  if (!spec.bare) out = __format_suffix<Ratio>(out, symbol);
+  return __format_fill(out, spec.fill, pad - before);
+}
+
+/* formatting @} */
+
+}  // namespace metric
+
+#if defined(METRIC_EXPERIMENTAL_FORMATTER) && defined(__cpp_lib_format)
+
+/* @{ std::formatter */
+
+/**
+ * \brief Specialization of `std::formatter` for `distance` (see metric_format.h);
+ *        experimental, requires `METRIC_EXPERIMENTAL_FORMATTER`.
+ **/
+template <typename Repr, typename Ratio>
+struct std::formatter<metric::distance<Repr, Ratio>, char> {
+  metric::format_spec spec;
+
+  constexpr std::format_parse_context::iterator parse(std::format_parse_context& ctx) {
+    auto it = spec.parse(ctx.begin(), ctx.end(), !metric::treat_as_floating_point<Repr>::value);
+    if (spec.error) throw std::format_error(spec.error);
+    return it;
+  }
+
+  template <typename FormatContext>
+  typename FormatContext::iterator format(const metric::distance<Repr, Ratio>& d, FormatContext& ctx) const {
+    return metric::format_distance(ctx.out(), d, spec);
+  }
+};
+
+/* std::formatter @} */
+
+#endif  // METRIC_EXPERIMENTAL_FORMATTER && __cpp_lib_format
+
+#endif  // METRIC_METRIC_FORMAT_H_
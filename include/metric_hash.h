@@ -0,0 +1,489 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_hash.h
+ * \brief  Unit-normalized hashing and hash aggregation of quantized distances.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Distances of different units compare equal (`5_cm == 50_mm`), so their hash
+ * must not depend on the unit: `hash_value` hashes the distance in whole
+ * nanometers, which is exact for integral representations. Floating-point
+ * distances are rounded to nanometers; as their equality has a tolerance, use
+ * them as keys only after quantization.
+ *
+ * `distance_aggregate` groups distances by bucket (`distance_quantizer`) in a
+ * flat open-addressing table and maintains count, sum, minimum and maximum per
+ * bucket:
+ *
+ * ~~~{.cpp}
+ * metric::distance_aggregate<metric::millimeters<int32_t>> by_range(metric::meters<int64_t>(10));
+ * by_range.add_n(ranges.data(), ranges.size());
+ * for (const auto& g : by_range)
+ *   std::cout << by_range.lower(g.key) << ": " << g.count << std::endl;
+ * ~~~
+**/
+
+#ifndef METRIC_METRIC_HASH_H_
+#define METRIC_METRIC_HASH_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "metric_core.h"
+#include "metric_view.h"
+
+namespace metric {
+
+namespace {  // anonymous namespace for hash helpers
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef __int128 __hash_int128;
+#endif
+
+/* Finalizer of splitmix64: full avalanche with two multiplications, vectorizable. */
+inline std::uint64_t __hash_mix(std::uint64_t x) noexcept {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+/* Saturating conversion of `x` to `int64_t`. */
+inline std::int64_t __hash_clamp(double x) noexcept {
+  return x >= 9223372036854775807.0 ? INT64_MAX : x > -9223372036854775808.0 ? static_cast<std::int64_t>(x) :
+         x < 0.0 ? INT64_MIN : 0;
+}
+
+/* Floor of `count * R` for integral counts, exact (modulo 2^64). */
+template <typename R, typename Repr>
+inline typename std::enable_if<!treat_as_floating_point<Repr>::value && R::den == 1, std::int64_t>::type
+__scaled_floor(Repr count) noexcept {
+  return static_cast<std::int64_t>(static_cast<std::uint64_t>(count) * static_cast<std::uint64_t>(R::num));
+}
+
+template <typename R, typename Repr>
+inline typename std::enable_if<!treat_as_floating_point<Repr>::value && R::den != 1, std::int64_t>::type
+__scaled_floor(Repr count) noexcept {
+#if defined(__SIZEOF_INT128__)
+  const __hash_int128 p = static_cast<__hash_int128>(count) * R::num;
+  const __hash_int128 q = p / R::den;
+  return static_cast<std::int64_t>(p % R::den != 0 && p < 0 ? q - 1 : q);
+#else
+  return __hash_clamp(std::floor(static_cast<long double>(count) * R::num / R::den));
+#endif
+}
+
+/* Count of `d` in whole nanometers (rounded to nearest for floating-point representations). */
+template <typename Repr, typename Ratio>
+inline typename std::enable_if<!treat_as_floating_point<Repr>::value, std::int64_t>::type
+__hash_nanometers(const distance<Repr, Ratio>& d) noexcept {
+  return __scaled_floor<typename std::ratio_divide<Ratio, std::nano>::type>(d.count());
+}
+
+template <typename Repr, typename Ratio>
+inline typename std::enable_if<treat_as_floating_point<Repr>::value, std::int64_t>::type
+__hash_nanometers(const distance<Repr, Ratio>& d) noexcept {
+  using R = typename std::ratio_divide<Ratio, std::nano>::type;
+  return __hash_clamp(std::round(static_cast<double>(d.count()) * (static_cast<double>(R::num) / R::den)));
+}
+
+/* True, if `count * R` is exact in a `double` (at most 2^52 in magnitude) for all counts of `Repr`. */
+template <typename Repr, typename R>
+struct __quotient_in_double : std::integral_constant<bool,
+  std::is_integral<Repr>::value && std::numeric_limits<Repr>::digits <= 32 && R::num <= (std::intmax_t(1) << 20)> {};
+
+/* Floor of `q`, which is at most 2^63 in magnitude. */
+inline std::int64_t __floor_int64(double q) noexcept {
+  const std::int64_t t = static_cast<std::int64_t>(q);
+  return q < static_cast<double>(t) ? t - 1 : t;
+}
+
+/* Floor division by positive `b`. */
+inline std::int64_t __floor_div(std::int64_t a, std::int64_t b) noexcept {
+  const std::int64_t q = a / b;
+  return a % b != 0 && a < 0 ? q - 1 : q;
+}
+
+}  // namespace
+
+/* @{ hashing */
+
+/**
+ * \brief Return unit-normalized hash of `d`.
+ *
+ * Equal distances of integral representations have equal hashes regardless
+ * of their units.
+ **/
+template <typename Repr, typename Ratio>
+inline std::size_t hash_value(const distance<Repr, Ratio>& d) noexcept {
+  return static_cast<std::size_t>(__hash_mix(static_cast<std::uint64_t>(__hash_nanometers(d))));
+}
+
+/**
+ * \brief Store `hash_value` of `n` distances starting at `first` to `out`.
+ * \param first Pointer to first distance.
+ * \param n Number of elements.
+ * \param out Pointer to first hash.
+ **/
+template <typename Repr, typename Ratio>
+inline void hash_n(const distance<Repr, Ratio>* first, std::size_t n, std::size_t* out) noexcept {
+  for (std::size_t i = 0; i < n; ++i) out[i] = hash_value(first[i]);
+}
+
+/*! \brief Store `hash_value` of all distances in `in` to `out`. **/
+template <typename T>
+inline typename std::enable_if<is_distance<typename strided_view<T>::value_type>::value>::type
+hash_n(strided_view<T> in, std::size_t* out) noexcept {
+  for (std::size_t i = 0; i < in.size(); ++i) out[i] = hash_value(in[i]);
+}
+
+/* hashing @} */
+
+/* @{ quantization */
+
+/**
+ * \brief Maps distances to the index of their bucket `[k * step, (k + 1) * step)`.
+ *
+ * Distances with integral representations are quantized exactly (without
+ * floating-point rounding at bucket boundaries), if `Step` is integral, too.
+ *
+ * \tparam Step `distance` type of the bucket width.
+ **/
+template <typename Step>
+class distance_quantizer {
+  static_assert(is_distance<Step>::value, "distance_quantizer requires a distance type");
+
+ public:
+  using step_type = Step;  ///< \brief Type of bucket width.
+
+  /**
+   * \brief Construct quantizer for buckets of width `step`.
+   * \throws std::invalid_argument if `step` is not positive.
+   **/
+  explicit distance_quantizer(const Step& step) : step_(step) {
+    if (!(Step::zero() < step))
+      throw std::invalid_argument("metric: quantization step must be positive");
+  }
+
+  /*! \brief Return bucket width. **/
+  const Step& step() const noexcept { return step_; }
+
+  /*! \brief Return index of the bucket of `d`. **/
+  template <typename Repr, typename Ratio>
+  std::int64_t operator()(const distance<Repr, Ratio>& d) const noexcept {
+    return quantize(d, std::integral_constant<bool,
+      treat_as_floating_point<Repr>::value || treat_as_floating_point<typename Step::repr>::value>());
+  }
+
+  /**
+   * \brief Store the bucket indices of `n` distances starting at `first` to `out`.
+   * \param first Pointer to first distance.
+   * \param n Number of elements.
+   * \param out Pointer to first bucket index.
+   **/
+  template <typename Repr, typename Ratio>
+  void operator()(const distance<Repr, Ratio>* first, std::size_t n, std::int64_t* out) const noexcept {
+    for (std::size_t i = 0; i < n; ++i) out[i] = (*this)(first[i]);
+  }
+
+  /*! \brief Store the bucket indices of all distances in `in` to `out`. **/
+  template <typename T>
+  void operator()(strided_view<T> in, std::int64_t* out) const noexcept {
+    for (std::size_t i = 0; i < in.size(); ++i) out[i] = (*this)(in[i]);
+  }
+
+  /*! \brief Return lower bound of bucket `k`. **/
+  Step lower(std::int64_t k) const { return Step(static_cast<typename Step::repr>(k * step_.count())); }
+
+ private:
+  template <typename Repr, typename Ratio>
+  std::int64_t quantize(const distance<Repr, Ratio>& d, std::false_type) const noexcept {
+    using R = typename std::ratio_divide<Ratio, typename Step::ratio>::type;
+    return quantize_exact<R>(d.count(), __quotient_in_double<Repr, R>());
+  }
+
+  /*
+   * Integer division is slow and does not vectorize, but for dividends and
+   * divisors below 2^53 the correctly rounded `double` quotient has the same
+   * floor as the exact one (the rounding error is smaller than 1 / divisor).
+   */
+  template <typename R, typename Repr>
+  std::int64_t quantize_exact(Repr count, std::true_type) const noexcept {
+    const std::int64_t s = static_cast<std::int64_t>(step_.count());
+    if (s <= (std::int64_t(1) << 53) / R::den)
+      return __floor_int64(static_cast<double>(count) * static_cast<double>(R::num) / static_cast<double>(R::den * s));
+    return quantize_exact<R>(count, std::false_type());
+  }
+
+  template <typename R, typename Repr>
+  std::int64_t quantize_exact(Repr count, std::false_type) const noexcept {
+    return __floor_div(__scaled_floor<R>(count), static_cast<std::int64_t>(step_.count()));
+  }
+
+  template <typename Repr, typename Ratio>
+  std::int64_t quantize(const distance<Repr, Ratio>& d, std::true_type) const noexcept {
+    using R = typename std::ratio_divide<Ratio, typename Step::ratio>::type;
+    return __hash_clamp(std::floor(static_cast<double>(d.count()) * (static_cast<double>(R::num) / R::den) /
+                                   static_cast<double>(step_.count())));
+  }
+
+  Step step_;
+};
+
+/* quantization @} */
+
+/* @{ aggregation */
+
+/**
+ * \brief Hash aggregate of distances grouped by quantized keys.
+ *
+ * Groups are stored densely in order of their first occurrence; the table
+ * itself holds keys and group indices only and is probed linearly at a load
+ * factor of at most 1/2. Once the table outgrows the caches, batches (`add_n`)
+ * quantize and hash a block of keys first and then update the groups,
+ * prefetching the table slots ahead; smaller tables are updated element-wise.
+ *
+ * \tparam Distance `distance` type of the aggregated values.
+ * \tparam Step `distance` type of the bucket width.
+ * \tparam Alloc Allocator.
+ **/
+template <typename Distance, typename Step = Distance, typename Alloc = std::allocator<Distance>>
+class distance_aggregate {
+  static_assert(is_distance<Distance>::value, "distance_aggregate requires a distance type");
+
+ public:
+  using distance_type = Distance;  ///< \brief Type of aggregated values.
+  using size_type = std::size_t;   ///< \brief Size type.
+  /** \brief Type of sums: `double` for floating-point, `intmax_t` for integral representations. **/
+  using sum_type = distance<typename std::conditional<treat_as_floating_point<typename Distance::repr>::value,
+    typename std::common_type<typename Distance::repr, double>::type, std::intmax_t>::type, typename Distance::ratio>;
+
+  /** \brief Aggregates of one bucket. **/
+  struct group {
+    std::int64_t key;  ///< \brief Bucket index (see `distance_quantizer`).
+    size_type count;   ///< \brief Number of values.
+    sum_type sum;      ///< \brief Sum of values.
+    Distance min;      ///< \brief Smallest value.
+    Distance max;      ///< \brief Largest value.
+  };
+
+  using const_iterator = const group*;  ///< \brief Iterator over groups.
+
+  /**
+   * \brief Construct empty aggregate with buckets of width `step`.
+   * \param step Bucket width.
+   * \param groups Expected number of groups.
+   * \param a Allocator.
+   * \throws std::invalid_argument if `step` is not positive.
+   **/
+  explicit distance_aggregate(const Step& step, size_type groups = 0, const Alloc& a = Alloc())
+    : quantizer_(step), slots_(slot_alloc(a)), groups_(group_alloc(a)) {
+    groups_.reserve(groups);
+    rehash(__table_size(groups));
+  }
+
+  /*! \brief Return quantizer of the keys. **/
+  const distance_quantizer<Step>& quantizer() const noexcept { return quantizer_; }
+  /*! \brief Return lower bound of bucket `key`. **/
+  Step lower(std::int64_t key) const { return quantizer_.lower(key); }
+
+  /*! \brief Return number of groups. **/
+  size_type size() const noexcept { return groups_.size(); }
+  /*! \brief Return true, if there are no groups. **/
+  bool empty() const noexcept { return groups_.empty(); }
+  /*! \brief Return iterator to first group. **/
+  const_iterator begin() const noexcept { return groups_.data(); }
+  /*! \brief Return iterator past the last group. **/
+  const_iterator end() const noexcept { return groups_.data() + groups_.size(); }
+
+  /*! \brief Remove all groups. **/
+  void clear() noexcept {
+    groups_.clear();
+    for (slot& s : slots_) s.index = 0;
+  }
+
+  /*! \brief Add `d` to the group of its own bucket. **/
+  void add(const Distance& d) { add(d, d); }
+
+  /*! \brief Add `value` to the group of the bucket of `key`. **/
+  template <typename Repr, typename Ratio>
+  void add(const distance<Repr, Ratio>& key, const Distance& value) {
+    const std::int64_t k = quantizer_(key);
+    update(find_or_insert(k, __slot_hash(k)), value);
+  }
+
+  /*! \brief Add `n` distances starting at `first` to the groups of their own buckets. **/
+  void add_n(const Distance* first, size_type n) { add_n(first, first, n); }
+
+  /**
+   * \brief Add `n` values starting at `values` to the groups of the buckets of `keys`.
+   * \param keys Pointer to first key distance.
+   * \param values Pointer to first value.
+   * \param n Number of elements.
+   **/
+  template <typename Repr, typename Ratio>
+  void add_n(const distance<Repr, Ratio>* keys, const Distance* values, size_type n) {
+    size_type i = 0;
+    for (; i < n && slots_.size() < __batch_slots; ++i) add(keys[i], values[i]);
+    if (i == n) return;
+    std::int64_t k[__block];
+    std::uint64_t h[__block];
+    for (; i < n; i += __block) {
+      const size_type m = n - i < __block ? n - i : size_type(__block);
+      quantizer_(keys + i, m, k);
+      for (size_type j = 0; j < m; ++j) h[j] = __slot_hash(k[j]);
+      for (size_type j = 0; j < m; ++j) {
+#if defined(__GNUC__)
+        if (j + __prefetch_distance < m) __builtin_prefetch(&slots_[h[j + __prefetch_distance] >> shift_]);
+#endif
+        update(find_or_insert(k[j], h[j]), values[i + j]);
+      }
+    }
+  }
+
+  /*! \brief Add all distances in `in` to the groups of their own buckets. **/
+  void add_n(strided_view<const Distance> in) {
+    for_each_block(in, [this](const Distance* block, size_type, size_type m) { add_n(block, block, m); });
+  }
+
+  /**
+   * \brief Add all values in `values` to the groups of the buckets of `keys`.
+   * \param keys View of key distances.
+   * \param values View of values.
+   * \throws std::invalid_argument if `keys` and `values` differ in size.
+   **/
+  template <typename T>
+  void add_n(strided_view<T> keys, strided_view<const Distance> values) {
+    using K = typename strided_view<T>::value_type;
+    if (keys.size() != values.size()) throw std::invalid_argument("metric: add_n requires keys and values of equal size");
+    K k[__block];
+    Distance v[__block];
+    for (size_type i = 0; i < keys.size(); i += __block) {
+      const size_type m = keys.size() - i < __block ? keys.size() - i : size_type(__block);
+      keys.gather(i, m, k);
+      values.gather(i, m, v);
+      add_n(k, v, m);
+    }
+  }
+
+  /*! \brief Return group of bucket `key`, or null. **/
+  const group* find(std::int64_t key) const noexcept {
+    for (size_type s = __slot_hash(key) >> shift_;; s = (s + 1) & mask_) {
+      if (!slots_[s].index) return nullptr;
+      if (slots_[s].key == key) return &groups_[slots_[s].index - 1];
+    }
+  }
+
+  /*! \brief Return group of the bucket of `d`, or null. **/
+  template <typename Repr, typename Ratio>
+  const group* find(const distance<Repr, Ratio>& d) const noexcept { return find(quantizer_(d)); }
+
+ private:
+  struct slot {
+    std::int64_t key;
+    size_type index;  // index of group + 1, 0 if empty
+  };
+
+  using slot_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<slot>;
+  using group_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<group>;
+
+  static constexpr size_type __block = 256;
+
+  /* Fibonacci hashing: the table index is taken from the high bits of the product. */
+  static std::uint64_t __slot_hash(std::int64_t key) noexcept {
+    return static_cast<std::uint64_t>(key) * 0x9e3779b97f4a7c15ull;
+  }
+  static constexpr size_type __prefetch_distance = 8;
+  /* Smallest table for which batches pay off; smaller tables (128 KiB) stay in the caches. */
+  static constexpr size_type __batch_slots = 8192;
+
+  static size_type __table_size(size_type groups) noexcept {
+    size_type n = 16;
+    while (n < 2 * groups) n *= 2;
+    return n;
+  }
+
+  group& find_or_insert(std::int64_t key, std::uint64_t hash) {
+    for (size_type s = hash >> shift_;; s = (s + 1) & mask_) {
+      if (!slots_[s].index) return insert(key, hash, s);
+      if (slots_[s].key == key) return groups_[slots_[s].index - 1];
+    }
+  }
+
+  /* Insert group of `key` into empty slot `s`, or into a new slot after growing the table. */
+  group& insert(std::int64_t key, std::uint64_t hash, size_type s) {
+    if (2 * (groups_.size() + 1) > slots_.size()) {
+      rehash(2 * slots_.size());
+      for (s = hash >> shift_; slots_[s].index; s = (s + 1) & mask_) {}
+    }
+    groups_.push_back(group { key, 0, sum_type::zero(), Distance::max(), Distance::min() });
+    slots_[s].key = key;
+    slots_[s].index = groups_.size();
+    return groups_.back();
+  }
+
+  void rehash(size_type n) {
+    slots_.assign(n, slot { 0, 0 });
+    mask_ = n - 1;
+    shift_ = 64;
+    for (size_type m = n; m > 1; m /= 2) --shift_;
+    for (size_type g = 0; g < groups_.size(); ++g) {
+      size_type s = __slot_hash(groups_[g].key) >> shift_;
+      while (slots_[s].index) s = (s + 1) & mask_;
+      slots_[s].key = groups_[g].key;
+      slots_[s].index = g + 1;
+    }
+  }
+
+  static void update(group& g, const Distance& v) noexcept {
+    ++g.count;
+    g.sum += sum_type(static_cast<typename sum_type::repr>(v.count()));
+    g.min = v < g.min ? v : g.min;
+    g.max = g.max < v ? v : g.max;
+  }
+
+  distance_quantizer<Step> quantizer_;
+  std::vector<slot, slot_alloc> slots_;
+  std::vector<group, group_alloc> groups_;
+  size_type mask_;
+  int shift_;
+};
+
+/* aggregation @} */
+
+}  // namespace metric
+
+/*! @{ Specialization of `std::hash` for `distance` (see `metric::hash_value`). **/
+template <typename Repr, typename Ratio>
+struct std::hash<metric::distance<Repr, Ratio>> {
+  std::size_t operator()(const metric::distance<Repr, Ratio>& d) const noexcept { return metric::hash_value(d); }
+};
+/* @} */
+
+#endif  // METRIC_METRIC_HASH_H_
@@ -0,0 +1,246 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_histogram.h
+ * \brief  Fixed-width binning and histograms of distance arrays.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * `fixed_bins` converts origin and width of the bins to the unit of the
+ * array once. For integral arrays the bin index is then computed with a
+ * single multiply-shift per element, which is exact for all elements (no
+ * division, no rounding at bin boundaries); floating-point arrays use one
+ * multiplication by the reciprocal width.
+ *
+ * Histograms have `bins() + 2` counts: elements below the first bin are counted
+ * in `counts[0]`, those above the last bin in `counts[bins() + 1]`:
+ *
+ * ~~~{.cpp}
+ * metric::fixed_bins<metric::millimeters<int32_t>> bins(0_m, 10_cm, 1000);  // 0 to 100 m
+ * std::vector<uint64_t> counts(bins.bins() + 2);
+ * metric::histogram_n(ranges.data(), ranges.size(), bins, counts.data());
+ * ~~~
+ *
+ * See `parallel_histogram_n` in metric_parallel.h for a multi-threaded version.
+**/
+
+#ifndef METRIC_METRIC_HISTOGRAM_H_
+#define METRIC_METRIC_HISTOGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+
+#include "metric_core.h"
+#include "metric_view.h"
+
+namespace metric {
+
+namespace {  // anonymous namespace for binning helpers
+
+constexpr int __bins_bit_width(std::uint64_t x) { return x ? 1 + __bins_bit_width(x >> 1) : 0; }
+
+constexpr std::uint64_t __bins_gcd(std::uint64_t a, std::uint64_t b) { return b ? __bins_gcd(b, a % b) : a; }
+
+}  // namespace
+
+/* @{ binning */
+
+/**
+ * \brief Fixed-width bins `[origin + k * width, origin + (k + 1) * width)` for
+ *        `k` in `[0, bins)` over arrays of `Distance`.
+ * \tparam Distance `distance` type of the binned elements.
+ **/
+template <typename Distance>
+class fixed_bins {
+  static_assert(is_distance<Distance>::value, "fixed_bins requires a distance type");
+  using repr = typename Distance::repr;
+  using ratio = typename Distance::ratio;
+  using floating = std::integral_constant<bool, treat_as_floating_point<repr>::value>;
+
+ public:
+  /** \brief Type of bin lower bounds (bounds may be fractional in units of `Distance`). **/
+  using bound_type = distance<double, ratio>;
+
+  /**
+   * \brief Construct `bins` bins of width `width` starting at `origin`.
+   *
+   * For integral `Distance` the width must be integral, too, and `origin` is
+   * converted with `distance_cast`.
+   *
+   * \param origin Lower bound of the first bin.
+   * \param width Width of each bin.
+   * \param bins Number of bins.
+   * \throws std::invalid_argument if `width` is not positive or `bins` is 0.
+   * \throws std::domain_error if, for integral `Distance`, the range of the
+   *         bins is too large in units of `Distance` for the multiply-shift
+   *         (more than 2^31 units).
+   **/
+  template <typename ORepr, typename ORatio, typename WRepr, typename WRatio>
+  fixed_bins(const distance<ORepr, ORatio>& origin, const distance<WRepr, WRatio>& width, std::size_t bins)
+    : bins_(bins) {
+    if (!(distance<WRepr, WRatio>::zero() < width) || bins == 0)
+      throw std::invalid_argument("metric: fixed_bins requires positive width and bin count");
+    using R = typename std::ratio_divide<WRatio, ratio>::type;
+    origin_ = static_cast<double>(distance_cast<distance<double, ratio>>(origin).count());
+    width_ = static_cast<double>(width.count()) * static_cast<double>(R::num) / static_cast<double>(R::den);
+    inverse_ = 1.0 / width_;
+    init(origin, width, floating());
+  }
+
+  /*! \brief Return number of bins. **/
+  std::size_t bins() const noexcept { return bins_; }
+  /*! \brief Return width of the bins in units of `Distance`. **/
+  double width() const noexcept { return width_; }
+  /*! \brief Return lower bound of bin `k` (`k == bins()` yields the upper bound of the last bin). **/
+  bound_type lower(std::size_t k) const noexcept { return bound_type(origin_ + static_cast<double>(k) * width_); }
+
+  /**
+   * \brief Return bin of `d` plus 1, i.e., 0 below the first bin and `bins() + 1`
+   *        above the last bin (the index into the counts of a histogram).
+   **/
+  std::size_t operator()(const Distance& d) const noexcept { return index(d.count(), floating()); }
+
+  /**
+   * \brief Store the bins plus 1 of `n` distances starting at `first` to `out` (see above).
+   * \param first Pointer to first distance.
+   * \param n Number of elements.
+   * \param out Pointer to first index.
+   **/
+  void operator()(const Distance* first, std::size_t n, std::size_t* out) const noexcept {
+    for (std::size_t i = 0; i < n; ++i) out[i] = index(first[i].count(), floating());
+  }
+
+  /*! \brief Store the bins plus 1 of all distances in `in` to `out` (see above). **/
+  void operator()(strided_view<const Distance> in, std::size_t* out) const noexcept {
+    for (std::size_t i = 0; i < in.size(); ++i) out[i] = index(in[i].count(), floating());
+  }
+
+ private:
+  template <typename ORepr, typename ORatio, typename WRepr, typename WRatio>
+  void init(const distance<ORepr, ORatio>& origin, const distance<WRepr, WRatio>& width, std::true_type) noexcept {
+    (void)origin;
+    (void)width;
+  }
+
+  /*
+   * The width is p / q units. For v = (x - origin) * q + p, the bin plus 1 is
+   * floor(v / p); with M = ceil(2^S / p), floor(v * M / 2^S) equals floor(v / p)
+   * if v * p < 2^S (the rounding error of M is below 1 / p). x below the origin
+   * is counted below the first bin directly (for widths below one unit v would
+   * not stay in [0, p) there); above, x is clamped such that p <= v < 2^31,
+   * which keeps v * M in 64 bits.
+   */
+  template <typename ORepr, typename ORatio, typename WRepr, typename WRatio>
+  void init(const distance<ORepr, ORatio>& origin, const distance<WRepr, WRatio>& width, std::false_type) {
+    static_assert(!treat_as_floating_point<WRepr>::value, "integral fixed_bins require an integral width");
+    using R = typename std::ratio_divide<WRatio, ratio>::type;
+    const std::uint64_t limit = std::uint64_t(1) << 31;
+    if (static_cast<std::uint64_t>(width.count()) > limit / static_cast<std::uint64_t>(R::num) ||
+        static_cast<std::uint64_t>(R::den) > limit)
+      throw std::domain_error("metric: fixed_bins width too large for multiply-shift");
+    std::uint64_t p = static_cast<std::uint64_t>(width.count()) * static_cast<std::uint64_t>(R::num);
+    std::uint64_t q = static_cast<std::uint64_t>(R::den);
+    const std::uint64_t g = __bins_gcd(p, q);
+    p /= g;
+    q /= g;
+    if (bins_ >= limit / p) throw std::domain_error("metric: fixed_bins range too large for multiply-shift");
+    const std::uint64_t end = (static_cast<std::uint64_t>(bins_) * p + q - 1) / q;  // end of last bin in units
+    const std::uint64_t top = end * q + p;                                         // largest v
+    if (top >= limit) throw std::domain_error("metric: fixed_bins range too large for multiply-shift");
+    const int shift = __bins_bit_width(top) + __bins_bit_width(p);
+    const std::int64_t o = static_cast<std::int64_t>(distance_cast<Distance>(origin).count());
+    const std::int64_t above = static_cast<std::int64_t>(end);
+    origin_units_ = o;
+    hi_ = o > std::numeric_limits<std::int64_t>::max() - above ? std::numeric_limits<std::int64_t>::max() : o + above;
+    const std::uint64_t mul = ((std::uint64_t(1) << shift) + p - 1) / p;
+    qmul_ = q * mul;
+    pmul_ = p * mul;
+    shift_ = shift;
+  }
+
+  std::size_t index(repr x, std::true_type) const noexcept {
+    const double t = (static_cast<double>(x) - origin_) * inverse_;
+    const double b = static_cast<double>(bins_);
+    return !(t >= 0.0) ? 0 : t >= b ? bins_ + 1 : static_cast<std::size_t>(t) + 1;
+  }
+
+  std::size_t index(repr x, std::false_type) const noexcept {
+    std::int64_t d = static_cast<std::int64_t>(x);
+    if (d < origin_units_) return 0;
+    d = d > hi_ ? hi_ : d;
+    const std::uint64_t u = static_cast<std::uint64_t>(d - origin_units_);
+    const std::size_t k = static_cast<std::size_t>((u * qmul_ + pmul_) >> shift_);  // v * M
+    return k > bins_ ? bins_ + 1 : k;
+  }
+
+  std::size_t bins_;
+  double origin_;
+  double width_;
+  double inverse_;
+  std::int64_t origin_units_ = 0;
+  std::int64_t hi_ = 0;
+  std::uint64_t qmul_ = 0;
+  std::uint64_t pmul_ = 0;
+  int shift_ = 0;
+};
+
+/* binning @} */
+
+/* @{ histograms */
+
+/* Histogram of the `n` elements `get(i)`. */
+template <typename Distance, typename Get>
+void __histogram_n(Get get, std::size_t n, const fixed_bins<Distance>& shared, std::uint64_t* counts) {
+  const fixed_bins<Distance> bins = shared;  // local copy: increments of counts cannot alias its parameters
+  for (std::size_t i = 0; i < n; ++i) ++counts[bins(get(i))];
+}
+
+/**
+ * \brief Add the histogram of `n` distances starting at `first` to `counts`.
+ * \param first Pointer to first distance.
+ * \param n Number of elements.
+ * \param bins Bins of the histogram.
+ * \param counts Counts to add to, `bins.bins() + 2` elements (see metric_histogram.h).
+ **/
+template <typename Distance>
+void histogram_n(const Distance* first, std::size_t n, const fixed_bins<Distance>& bins, std::uint64_t* counts) {
+  __histogram_n([first](std::size_t i) { return first[i]; }, n, bins, counts);
+}
+
+/**
+ * \brief Add the histogram of all distances in `in` to `counts` (see above).
+ * \param in View of distances.
+ * \param bins Bins of the histogram.
+ * \param counts Counts to add to, `bins.bins() + 2` elements.
+ **/
+template <typename T, typename Distance>
+void histogram_n(strided_view<T> in, const fixed_bins<Distance>& bins, std::uint64_t* counts) {
+  static_assert(std::is_same<typename strided_view<T>::value_type, Distance>::value, "view must match the bins");
+  __histogram_n([in](std::size_t i) { return in[i]; }, in.size(), bins, counts);
+}
+
+/* histograms @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_HISTOGRAM_H_
@@ -0,0 +1,98 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_instances.h
+ * \brief  Lists of the prebuilt instantiations of the `metric_instances` library.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * The compiled `metric_instances` target explicitly instantiates
+ * `distance_cast`, `operator+`, `operator-`, the relational operators and
+ * `operator<<` for the SI shorthands (`nanometers` ... `megameters`) with
+ * `std::int64_t`, `double`, `unsigned long long` and `long double`
+ * representations. Linking it defines `METRIC_EXTERN_INSTANCES`, which makes
+ * metric_core.h and metric_io.h declare these instantiations `extern`, so
+ * they are not instantiated and emitted in every translation unit again.
+ *
+ * The instantiations are generated from the X-macro lists below; this header
+ * is included by metric_core.h and metric_io.h and not meant for direct use.
+**/
+
+#ifndef METRIC_METRIC_INSTANCES_H_
+#define METRIC_METRIC_INSTANCES_H_
+
+#include <cstdint>
+#include <ratio>
+
+/* rejected at configure time already; this catches builds outside of CMake */
+#if defined(METRIC_COUNT_CONVERSIONS)
+#error "metric_instances cannot be combined with METRIC_COUNT_CONVERSIONS"
+#endif
+
+/* @{ instantiation lists */
+
+/** \brief Calls `M(Repr)` for all prebuilt representations. **/
+#define METRIC_INSTANCE_REPRS(M) M(std::int64_t) M(double) M(unsigned long long) M(long double)
+
+/** \brief Calls `M(R, Ratio)` for all prebuilt ratios. **/
+#define METRIC_INSTANCE_RATIOS(M, R) \
+  M(R, std::nano) M(R, std::micro) M(R, std::milli) M(R, std::centi) \
+  M(R, std::deci) M(R, std::ratio<1>) M(R, std::kilo) M(R, std::mega)
+
+/* `METRIC_INSTANCE_RATIOS` for the target ratio of casts from `F`. */
+#define _METRIC_INSTANCE_CAST_TARGETS(M, R, F) \
+  M(R, F, std::nano) M(R, F, std::micro) M(R, F, std::milli) M(R, F, std::centi) \
+  M(R, F, std::deci) M(R, F, std::ratio<1>) M(R, F, std::kilo) M(R, F, std::mega)
+
+/* instantiation lists @} */
+
+/* @{ instantiations */
+
+/* Explicit instantiation definitions in the library, declarations everywhere else. */
+#if defined(METRIC_INSTANTIATE)
+#define _METRIC_INSTANCE template
+#else
+#define _METRIC_INSTANCE extern template
+#endif
+
+#define _METRIC_CAST_INSTANCE(R, F, T) \
+  _METRIC_INSTANCE distance<R, T> distance_cast<distance<R, T>>(const distance<R, F>&);
+
+#define _METRIC_CORE_RATIO_INSTANCES(R, Q) \
+  _METRIC_INSTANCE distance<R, Q> operator+(const distance<R, Q>&, const distance<R, Q>&); \
+  _METRIC_INSTANCE distance<R, Q> operator-(const distance<R, Q>&, const distance<R, Q>&); \
+  _METRIC_INSTANCE bool operator==(const distance<R, Q>&, const distance<R, Q>&); \
+  _METRIC_INSTANCE bool operator!=(const distance<R, Q>&, const distance<R, Q>&); \
+  _METRIC_INSTANCE bool operator<(const distance<R, Q>&, const distance<R, Q>&); \
+  _METRIC_INSTANCE bool operator>(const distance<R, Q>&, const distance<R, Q>&); \
+  _METRIC_INSTANCE bool operator<=(const distance<R, Q>&, const distance<R, Q>&); \
+  _METRIC_INSTANCE bool operator>=(const distance<R, Q>&, const distance<R, Q>&); \
+  _METRIC_INSTANCE_CAST_TARGETS(_METRIC_CAST_INSTANCE, R, Q)
+
+#define _METRIC_IO_RATIO_INSTANCES(R, Q) \
+  _METRIC_INSTANCE std::ostream& operator<<(std::ostream&, const distance<R, Q>&);
+
+/** \brief Instantiations of metric_core.h for representation `R` (inside namespace `metric`). **/
+#define _METRIC_CORE_INSTANCES(R) METRIC_INSTANCE_RATIOS(_METRIC_CORE_RATIO_INSTANCES, R)
+/** \brief Instantiations of metric_io.h for representation `R` (inside namespace `metric`). **/
+#define _METRIC_IO_INSTANCES(R) METRIC_INSTANCE_RATIOS(_METRIC_IO_RATIO_INSTANCES, R)
+
+/* instantiations @} */
+
+#endif  // METRIC_METRIC_INSTANCES_H_
@@ -0,0 +1,148 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_io.h
+ * \brief  Stream operators for metric distances.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+**/
+
+#ifndef METRIC_METRIC_IO_H_
+#define METRIC_METRIC_IO_H_
+
+#include <ostream>
+
+#include "metric_core.h"
+
+namespace metric {
+
+/* @{ stream operators */
+
+/**
+ * \brief *Primary template:* stream operator for generic `distance` instances.
+ *
+ * Outputs format: "<UNITS> <NUM>/<DEN> m".
+ **/
+template <typename Repr, typename Ratio>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, Ratio>& d) {
+  o << d.count() << " " << Ratio::num << "/" << Ratio::den << " m";
+  return o;
+}
+
+/**
+ * \brief *Specialization:* stream operator for nanometers.
+ *
+ * Outputs format: "<UNITS> nm".
+ **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, std::nano>& d) {
+  o << d.count() << " nm";
+  return o;
+}
+
+/**
+ * \brief *Specialization:* stream operator for micrometers.
+ *
+ * Outputs format: "<UNITS> um".
+ **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, std::micro>& d) {
+  o << d.count() << " um";
+  return o;
+}
+
+/**
+ * \brief *Specialization:* stream operator for millimeters.
+ *
+ * Outputs format: "<UNITS> mm".
+ **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, std::milli>& d) {
+  o << d.count() << " mm";
+  return o;
+}
+
+/**
+ * \brief *Specialization:* stream operator for centimeters.
+ *
+ * Outputs format: "<UNITS> cm".
+ **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, std::centi>& d) {
+  o << d.count() << " cm";
+  return o;
+}
+
+/**
+ * \brief *Specialization:* stream operator for decimeters.
+ *
+ * Outputs format: "<UNITS> dm".
+ **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, std::deci>& d) {
+  o << d.count() << " dm";
+  return o;
+}
+
+/**
+ * \brief *Specialization:* stream operator for meters.
+ *
+ * Outputs format: "<UNITS> m".
+ **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, std::ratio<1>>& d) {
+  o << d.count() << " m";
+  return o;
+}
+
+/**
+ * \brief *Specialization:* stream operator for kilometers.
+ *
+ * Outputs format: "<UNITS> km".
+ **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, std::kilo>& d) {
+  o << d.count() << " km";
+  return o;
+}
+
+/**
+ * \brief *Specialization:* stream operator for megameters.
+ *
+ * Outputs format: "<UNITS> Mm".
+ **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const distance<Repr, std::mega>& d) {
+  o << d.count() << " Mm";
+  return o;
+}
+
+/* stream operators @} */
+
+}  // namespace metric
+
+/* @{ prebuilt instantiations (see metric_instances.h) */
+#if defined(METRIC_EXTERN_INSTANCES) || defined(METRIC_INSTANTIATE)
+namespace metric {
+METRIC_INSTANCE_REPRS(_METRIC_IO_INSTANCES)
+}  // namespace metric
+#endif
+/* prebuilt instantiations @} */
+
+#endif  // METRIC_METRIC_IO_H_
@@ -0,0 +1,232 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_kernels.h
+ * \brief  Compiled bulk kernels with runtime selection of the instruction set.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Unlike the header-only kernels of metric_bulk.h, these kernels live in the
+ * compiled `metric_kernels` library (configure with
+ * `-DMETRIC_BUILD_KERNELS=ON`). The library builds every kernel for several
+ * instruction set levels and selects the best one supported by the CPU on
+ * first use, so AVX2 and AVX-512 code is available without compiling user code
+ * for these instruction sets. Setting the environment variable
+ * `METRIC_KERNELS_ISA` to `generic`, `avx2` or `avx512` limits the selection
+ * to that level, e.g., for testing.
+ *
+ * The untyped kernels in `metric::kernels` form the stable ABI of the library;
+ * the typed wrappers fold unit ratios at compile-time and forward to them.
+ * They accept all representations whose `simd_lane` is `std::int32_t` or
+ * `double`.
+ * All levels compute bitwise identical results (reductions use a fixed
+ * summation order, and no multiply-adds are fused).
+**/
+
+#ifndef METRIC_METRIC_KERNELS_H_
+#define METRIC_METRIC_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <type_traits>
+#include <utility>
+
+#include "metric_array.h"
+#include "metric_bulk.h"
+#include "metric_core.h"
+#include "metric_view.h"
+
+namespace metric {
+namespace kernels {
+
+/* @{ instruction set selection */
+
+/** \brief Instruction set levels of the kernels. **/
+enum class isa {
+  generic,  ///< \brief Baseline of the target (SSE2 on x86-64).
+  avx2,     ///< \brief AVX2.
+  avx512,   ///< \brief AVX-512F.
+};
+
+/** \brief Return name of `level`, as accepted by `METRIC_KERNELS_ISA`. **/
+const char* isa_name(isa level) noexcept;
+
+/** \brief Return true, if `level` was compiled into the library and is supported by the CPU. **/
+bool isa_supported(isa level) noexcept;
+
+/** \brief Return level of the kernels in use. **/
+isa active_isa() noexcept;
+
+/* instruction set selection @} */
+
+/* @{ untyped kernels */
+
+/** \brief `out[i] = in[i] * scale + offset` for `i` in `[0, n)`. **/
+void affine_i32_f64(const std::int32_t* in, std::size_t n, double scale, double offset, double* out) noexcept;
+
+/** \brief `out[i] = round(in[i] * scale)` (to nearest, ties away from zero); results must fit `int32_t`. **/
+void scale_f64_i32(const double* in, std::size_t n, double scale, std::int32_t* out) noexcept;
+
+/** \brief Return sum of `in[0, n)`. **/
+double sum_f64(const double* in, std::size_t n) noexcept;
+
+/** \brief Store minimum and maximum of `in[0, n)` to `min` and `max`; `n` must be positive. **/
+void minmax_i32(const std::int32_t* in, std::size_t n, std::int32_t* min, std::int32_t* max) noexcept;
+
+/* untyped kernels @} */
+
+/* @{ typed kernels */
+
+/* Representations processed as `std::int32_t` and `double` lanes, respectively. */
+template <typename Repr, typename R = void>
+using __if_i32 = typename std::enable_if<std::is_same<typename simd_lane<Repr>::type, std::int32_t>::value, R>::type;
+template <typename Repr, typename R = void>
+using __if_f64 = typename std::enable_if<std::is_same<typename simd_lane<Repr>::type, double>::value, R>::type;
+
+/**
+ * \brief Cast `n` integral distances starting at `in` to `double` distances.
+ * \param in Pointer to first input element.
+ * \param n Number of elements.
+ * \param out Pointer to first output element.
+ **/
+template <class Repr, class Ratio, class ToRepr, class ToRatio>
+inline __if_i32<Repr, __if_f64<ToRepr>> cast_n(const distance<Repr, Ratio>* in, std::size_t n,
+                                               distance<ToRepr, ToRatio>* out) noexcept {
+  affine_i32_f64(reinterpret_cast<const std::int32_t*>(in), n, __calibrated_factor<Ratio, ToRatio>(), 0.0,
+                 reinterpret_cast<double*>(out));
+}
+
+/**
+ * \brief Cast `n` `double` distances starting at `in` to integral distances, rounding to nearest.
+ * \param in Pointer to first input element.
+ * \param n Number of elements.
+ * \param out Pointer to first output element.
+ **/
+template <class Repr, class Ratio, class ToRepr, class ToRatio>
+inline __if_f64<Repr, __if_i32<ToRepr>> cast_n(const distance<Repr, Ratio>* in, std::size_t n,
+                                               distance<ToRepr, ToRatio>* out) noexcept {
+  scale_f64_i32(reinterpret_cast<const double*>(in), n, __calibrated_factor<Ratio, ToRatio>(),
+                reinterpret_cast<std::int32_t*>(out));
+}
+
+/**
+ * \brief Convert `n` raw counts starting at `in` to distances using `cal` (see `calibrated_cast_n`).
+ * \param in Pointer to first raw count.
+ * \param n Number of elements.
+ * \param cal Calibration of the counts.
+ * \param out Pointer to first output element.
+ **/
+template <class Ratio, class ToRepr, class ToRatio>
+inline __if_f64<ToRepr> calibrated_cast_n(const std::int32_t* in, std::size_t n, const linear_calibration<Ratio>& cal,
+                                          distance<ToRepr, ToRatio>* out) noexcept {
+  constexpr double f = __calibrated_factor<Ratio, ToRatio>();
+  affine_i32_f64(in, n, cal.scale * f, cal.offset * f, reinterpret_cast<double*>(out));
+}
+
+/** \brief Cast all elements of `in` to `out`, which is resized accordingly. **/
+template <class Repr, class Ratio, class ToRepr, class ToRatio, class A1, class A2>
+inline void cast(const distance_array<distance<Repr, Ratio>, A1>& in, distance_array<distance<ToRepr, ToRatio>, A2>& out) {
+  out.clear();
+  cast_n(in.data(), in.size(), out.append_uninitialized(in.size()));
+}
+
+/** \brief Return sum of `n` distances starting at `in`. **/
+template <class Repr, class Ratio>
+inline __if_f64<Repr, distance<Repr, Ratio>> sum(const distance<Repr, Ratio>* in, std::size_t n) noexcept {
+  return distance<Repr, Ratio>(static_cast<Repr>(sum_f64(reinterpret_cast<const double*>(in), n)));
+}
+
+/** \brief Return sum of all elements of `in`. **/
+template <class Repr, class Ratio, class Alloc>
+inline __if_f64<Repr, distance<Repr, Ratio>> sum(const distance_array<distance<Repr, Ratio>, Alloc>& in) noexcept {
+  return sum(in.data(), in.size());
+}
+
+/** \brief Return minimum and maximum of `n > 0` distances starting at `in`. **/
+template <class Repr, class Ratio>
+inline __if_i32<Repr, std::pair<distance<Repr, Ratio>, distance<Repr, Ratio>>>
+minmax(const distance<Repr, Ratio>* in, std::size_t n) noexcept {
+  std::int32_t lo, hi;
+  minmax_i32(reinterpret_cast<const std::int32_t*>(in), n, &lo, &hi);
+  return std::make_pair(distance<Repr, Ratio>(static_cast<Repr>(lo)), distance<Repr, Ratio>(static_cast<Repr>(hi)));
+}
+
+/** \brief Return minimum and maximum of all elements of non-empty `in`. **/
+template <class Repr, class Ratio, class Alloc>
+inline __if_i32<Repr, std::pair<distance<Repr, Ratio>, distance<Repr, Ratio>>>
+minmax(const distance_array<distance<Repr, Ratio>, Alloc>& in) noexcept {
+  return minmax(in.data(), in.size());
+}
+
+/* typed kernels @} */
+
+/* @{ strided kernels */
+
+/*
+ * Strided inputs (see `strided_view`) are forwarded to the typed kernels in
+ * blocks (see `for_each_block`). Reductions over views that are not contiguous
+ * add up the results of the blocks, so sums may differ from the sum of the
+ * same elements in an array in the last bits.
+ */
+
+/** \brief Cast all distances in `in` to `out` (see `cast_n`). **/
+template <class From, class ToRepr, class ToRatio>
+inline typename std::enable_if<is_distance<typename std::remove_cv<From>::type>::value>::type
+cast_n(strided_view<From> in, distance<ToRepr, ToRatio>* out) noexcept {
+  using F = typename std::remove_cv<From>::type;
+  for_each_block(in, [out](const F* block, std::size_t pos, std::size_t m) { cast_n(block, m, out + pos); });
+}
+
+/** \brief Convert all raw counts in `in` to distances using `cal` (see `calibrated_cast_n`). **/
+template <class Count, class Ratio, class ToRepr, class ToRatio>
+inline typename std::enable_if<std::is_same<typename std::remove_cv<Count>::type, std::int32_t>::value,
+                               __if_f64<ToRepr>>::type
+calibrated_cast_n(strided_view<Count> in, const linear_calibration<Ratio>& cal, distance<ToRepr, ToRatio>* out) noexcept {
+  for_each_block(in, [&cal, out](const std::int32_t* block, std::size_t pos, std::size_t m) {
+    calibrated_cast_n(block, m, cal, out + pos);
+  });
+}
+
+/** \brief Return sum of all distances in `in`. **/
+template <class From, class D = typename std::remove_cv<From>::type>
+inline __if_f64<typename D::repr, D> sum(strided_view<From> in) noexcept {
+  typename D::repr s = typename D::repr();
+  for_each_block(in, [&s](const D* block, std::size_t, std::size_t m) { s += sum(block, m).count(); });
+  return D(s);
+}
+
+/** \brief Return minimum and maximum of all distances in non-empty `in`. **/
+template <class From, class D = typename std::remove_cv<From>::type>
+inline __if_i32<typename D::repr, std::pair<D, D>> minmax(strided_view<From> in) noexcept {
+  std::pair<D, D> r(in[0], in[0]);
+  for_each_block(in, [&r](const D* block, std::size_t, std::size_t m) {
+    const std::pair<D, D> b = minmax(block, m);
+    if (b.first.count() < r.first.count()) r.first = b.first;
+    if (r.second.count() < b.second.count()) r.second = b.second;
+  });
+  return r;
+}
+
+/* strided kernels @} */
+
+}  // namespace kernels
+}  // namespace metric
+
+#endif  // METRIC_METRIC_KERNELS_H_
@@ -0,0 +1,277 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_kinematics.h
+ * \brief  Integration and differentiation of sampled velocities and distances.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * The integration kernels accumulate in the exact unit of the integrand: e.g.,
+ * the trapezoid rule on mm/s samples with ms timestamps accumulates counts of
+ * 1/2 um (the factor 1/2 of the rule is folded into the ratio). For integral
+ * representations the cumulative sums are thus exact, and rounding happens
+ * only once per element when casting to the requested output type. The price
+ * is range: the 64 bit accumulator of mm/s samples with ns timestamps counts
+ * 1/2 pm and overflows after about 4600 km. Integral integration therefore
+ * checks every term and partial sum and throws `std::overflow_error` instead
+ * of wrapping; use floating-point samples or a coarser time base for longer
+ * spans.
+ *
+ * The kernels work in cache-sized blocks: first all terms of a block are
+ * computed (a loop without dependencies, which compilers vectorize), then
+ * they are summed up with an SSE2 in-register prefix scan (floating-point) or
+ * an overflow-checked sequential scan (integral). Note that
+ * for floating-point representations the scan sums in a different order than
+ * a sequential loop, so the last bits may differ.
+**/
+
+#ifndef METRIC_METRIC_KINEMATICS_H_
+#define METRIC_METRIC_KINEMATICS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "metric_core.h"
+#include "metric_velocity.h"
+
+namespace metric {
+
+namespace {  // anonymous namespace for scan helpers
+
+/* Number of terms computed and scanned per block. */
+constexpr std::size_t __kinematics_block = 512;
+
+/* In-place inclusive prefix sum of `n` values starting at `carry`; returns the total. */
+template <typename T>
+inline T __prefix_sum(T* a, std::size_t n, T carry) {
+  for (std::size_t i = 0; i < n; ++i) a[i] = carry += a[i];
+  return carry;
+}
+
+#if defined(__SSE2__)
+inline double __prefix_sum(double* a, std::size_t n, double carry) {
+  __m128d c = _mm_set1_pd(carry);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128d x = _mm_loadu_pd(a + i);
+    x = _mm_add_pd(x, _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(x), 8)));
+    x = _mm_add_pd(x, c);
+    _mm_storeu_pd(a + i, x);
+    c = _mm_unpackhi_pd(x, x);
+  }
+  return __prefix_sum<double>(a + i, n - i, i ? a[i - 1] : carry);
+}
+#endif
+
+[[noreturn]] inline void __kinematics_overflow() {
+  throw std::overflow_error("metric: integral integration overflows, use floating-point or a coarser time base");
+}
+
+/* Sums and products of integration terms; integral ones throw instead of wrapping. */
+inline double __kinematics_add(double a, double b) noexcept { return a + b; }
+inline double __kinematics_mul(double a, double b) noexcept { return a * b; }
+
+inline std::int64_t __kinematics_add(std::int64_t a, std::int64_t b) {
+  std::int64_t r;
+#if defined(__GNUC__)
+  if (__builtin_add_overflow(a, b, &r)) __kinematics_overflow();
+#else
+  if (b > 0 ? a > INT64_MAX - b : a < INT64_MIN - b) __kinematics_overflow();
+  r = a + b;
+#endif
+  return r;
+}
+
+inline std::int64_t __kinematics_mul(std::int64_t a, std::int64_t b) {
+  std::int64_t r;
+#if defined(__GNUC__)
+  if (__builtin_mul_overflow(a, b, &r)) __kinematics_overflow();
+#else
+  const bool negative = a && b && (a < 0) != (b < 0);
+  const std::uint64_t ua = a < 0 ? 0 - static_cast<std::uint64_t>(a) : static_cast<std::uint64_t>(a);
+  const std::uint64_t ub = b < 0 ? 0 - static_cast<std::uint64_t>(b) : static_cast<std::uint64_t>(b);
+  const std::uint64_t limit = static_cast<std::uint64_t>(INT64_MAX) + (negative ? 1 : 0);
+  if (ua && ub > limit / ua) __kinematics_overflow();
+  r = negative ? -static_cast<std::int64_t>(ua * ub - 1) - 1 : static_cast<std::int64_t>(ua * ub);
+#endif
+  return r;
+}
+
+/* In-place inclusive prefix sum as `__prefix_sum`; integral partial sums are checked for overflow. */
+inline double __checked_prefix_sum(double* a, std::size_t n, double carry) { return __prefix_sum(a, n, carry); }
+
+inline std::int64_t __checked_prefix_sum(std::int64_t* a, std::size_t n, std::int64_t carry) {
+  for (std::size_t i = 0; i < n; ++i) a[i] = carry = __kinematics_add(carry, a[i]);
+  return carry;
+}
+
+/* Exact unit of `velocity<..., DistRatio, Period>` times `duration<..., TimePeriod>` divided by `Div`. */
+template <typename DistRatio, typename Period, typename TimePeriod, std::intmax_t Div>
+using __integral_ratio = typename std::ratio_divide<
+  typename std::ratio_multiply<DistRatio, typename std::ratio_divide<TimePeriod, Period>::type>::type,
+  std::ratio<Div>>::type;
+
+/* Return `dd / dt` in units of `ToVelocity`, scaling before dividing to keep integral quotients precise. */
+template <class ToVelocity, class Repr, class Ratio, class Dt>
+inline ToVelocity __difference_quotient(const distance<Repr, Ratio>& dd, const Dt& dt) {
+  using F = typename std::ratio_divide<typename std::ratio_multiply<Ratio, typename ToVelocity::period>::type,
+                                       typename std::ratio_multiply<typename ToVelocity::distance_ratio,
+                                                                    typename Dt::period>::type>::type;
+  using CR = typename std::common_type<Repr, typename Dt::rep, typename ToVelocity::repr>::type;
+  return ToVelocity(static_cast<typename ToVelocity::repr>(
+    static_cast<CR>(dd.count()) * static_cast<CR>(F::num) / (static_cast<CR>(dt.count()) * static_cast<CR>(F::den))));
+}
+
+}  // namespace
+
+/* @{ integration */
+
+/**
+ * \brief Integrate velocity samples over time with the trapezoid rule.
+ *
+ * Stores the cumulative distance at each sample to `out`, i.e., `out[0]` is
+ * `initial` and `out[i] = out[i - 1] + (v[i - 1] + v[i]) / 2 * (t[i] - t[i - 1])`.
+ * Sums are exact (see above); each output is rounded once by `distance_cast`.
+ *
+ * \tparam ToDistance `distance` type of the output.
+ * \tparam Time Timestamp type, whose differences are `std::chrono::duration`s
+ *              (e.g., `std::chrono::time_point` or `duration`).
+ * \param t Pointer to `n` ascending timestamps.
+ * \param v Pointer to `n` velocity samples.
+ * \param n Number of samples.
+ * \param out Pointer to `n` output elements.
+ * \param initial Distance at the first sample.
+ * \throws std::overflow_error if, for integral representations, a sum exceeds
+ *         the 64 bit accumulator (see above); `out` is then partially written.
+ **/
+template <class ToDistance, class Time, class Repr, class DistRatio, class Period>
+typename std::enable_if<is_distance<ToDistance>::value>::type
+integrate_trapezoid(const Time* t, const velocity<Repr, DistRatio, Period>* v, std::size_t n,
+                    ToDistance* out, ToDistance initial = ToDistance()) {
+  using Dt = decltype(t[1] - t[0]);
+  using CR = typename std::conditional<treat_as_floating_point<Repr>::value ||
+                                           treat_as_floating_point<typename Dt::rep>::value,
+                                       double, std::int64_t>::type;
+  using Exact = distance<CR, __integral_ratio<DistRatio, Period, typename Dt::period, 2>>;
+  if (n == 0) return;
+  out[0] = initial;
+  CR buf[__kinematics_block];
+  CR acc = CR();
+  for (std::size_t base = 1; base < n; base += __kinematics_block) {
+    const std::size_t m = n - base < __kinematics_block ? n - base : __kinematics_block;
+    for (std::size_t j = 0; j < m; ++j) {
+      const std::size_t i = base + j;
+      buf[j] = __kinematics_mul(__kinematics_add(static_cast<CR>(v[i - 1].count()), static_cast<CR>(v[i].count())),
+                                static_cast<CR>((t[i] - t[i - 1]).count()));
+    }
+    acc = __checked_prefix_sum(buf, m, acc);
+    for (std::size_t j = 0; j < m; ++j)
+      out[base + j] = ToDistance(initial.count() + distance_cast<ToDistance>(Exact(buf[j])).count());
+  }
+}
+
+/**
+ * \brief Integrate uniformly sampled velocities with Simpson's rule.
+ *
+ * Stores the cumulative distance after every pair of intervals, i.e., `out[k]`
+ * is the integral over samples `0` to `2k`; `out[0]` is `initial`. Simpson's
+ * rule is exact for polynomials up to degree three; its factor 1/3 is folded
+ * into the accumulation unit, as for `integrate_trapezoid`.
+ *
+ * \tparam ToDistance `distance` type of the output.
+ * \param v Pointer to `n` velocity samples.
+ * \param n Number of samples.
+ * \param dt Sampling interval.
+ * \param out Pointer to `(n + 1) / 2` output elements.
+ * \param initial Distance at the first sample.
+ * \return Number of outputs, `(n + 1) / 2`; a trailing odd interval is not integrated.
+ * \throws std::overflow_error if, for integral representations, a sum exceeds
+ *         the 64 bit accumulator (see above); `out` is then partially written.
+ **/
+template <class ToDistance, class Repr, class DistRatio, class Period, class TimeRepr, class TimePeriod>
+typename std::enable_if<is_distance<ToDistance>::value, std::size_t>::type
+integrate_simpson(const velocity<Repr, DistRatio, Period>* v, std::size_t n,
+                  std::chrono::duration<TimeRepr, TimePeriod> dt, ToDistance* out,
+                  ToDistance initial = ToDistance()) {
+  using CR = typename std::conditional<treat_as_floating_point<Repr>::value ||
+                                           treat_as_floating_point<TimeRepr>::value,
+                                       double, std::int64_t>::type;
+  using Exact = distance<CR, __integral_ratio<DistRatio, Period, TimePeriod, 3>>;
+  if (n == 0) return 0;
+  const std::size_t outputs = (n + 1) / 2;
+  out[0] = initial;
+  const CR h = static_cast<CR>(dt.count());
+  CR buf[__kinematics_block];
+  CR acc = CR();
+  for (std::size_t base = 1; base < outputs; base += __kinematics_block) {
+    const std::size_t m = outputs - base < __kinematics_block ? outputs - base : __kinematics_block;
+    for (std::size_t j = 0; j < m; ++j) {
+      const std::size_t i = 2 * (base + j);
+      buf[j] = __kinematics_mul(__kinematics_add(__kinematics_add(static_cast<CR>(v[i - 2].count()),
+                                                                  __kinematics_mul(CR(4), static_cast<CR>(v[i - 1].count()))),
+                                                 static_cast<CR>(v[i].count())), h);
+    }
+    acc = __checked_prefix_sum(buf, m, acc);
+    for (std::size_t j = 0; j < m; ++j)
+      out[base + j] = ToDistance(initial.count() + distance_cast<ToDistance>(Exact(buf[j])).count());
+  }
+  return outputs;
+}
+
+/* integration @} */
+
+/* @{ differentiation */
+
+/**
+ * \brief Differentiate distance samples over time.
+ *
+ * Uses central differences `(d[i + 1] - d[i - 1]) / (t[i + 1] - t[i - 1])` at
+ * interior samples and one-sided differences at both ends. The differences are
+ * scaled to the units of `ToVelocity` before dividing, so integral quotients
+ * are truncated only once.
+ *
+ * \tparam ToVelocity `velocity` type of the output.
+ * \param t Pointer to `n` strictly ascending timestamps.
+ * \param d Pointer to `n` distance samples.
+ * \param n Number of samples; if less than two, no output is written.
+ * \param out Pointer to `n` output elements.
+ **/
+template <class ToVelocity, class Time, class Repr, class Ratio>
+typename std::enable_if<is_velocity<ToVelocity>::value>::type
+differentiate(const Time* t, const distance<Repr, Ratio>* d, std::size_t n, ToVelocity* out) {
+  if (n < 2) return;
+  out[0] = __difference_quotient<ToVelocity>(d[1] - d[0], t[1] - t[0]);
+  for (std::size_t i = 1; i + 1 < n; ++i)
+    out[i] = __difference_quotient<ToVelocity>(d[i + 1] - d[i - 1], t[i + 1] - t[i - 1]);
+  out[n - 1] = __difference_quotient<ToVelocity>(d[n - 1] - d[n - 2], t[n - 1] - t[n - 2]);
+}
+
+/* differentiation @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_KINEMATICS_H_
@@ -0,0 +1,237 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_las.h
+ * \brief  Memory-mapped reader for uncompressed LAS point clouds.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+**/
+
+#ifndef METRIC_METRIC_LAS_H_
+#define METRIC_METRIC_LAS_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "metric_core.h"
+#include "metric_bulk.h"
+#include "metric_mmap.h"
+#include "metric_view.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "metric_las.h exposes little-endian LAS records in place and requires a little-endian host"
+#endif
+
+namespace metric {
+
+/**
+ * \brief One coordinate axis (X, Y or Z) of a LAS point cloud.
+ *
+ * LAS stores coordinates as `int32` counts `c`, denoting `c * scale + offset`.
+ * An axis exposes the counts in place, either raw or as `distance` values
+ * relative to `offset()`, and converts them to any compile-time unit via the
+ * calibrated bulk kernels.
+ *
+ * \tparam Ratio Unit of scale and offset; LAS leaves this to the coordinate
+ *               reference system, the default is meters.
+ **/
+template <typename Ratio = std::ratio<1>>
+class las_axis {
+ public:
+  /*! \brief Construct empty axis. **/
+  las_axis() noexcept : cal_{1.0, 0.0} {}
+
+  /*!
+   * \brief Construct axis over counts with given calibration.
+   * \param counts View of the raw counts.
+   * \param cal Scale and offset of the counts.
+   **/
+  las_axis(strided_view<const std::int32_t> counts, linear_calibration<Ratio> cal) noexcept
+    : counts_(counts), cal_(cal) {}
+
+  /*! \brief Return length of one count in units of `Ratio`. **/
+  double scale() const noexcept { return cal_.scale; }
+
+  /*! \brief Return origin of the counts in units of `Ratio`. **/
+  double offset() const noexcept { return cal_.offset; }
+
+  /*! \brief Return calibration of the counts. **/
+  const linear_calibration<Ratio>& calibration() const noexcept { return cal_; }
+
+  /*! \brief Return view of the raw counts. **/
+  strided_view<const std::int32_t> counts() const noexcept { return counts_; }
+
+  /*!
+   * \brief Return counts as distances relative to `offset()`, without copying.
+   *
+   * This is only possible if the scale of the axis is exactly the unit
+   * `CountRatio`, e.g., `std::milli` for a scale of 0.001 m.
+   *
+   * \tparam CountRatio Ratio of the counts w.r.t. meters.
+   * \throws std::domain_error if the scale does not match `CountRatio`.
+   **/
+  template <typename CountRatio>
+  strided_distance_view<const distance<std::int32_t, CountRatio>> as() const {
+    using R = typename std::ratio_divide<CountRatio, Ratio>::type;
+    const double expected = static_cast<double>(R::num) / static_cast<double>(R::den);
+    if (std::fabs(cal_.scale - expected) > expected * 1e-9)
+      throw std::domain_error("metric: LAS scale does not match requested distance ratio");
+    return strided_distance_view<const distance<std::int32_t, CountRatio>>(
+        counts_.data(), counts_.stride(), counts_.size());
+  }
+
+  /*!
+   * \brief Convert absolute coordinates (including offset) to `ToDistance`.
+   * \tparam ToDistance `distance` type to convert to.
+   * \param out Pointer to at least `counts().size()` output elements.
+   **/
+  template <typename ToDistance>
+  void convert(ToDistance* out) const {
+    calibrated_cast_n(counts_, cal_, out);
+  }
+
+ private:
+  strided_view<const std::int32_t> counts_;
+  linear_calibration<Ratio> cal_;
+};
+
+/**
+ * \brief Memory-mapped, read-only uncompressed LAS (1.0 - 1.4) file.
+ *
+ * Opening the file only maps it and validates the public header block; the
+ * point records are never copied. Compressed (LAZ) point data is rejected.
+ *
+ * ~~~{.cpp}
+ * metric::las_file las("tile.las");
+ * std::vector<metric::millimeters<std::int64_t>> x(las.size());
+ * las.x().convert(x.data());
+ * ~~~
+ *
+ * \tparam Ratio Unit of the coordinate reference system, defaults to meters.
+ **/
+template <typename Ratio = std::ratio<1>>
+class basic_las_file {
+ public:
+  using axis_type = las_axis<Ratio>;  ///< \brief Type of coordinate axes.
+
+  /*!
+   * \brief Map and validate the LAS file at `path`.
+   * \throws std::system_error if the file cannot be mapped.
+   * \throws std::runtime_error if it is no valid uncompressed LAS file.
+   **/
+  explicit basic_las_file(const std::string& path) : file_(path) {
+    const unsigned char* h = file_.data();
+    if (file_.size() < header_min_size || std::memcmp(h, "LASF", 4) != 0)
+      throw std::runtime_error("metric: not a LAS file '" + path + "'");
+    version_major_ = load<std::uint8_t>(h + 24);
+    version_minor_ = load<std::uint8_t>(h + 25);
+    const std::uint16_t header_size = load<std::uint16_t>(h + 94);
+    const std::uint32_t point_offset = load<std::uint32_t>(h + 96);
+    const std::uint8_t format = load<std::uint8_t>(h + 104);
+    if (format & 0xc0)
+      throw std::runtime_error("metric: compressed LAS point data is not supported '" + path + "'");
+    point_format_ = format;
+    record_length_ = load<std::uint16_t>(h + 105);
+    size_ = load<std::uint32_t>(h + 107);
+    if (header_size < header_min_size || header_size > file_.size() || point_offset < header_size)
+      throw std::runtime_error("metric: invalid LAS header size '" + path + "'");
+    if (version_minor_ >= 4 && header_size >= header_v14_size && size_ == 0)
+      size_ = load<std::uint64_t>(h + 247);
+    if (record_length_ < 12)
+      throw std::runtime_error("metric: invalid LAS point record length '" + path + "'");
+    if (point_offset > file_.size() ||
+        (file_.size() - point_offset) / record_length_ < size_)
+      throw std::runtime_error("metric: truncated LAS file '" + path + "'");
+
+    const unsigned char* points = h + point_offset;
+    const std::size_t n = static_cast<std::size_t>(size_);
+    for (int i = 0; i < 3; ++i) {
+      linear_calibration<Ratio> cal { load<double>(h + 131 + 8 * i), load<double>(h + 155 + 8 * i) };
+      axes_[i] = axis_type(strided_view<const std::int32_t>(points + 4 * i, record_length_, n), cal);
+    }
+    for (int i = 0; i < 3; ++i) {
+      max_[i] = load<double>(h + 179 + 16 * i);
+      min_[i] = load<double>(h + 187 + 16 * i);
+    }
+  }
+
+  /*! \brief Return number of point records. **/
+  std::uint64_t size() const noexcept { return size_; }
+
+  /*! \brief Return point data record format (0 - 10). **/
+  unsigned point_format() const noexcept { return point_format_; }
+
+  /*! \brief Return size of one point record in bytes. **/
+  std::size_t record_length() const noexcept { return record_length_; }
+
+  /*! \brief Return LAS major version. **/
+  unsigned version_major() const noexcept { return version_major_; }
+
+  /*! \brief Return LAS minor version. **/
+  unsigned version_minor() const noexcept { return version_minor_; }
+
+  /*! \brief Return X axis. **/
+  const axis_type& x() const noexcept { return axes_[0]; }
+
+  /*! \brief Return Y axis. **/
+  const axis_type& y() const noexcept { return axes_[1]; }
+
+  /*! \brief Return Z axis. **/
+  const axis_type& z() const noexcept { return axes_[2]; }
+
+  /*! \brief Return bounding box minimum as stored in the header (X, Y, Z). **/
+  const double* min() const noexcept { return min_; }
+
+  /*! \brief Return bounding box maximum as stored in the header (X, Y, Z). **/
+  const double* max() const noexcept { return max_; }
+
+  /*! \brief Return underlying mapping. **/
+  const mapped_file& file() const noexcept { return file_; }
+
+ private:
+  static constexpr std::size_t header_min_size = 227;   ///< LAS 1.0 - 1.2
+  static constexpr std::size_t header_v14_size = 375;   ///< LAS 1.4
+
+  template <typename T>
+  static T load(const unsigned char* p) noexcept {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  mapped_file file_;
+  axis_type axes_[3];
+  double min_[3];
+  double max_[3];
+  std::uint64_t size_;
+  std::size_t record_length_;
+  unsigned point_format_;
+  unsigned version_major_;
+  unsigned version_minor_;
+};
+
+/** \brief LAS file in a metric coordinate reference system. **/
+using las_file = basic_las_file<>;
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_LAS_H_
@@ -0,0 +1,245 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_lut.h
+ * \brief  Piecewise-linear lookup tables indexed by distance.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * `distance_lut` evaluates piecewise-linear functions of a distance, e.g.,
+ * calibration curves or route profiles (grade, speed limit, elevation along
+ * the route). Tables with uniformly spaced breakpoints are indexed directly;
+ * other tables use a guide table of equally sized buckets, which leaves at
+ * most a few breakpoints to compare, eight at a time and without branches:
+ *
+ * ~~~{.cpp}
+ * const double grade[] = { 0.0, 0.02, 0.05, 0.01 };
+ * metric::distance_lut<metric::meters<double>> profile(0_m, 250_m, grade, 4);  // 0 to 750 m
+ * profile(metric::meters<double>(100.0));  // 0.008
+ * ~~~
+**/
+
+#ifndef METRIC_METRIC_LUT_H_
+#define METRIC_METRIC_LUT_H_
+
+#include <cstddef>
+#include <limits>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "metric_core.h"
+#include "metric_view.h"
+
+namespace metric {
+
+namespace {  // anonymous namespace for lookup helpers
+
+/* Breakpoints compared at once by the search; keys are padded by as many +inf. */
+constexpr std::size_t __lut_lanes = 8;
+
+/* Queries per block of batched lookups. */
+constexpr std::size_t __lut_block = 64;
+
+}  // namespace
+
+/* @{ lookup tables */
+
+/**
+ * \brief Piecewise-linear function of a distance, given by breakpoints and values.
+ *
+ * Values are linear between breakpoints and held constant before the first and
+ * after the last breakpoint (including infinite arguments); NaN arguments yield NaN.
+ *
+ * \tparam Distance `distance` type of the arguments.
+ * \tparam Value Floating-point type of the values.
+ **/
+template <typename Distance, typename Value = double>
+class distance_lut {
+  static_assert(is_distance<Distance>::value, "distance_lut requires a distance type");
+  static_assert(std::is_floating_point<Value>::value, "distance_lut requires floating-point values");
+  using ratio = typename Distance::ratio;
+
+ public:
+  using distance_type = Distance;                              ///< \brief Argument type.
+  using value_type = Value;                                    ///< \brief Value type.
+  using size_type = std::size_t;                               ///< \brief Size type.
+  using bound_type = distance<double, ratio>;                  ///< \brief Type of breakpoints.
+
+  /**
+   * \brief Construct table of `n` values at uniformly spaced breakpoints
+   *        `origin + i * step`.
+   * \param origin First breakpoint.
+   * \param step Spacing of the breakpoints.
+   * \param values Pointer to `n` values.
+   * \param n Number of values.
+   * \throws std::invalid_argument if `step` is not positive or `n < 2`.
+   **/
+  template <typename ORepr, typename ORatio, typename SRepr, typename SRatio>
+  distance_lut(const distance<ORepr, ORatio>& origin, const distance<SRepr, SRatio>& step, const Value* values,
+               size_type n)
+    : values_(values, values + n) {
+    if (!(distance<SRepr, SRatio>::zero() < step) || n < 2)
+      throw std::invalid_argument("metric: distance_lut requires positive step and at least two values");
+    using R = typename std::ratio_divide<SRatio, ratio>::type;
+    origin_ = distance_cast<bound_type>(origin).count();
+    step_ = static_cast<double>(step.count()) * static_cast<double>(R::num) / static_cast<double>(R::den);
+    inverse_ = 1.0 / step_;
+  }
+
+  /**
+   * \brief Construct table of `n` values at ascending breakpoints.
+   * \param breakpoints Pointer to `n` strictly ascending breakpoints.
+   * \param values Pointer to `n` values.
+   * \param n Number of values.
+   * \throws std::invalid_argument if breakpoints are not strictly ascending or `n < 2`.
+   **/
+  distance_lut(const Distance* breakpoints, const Value* values, size_type n) : values_(values, values + n) {
+    if (n < 2) throw std::invalid_argument("metric: distance_lut requires at least two values");
+    keys_.reserve(n + __lut_lanes);
+    for (size_type i = 0; i < n; ++i) {
+      keys_.push_back(static_cast<double>(breakpoints[i].count()));
+      if (i && !(keys_[i - 1] < keys_[i]))
+        throw std::invalid_argument("metric: distance_lut breakpoints must be strictly ascending");
+    }
+    keys_.insert(keys_.end(), __lut_lanes, std::numeric_limits<double>::infinity());
+    slopes_.resize(n);
+    for (size_type i = 0; i + 1 < n; ++i)
+      slopes_[i] = static_cast<Value>((values_[i + 1] - values_[i]) / (keys_[i + 1] - keys_[i]));
+    // bucket b starts at the last breakpoint in a bucket before b; bucket() is monotone in x
+    origin_ = keys_[0];
+    step_ = (keys_[n - 1] - keys_[0]) / static_cast<double>(n);
+    inverse_ = 1.0 / step_;
+    guide_.resize(n);
+    for (size_type b = 0, i = 0; b < n; ++b) {
+      while (i + 1 < n && bucket(keys_[i + 1]) < b) ++i;
+      guide_[b] = i;
+    }
+  }
+
+  /*! \brief Return number of breakpoints. **/
+  size_type size() const noexcept { return values_.size(); }
+  /*! \brief Return true, if the breakpoints are uniformly spaced. **/
+  bool uniform() const noexcept { return keys_.empty(); }
+  /*! \brief Return breakpoint `i`. **/
+  bound_type breakpoint(size_type i) const noexcept {
+    return bound_type(uniform() ? origin_ + static_cast<double>(i) * step_ : keys_[i]);
+  }
+  /*! \brief Return value at breakpoint `i`. **/
+  Value value(size_type i) const noexcept { return values_[i]; }
+
+  /*! \brief Return value at `x`. **/
+  Value operator()(const Distance& x) const noexcept {
+    const double t = static_cast<double>(x.count());
+    return uniform() ? uniform_at(t) : value_at(segment(t), t);
+  }
+
+  /**
+   * \brief Store the values at `n` distances starting at `first` to `out`.
+   *
+   * Queries are evaluated in blocks: the guide table lookups of a block come
+   * first and prefetch the breakpoints, so that the cache misses of the
+   * searches overlap instead of being serialized query by query.
+   *
+   * \param first Pointer to first distance.
+   * \param n Number of elements.
+   * \param out Pointer to first value.
+   **/
+  void operator()(const Distance* first, size_type n, Value* out) const noexcept {
+    if (uniform()) {
+      for (size_type i = 0; i < n; ++i) out[i] = uniform_at(static_cast<double>(first[i].count()));
+      return;
+    }
+    double t[__lut_block];
+    size_type k[__lut_block];
+    for (size_type i = 0; i < n; i += __lut_block) {
+      const size_type m = n - i < __lut_block ? n - i : __lut_block;
+      for (size_type j = 0; j < m; ++j) {
+        t[j] = static_cast<double>(first[i + j].count());
+        k[j] = guide_[bucket(t[j])];
+#if defined(__GNUC__)
+        __builtin_prefetch(&keys_[k[j]]);
+        __builtin_prefetch(&values_[k[j]]);
+        __builtin_prefetch(&slopes_[k[j]]);
+#endif
+      }
+      for (size_type j = 0; j < m; ++j) out[i + j] = value_at(advance(k[j], t[j]), t[j]);
+    }
+  }
+
+  /*! \brief Store the values at all distances in `in` to `out` (see above). **/
+  void operator()(strided_view<const Distance> in, Value* out) const noexcept {
+    for_each_block(in, [this, out](const Distance* block, size_type pos, size_type m) { (*this)(block, m, out + pos); });
+  }
+
+ private:
+  Value uniform_at(double x) const noexcept {
+    const size_type n = values_.size();
+    const double t = (x - origin_) * inverse_;
+    if (t <= 0.0) return values_[0];
+    if (!(t < static_cast<double>(n - 1))) return t > 0.0 ? values_[n - 1] : std::numeric_limits<Value>::quiet_NaN();
+    const size_type k = static_cast<size_type>(t);
+    return values_[k] + (values_[k + 1] - values_[k]) * static_cast<Value>(t - static_cast<double>(k));
+  }
+
+  size_type bucket(double x) const noexcept {
+    const double t = (x - origin_) * inverse_;
+    const size_type n = guide_.size();
+    return !(t > 0.0) ? 0 : t < static_cast<double>(n) ? static_cast<size_type>(t) : n - 1;
+  }
+
+  /*
+   * Index of the last breakpoint at or before `x` (0 before the first breakpoint), starting at `k`.
+   * `x` at or after the last breakpoint, +inf and NaN yield the last breakpoint, so that the search
+   * never counts the padding.
+   */
+  size_type advance(size_type k, double x) const noexcept {
+    const size_type last = values_.size() - 1;
+    if (!(x < keys_[last])) return last;
+    for (;;) {
+      size_type c = 0;
+      for (size_type l = 1; l <= __lut_lanes; ++l) c += keys_[k + l] <= x;
+      k += c;
+      if (c < __lut_lanes) return k;
+    }
+  }
+
+  size_type segment(double x) const noexcept { return advance(guide_[bucket(x)], x); }
+
+  Value value_at(size_type k, double x) const noexcept {
+    if (x <= keys_[k]) return values_[k];
+    if (k + 1 == values_.size()) return x > keys_[k] ? values_[k] : std::numeric_limits<Value>::quiet_NaN();
+    return values_[k] + slopes_[k] * static_cast<Value>(x - keys_[k]);
+  }
+
+  std::vector<Value> values_;
+  std::vector<double> keys_;      // breakpoints in units of Distance, padded by +inf; empty if uniform
+  std::vector<Value> slopes_;
+  std::vector<size_type> guide_;  // first breakpoint to compare per bucket
+  double origin_;
+  double step_;
+  double inverse_;
+};
+
+/* lookup tables @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_LUT_H_
@@ -0,0 +1,223 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_memory.h
+ * \brief  Memory accounting for distance containers.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * `tracking_allocator` wraps another allocator and accounts all allocations
+ * to a tag type, which names a subsystem. Counters are global per tag and can
+ * be queried any time, e.g., to assert memory budgets in tests:
+ *
+ * ~~~{.cpp}
+ * struct scans { static const char* name() { return "scans"; } };
+ * metric::tracked_distance_array<metric::millimeters<int32_t>, scans> ranges;
+ * ranges.resize(1000);
+ * assert(metric::memory_usage_of<scans>().bytes == 4000);
+ * ~~~
+**/
+
+#ifndef METRIC_METRIC_MEMORY_H_
+#define METRIC_METRIC_MEMORY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "metric_array.h"
+
+namespace metric {
+
+/** \brief Snapshot of the allocation counters of one tag. **/
+struct memory_usage {
+  std::string tag;               ///< \brief Name of the tag.
+  std::size_t bytes;             ///< \brief Bytes currently allocated.
+  std::size_t peak;              ///< \brief Maximum of `bytes` since start or `reset_memory_peak`.
+  std::size_t allocations;       ///< \brief Number of allocations so far.
+  std::size_t deallocations;     ///< \brief Number of deallocations so far.
+};
+
+/** \brief Default tag of `tracking_allocator`. **/
+struct default_memory_tag {
+  static const char* name() noexcept { return "metric"; }
+};
+
+/* @{ implementation details */
+
+struct __memory_counter {
+  const char* name;
+  std::atomic<std::size_t> bytes;
+  std::atomic<std::size_t> peak;
+  std::atomic<std::size_t> allocations;
+  std::atomic<std::size_t> deallocations;
+
+  void allocate(std::size_t n) noexcept {
+    const std::size_t b = bytes.fetch_add(n, std::memory_order_relaxed) + n;
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t p = peak.load(std::memory_order_relaxed);
+    while (b > p && !peak.compare_exchange_weak(p, b, std::memory_order_relaxed)) {}
+  }
+
+  void deallocate(std::size_t n) noexcept {
+    bytes.fetch_sub(n, std::memory_order_relaxed);
+    deallocations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  memory_usage usage() const {
+    return memory_usage { name, bytes.load(std::memory_order_relaxed), peak.load(std::memory_order_relaxed),
+                          allocations.load(std::memory_order_relaxed),
+                          deallocations.load(std::memory_order_relaxed) };
+  }
+};
+
+struct __memory_registry {
+  std::mutex mutex;
+  std::vector<__memory_counter*> counters;
+};
+
+inline __memory_registry& __memory_registry_instance() {
+  static __memory_registry r;
+  return r;
+}
+
+template <typename Tag>
+inline __memory_counter& __memory_counter_of() {
+  static __memory_counter c { Tag::name(), { 0 }, { 0 }, { 0 }, { 0 } };
+  static const bool registered = [] {
+    __memory_registry& r = __memory_registry_instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.counters.push_back(&c);
+    return true;
+  }();
+  (void)registered;
+  return c;
+}
+
+/* implementation details @} */
+
+/**
+ * \brief Allocator adaptor accounting all allocations of `Alloc` to `Tag`.
+ * \tparam T Value type.
+ * \tparam Tag Tag type with a static `name()` returning `const char*`.
+ * \tparam Alloc Underlying allocator.
+ **/
+template <typename T, typename Tag = default_memory_tag, typename Alloc = std::allocator<T>>
+class tracking_allocator {
+  using traits = std::allocator_traits<Alloc>;
+
+ public:
+  using value_type = T;
+  using size_type = typename traits::size_type;
+  using difference_type = typename traits::difference_type;
+  using propagate_on_container_copy_assignment = typename traits::propagate_on_container_copy_assignment;
+  using propagate_on_container_move_assignment = typename traits::propagate_on_container_move_assignment;
+  using propagate_on_container_swap = typename traits::propagate_on_container_swap;
+
+  template <typename U>
+  struct rebind {
+    using other = tracking_allocator<U, Tag, typename traits::template rebind_alloc<U>>;
+  };
+
+  tracking_allocator() = default;
+
+  /*! \brief Wrap allocator `a`. **/
+  explicit tracking_allocator(const Alloc& a) noexcept : alloc_(a) {}
+
+  /*! \brief Converting constructor for rebinding. **/
+  template <typename U, typename A>
+  tracking_allocator(const tracking_allocator<U, Tag, A>& other) noexcept : alloc_(other.allocator()) {}
+
+  /*! \brief Allocate `n` elements and account them to `Tag`. **/
+  T* allocate(size_type n) {
+    T* p = traits::allocate(alloc_, n);
+    __memory_counter_of<Tag>().allocate(n * sizeof(T));
+    return p;
+  }
+
+  /*! \brief Deallocate `n` elements at `p`. **/
+  void deallocate(T* p, size_type n) noexcept {
+    __memory_counter_of<Tag>().deallocate(n * sizeof(T));
+    traits::deallocate(alloc_, p, n);
+  }
+
+  /*! \brief Return underlying allocator. **/
+  const Alloc& allocator() const noexcept { return alloc_; }
+
+  /*! \brief Return copy of this allocator for a copy of its container. **/
+  tracking_allocator select_on_container_copy_construction() const {
+    return tracking_allocator(traits::select_on_container_copy_construction(alloc_));
+  }
+
+ private:
+  Alloc alloc_;
+};
+
+/** \brief Allocators are equal, iff. their underlying allocators are equal. **/
+template <typename T, typename U, typename Tag, typename A1, typename A2>
+inline bool operator==(const tracking_allocator<T, Tag, A1>& lhs, const tracking_allocator<U, Tag, A2>& rhs) noexcept {
+  return lhs.allocator() == rhs.allocator();
+}
+
+/** \brief Allocators are equal, iff. their underlying allocators are equal. **/
+template <typename T, typename U, typename Tag, typename A1, typename A2>
+inline bool operator!=(const tracking_allocator<T, Tag, A1>& lhs, const tracking_allocator<U, Tag, A2>& rhs) noexcept {
+  return !(lhs == rhs);
+}
+
+/* @{ container shorthands */
+template <typename Distance, typename Tag = default_memory_tag>
+using tracked_distance_array = distance_array<Distance, tracking_allocator<Distance, Tag>>;
+template <typename Distance, std::size_t Dims = 2, typename Tag = default_memory_tag>
+using tracked_point_array = point_array<Distance, Dims, tracking_allocator<Distance, Tag>>;
+/* container shorthands @} */
+
+/* @{ queries */
+
+/** \brief Return allocation counters of `Tag`. **/
+template <typename Tag>
+inline memory_usage memory_usage_of() {
+  return __memory_counter_of<Tag>().usage();
+}
+
+/** \brief Reset peak of `Tag` to its current usage. **/
+template <typename Tag>
+inline void reset_memory_peak() noexcept {
+  __memory_counter& c = __memory_counter_of<Tag>();
+  c.peak.store(c.bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+/** \brief Return allocation counters of all tags which have been used so far. **/
+inline std::vector<memory_usage> memory_usage_report() {
+  __memory_registry& r = __memory_registry_instance();
+  std::vector<memory_usage> v;
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (const __memory_counter* c : r.counters) v.push_back(c->usage());
+  return v;
+}
+
+/* queries @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_MEMORY_H_
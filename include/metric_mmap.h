@@ -0,0 +1,132 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_mmap.h
+ * \brief  Read-only memory mapping of files (POSIX).
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+**/
+
+#ifndef METRIC_METRIC_MMAP_H_
+#define METRIC_METRIC_MMAP_H_
+
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace metric {
+
+/**
+ * \brief Owning, read-only memory mapping of a whole file.
+ *
+ * Pages are mapped lazily by the kernel, so opening even very large files is
+ * cheap; only the pages that are actually touched are read from disk.
+ * Failures to open or map the file are reported as `std::system_error`.
+ **/
+class mapped_file {
+ public:
+  /*! \brief Construct empty mapping. **/
+  mapped_file() noexcept : data_(nullptr), size_(0) {}
+
+  /*!
+   * \brief Map the file at `path` read-only.
+   * \param path Path of the file to map.
+   * \throws std::system_error if the file cannot be opened or mapped.
+   **/
+  explicit mapped_file(const std::string& path) : data_(nullptr), size_(0) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) fail("cannot open", path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      int err = errno;
+      ::close(fd);
+      errno = err;
+      fail("cannot stat", path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        fail("cannot map", path);
+      }
+      data_ = static_cast<const unsigned char*>(p);
+    }
+    ::close(fd);
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  /*! \brief Take over the mapping of `other`. **/
+  mapped_file(mapped_file&& other) noexcept : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  /*! \brief Release own mapping and take over the mapping of `other`. **/
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      data_ = other.data_;
+      size_ = other.size_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  ~mapped_file() { unmap(); }
+
+  /*! \brief Return pointer to first mapped byte (`nullptr` if empty). **/
+  const unsigned char* data() const noexcept { return data_; }
+
+  /*! \brief Return size of the mapping in bytes. **/
+  std::size_t size() const noexcept { return size_; }
+
+  /*! \brief Return true, iff. nothing is mapped. **/
+  bool empty() const noexcept { return size_ == 0; }
+
+ private:
+  static void fail(const char* what, const std::string& path) {
+    throw std::system_error(errno, std::generic_category(),
+                            std::string("metric: ") + what + " '" + path + "'");
+  }
+
+  void unmap() noexcept {
+    if (data_) ::munmap(const_cast<unsigned char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  const unsigned char* data_;
+  std::size_t size_;
+};
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_MMAP_H_
@@ -0,0 +1,352 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_ndjson.h
+ * \brief  Extraction of distance-valued fields from newline-delimited JSON.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * The extractor does not build a document: it jumps from one structural
+ * character (quotes and brackets) to the next, using SSE2 to scan 16 bytes at
+ * a time, and only parses the numbers of the requested top-level fields.
+ * Records are not validated beyond what is needed to find these fields.
+**/
+
+#ifndef METRIC_METRIC_NDJSON_H_
+#define METRIC_METRIC_NDJSON_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <ratio>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "metric_core.h"
+#include "metric_array.h"
+
+namespace metric {
+
+namespace {  // anonymous namespace for NDJSON scanning helpers
+
+/* Return first of '"', '{', '}', '[', ']' in [p, end), or `end`. */
+inline const char* __ndjson_find_structural(const char* p, const char* end) {
+#if defined(__SSE2__)
+  // '[' and ']' differ from '{' and '}' only in bit 0x20
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i open = _mm_set1_epi8('{');
+  const __m128i close = _mm_set1_epi8('}');
+  const __m128i bit = _mm_set1_epi8(0x20);
+  while (end - p >= 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i f = _mm_or_si128(v, bit);
+    const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+        _mm_or_si128(_mm_cmpeq_epi8(f, open), _mm_cmpeq_epi8(f, close))));
+    if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+    p += 16;
+  }
+#endif
+  for (; p < end; ++p) {
+    const char c = *p;
+    if (c == '"' || (c | 0x20) == '{' || (c | 0x20) == '}') return p;
+  }
+  return end;
+}
+
+/* Return first of '"', '\\' in [p, end), or `end`. */
+inline const char* __ndjson_find_quote(const char* p, const char* end) {
+#if defined(__SSE2__)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  while (end - p >= 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                                    _mm_cmpeq_epi8(v, backslash)));
+    if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+    p += 16;
+  }
+#endif
+  for (; p < end; ++p)
+    if (*p == '"' || *p == '\\') return p;
+  return end;
+}
+
+/* Return position after the string starting after the opening quote at `p`. */
+inline const char* __ndjson_skip_string(const char* p, const char* end) {
+  for (;;) {
+    p = __ndjson_find_quote(p, end);
+    if (p == end) return end;
+    if (*p == '"') return p + 1;
+    p += 2;  // skip escaped character
+    if (p >= end) return end;
+  }
+}
+
+inline const char* __ndjson_skip_ws(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+  return p;
+}
+
+/* Parsed JSON number; `integer` holds the exact value iff. `integral`. */
+struct __ndjson_number {
+  bool valid;
+  bool integral;      // no fraction and no exponent, fits into int64
+  std::int64_t integer;
+  double value;
+};
+
+/*
+ * Parse JSON number at `p`; uses the exact fast path (at most 19 significant
+ * digits, decimal exponent within +-22) and falls back to `strtod` otherwise.
+ */
+inline __ndjson_number __ndjson_parse_number(const char*& p, const char* end) {
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+  __ndjson_number r = { false, false, 0, 0.0 };
+  const char* start = p;
+  const char* q = p;
+  bool negative = false;
+  if (q < end && *q == '-') { negative = true; ++q; }
+  std::uint64_t m = 0;
+  int digits = 0, exp10 = 0;
+  const char* first_digit = q;
+  for (; q < end && *q >= '0' && *q <= '9'; ++q, ++digits)
+    m = m * 10 + static_cast<unsigned>(*q - '0');
+  if (q == first_digit) return r;
+  bool integral = true;
+  if (q < end && *q == '.') {
+    integral = false;
+    ++q;
+    for (; q < end && *q >= '0' && *q <= '9'; ++q, ++digits, --exp10)
+      m = m * 10 + static_cast<unsigned>(*q - '0');
+  }
+  if (q < end && (*q == 'e' || *q == 'E')) {
+    integral = false;
+    ++q;
+    bool eneg = false;
+    if (q < end && (*q == '-' || *q == '+')) eneg = *q++ == '-';
+    int e = 0;
+    for (; q < end && *q >= '0' && *q <= '9'; ++q)
+      if (e < 10000) e = e * 10 + (*q - '0');
+    exp10 += eneg ? -e : e;
+  }
+  p = q;
+  r.valid = true;
+  if (digits <= 19 && exp10 >= -22 && exp10 <= 22 && m <= (std::uint64_t(1) << 53)) {
+    const double v = static_cast<double>(m);
+    r.value = exp10 < 0 ? v / pow10[-exp10] : v * pow10[exp10];
+    if (negative) r.value = -r.value;
+  } else {
+    const std::string s(start, q);
+    r.value = std::strtod(s.c_str(), nullptr);
+  }
+  if (integral && digits <= 18) {
+    r.integral = true;
+    r.integer = negative ? -static_cast<std::int64_t>(m) : static_cast<std::int64_t>(m);
+  }
+  return r;
+}
+
+/*
+ * Store `v * num / den` rounded half away from zero to `out`; `num / den` is a
+ * reduced ratio. Returns false if the result may not fit into 64 bits.
+ */
+inline bool __ndjson_scale(std::int64_t v, std::intmax_t num, std::intmax_t den, std::int64_t& out) {
+  const std::int64_t max = std::numeric_limits<std::int64_t>::max();
+  const std::int64_t q = v / den, r = v % den;
+  if ((q < 0 ? -q : q) >= max / num || den > max / num) return false;
+  const std::int64_t t = r * num;
+  std::int64_t s = t / den;
+  const std::int64_t u = t % den;
+  if (2 * (u < 0 ? -u : u) >= den) s += t < 0 ? -1 : 1;
+  out = q * num + s;
+  return true;
+}
+
+/* Round `v` half away from zero to `Repr`, saturating at the limits of built-in types. */
+template <typename Repr>
+inline Repr __ndjson_round(double v) {
+  using limits = std::numeric_limits<Repr>;
+  if (limits::is_specialized && !(v > static_cast<double>(limits::lowest()))) return limits::lowest();
+  if (limits::is_specialized && !(v < static_cast<double>(limits::max()))) return limits::max();
+  return static_cast<Repr>(v < 0.0 ? v - 0.5 : v + 0.5);
+}
+
+template <typename Repr, bool = treat_as_floating_point<Repr>::value>
+struct __ndjson_missing {
+  static constexpr Repr value() { return static_cast<Repr>(std::numeric_limits<double>::quiet_NaN()); }
+};
+
+template <typename Repr>
+struct __ndjson_missing<Repr, false> {
+  static constexpr Repr value() { return Repr(0); }
+};
+
+}  // namespace
+
+/**
+ * \brief Extracts named numeric fields from NDJSON records as distances.
+ *
+ * Every field is registered with the unit its values are given in; values are
+ * converted to `Distance` on the fly. Integral JSON values are converted to
+ * integral representations exactly (like `distance_cast`), all others via `double`.
+ *
+ * ~~~{.cpp}
+ * metric::ndjson_extractor<metric::millimeters<double>> ex;
+ * ex.add_field<std::ratio<1>>("range_m");
+ * ex.add_field<std::centi>("offset_cm");
+ * std::vector<metric::distance_array<metric::millimeters<double>>> columns;
+ * ex.extract(text.data(), text.size(), columns);  // columns[0]: range_m, ...
+ * ~~~
+ *
+ * \tparam Distance `distance` type to extract to.
+ **/
+template <typename Distance>
+class ndjson_extractor {
+  static_assert(is_distance<Distance>::value, "ndjson_extractor requires a distance type");
+  using repr = typename Distance::repr;
+
+ public:
+  /*!
+   * \brief Register top-level field `name`, whose values are given in units of `Ratio`.
+   * \return Index of the field's column.
+   **/
+  template <typename Ratio>
+  std::size_t add_field(const std::string& name) {
+    using R = typename std::ratio_divide<Ratio, typename Distance::ratio>::type;
+    fields_.push_back(field { name, static_cast<double>(R::num) / static_cast<double>(R::den),
+                              R::num, R::den });
+    return fields_.size() - 1;
+  }
+
+  /*! \brief Return number of registered fields. **/
+  std::size_t fields() const noexcept { return fields_.size(); }
+
+  /*!
+   * \brief Extract all registered fields from the records in `len` bytes at `data`.
+   *
+   * Appends one value per non-empty line to each column; `columns` is resized
+   * to `fields()` if necessary. Missing, `null` or non-numeric values yield NaN
+   * for floating-point and zero for integral representations.
+   *
+   * \return Number of records.
+   **/
+  template <typename Alloc>
+  std::size_t extract(const char* data, std::size_t len,
+                      std::vector<distance_array<Distance, Alloc>>& columns) const {
+    if (columns.size() < fields_.size()) columns.resize(fields_.size());
+    std::vector<unsigned char> seen(fields_.size());
+    const char* p = data;
+    const char* end = data + len;
+    std::size_t records = 0;
+    while (p < end) {
+      const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+      if (!eol) eol = end;
+      if (__ndjson_skip_ws(p, eol) != eol) {
+        std::fill(seen.begin(), seen.end(), 0);
+        record(p, eol, seen, columns);
+        for (std::size_t f = 0; f < fields_.size(); ++f)
+          if (!seen[f]) columns[f].push_back(Distance(__ndjson_missing<repr>::value()));
+        ++records;
+      }
+      if (eol == end) break;
+      p = eol + 1;
+    }
+    return records;
+  }
+
+  /*! \brief Extract all registered fields from the records in `text`. **/
+  template <typename Alloc>
+  std::size_t extract(const std::string& text, std::vector<distance_array<Distance, Alloc>>& columns) const {
+    return extract(text.data(), text.size(), columns);
+  }
+
+ private:
+  struct field {
+    std::string name;
+    double factor;        // field unit / Distance unit
+    std::intmax_t num;    // exact factor for integral values
+    std::intmax_t den;
+  };
+
+  template <typename Alloc>
+  void record(const char* p, const char* end, std::vector<unsigned char>& seen,
+              std::vector<distance_array<Distance, Alloc>>& columns) const {
+    int depth = 0;
+    for (;;) {
+      p = __ndjson_find_structural(p, end);
+      if (p == end) return;
+      const char c = *p++;
+      if (c != '"') {
+        depth += (c | 0x20) == '{' ? 1 : -1;
+        continue;
+      }
+      const char* name = p;
+      p = __ndjson_skip_string(p, end);
+      if (depth != 1) continue;
+      const std::size_t name_len = static_cast<std::size_t>(p - 1 - name);
+      const char* q = __ndjson_skip_ws(p, end);
+      if (q == end || *q != ':') continue;  // string value, not a key
+      for (std::size_t f = 0; f < fields_.size(); ++f) {
+        if (seen[f] || fields_[f].name.size() != name_len ||
+            std::memcmp(fields_[f].name.data(), name, name_len) != 0)
+          continue;
+        q = __ndjson_skip_ws(q + 1, end);
+        __ndjson_number n = __ndjson_parse_number(q, end);
+        if (n.valid) {
+          columns[f].push_back(Distance(convert(fields_[f], n)));
+          seen[f] = 1;
+        }
+        p = q;
+        break;
+      }
+    }
+  }
+
+  static repr convert(const field& f, const __ndjson_number& n) {
+    return convert(f, n, std::integral_constant<bool, treat_as_floating_point<repr>::value>());
+  }
+
+  static repr convert(const field& f, const __ndjson_number& n, std::true_type) {
+    return static_cast<repr>(n.value * f.factor);
+  }
+
+  // integral values are scaled exactly and rounded like all others
+  static repr convert(const field& f, const __ndjson_number& n, std::false_type) {
+    std::int64_t v;
+    if (n.integral && __ndjson_scale(n.integer, f.num, f.den, v)) return static_cast<repr>(v);
+    return __ndjson_round<repr>(n.value * f.factor);
+  }
+
+  std::vector<field> fields_;
+};
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_NDJSON_H_
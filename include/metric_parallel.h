@@ -0,0 +1,287 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_parallel.h
+ * \brief  Multi-threaded conversion, sort, reduction and histograms of distances.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * All kernels split their input into chunks which are handed out dynamically
+ * to the worker threads. Every worker and every chunk is recorded as an event
+ * if tracing is enabled (see metric_trace.h).
+**/
+
+#ifndef METRIC_METRIC_PARALLEL_H_
+#define METRIC_METRIC_PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "metric_array.h"
+#include "metric_bulk.h"
+#include "metric_core.h"
+#include "metric_histogram.h"
+#include "metric_trace.h"
+#include "metric_view.h"
+
+namespace metric {
+
+/** \brief Default number of elements per chunk of the parallel kernels. **/
+constexpr std::size_t parallel_default_grain = std::size_t(1) << 16;
+
+/** \brief Return default number of worker threads (hardware concurrency). **/
+inline unsigned parallel_default_threads() noexcept {
+  const unsigned n = std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+/**
+ * \brief Call `f(begin, end)` for all chunks of `[0, n)` on `threads` threads.
+ *
+ * The calling thread takes part in the work. If any call throws, remaining
+ * chunks are skipped and the first exception is rethrown.
+ *
+ * \param name Task name for tracing (string literal).
+ * \param n Number of elements.
+ * \param grain Number of elements per chunk (the last one may be smaller).
+ * \param f Callable taking `std::size_t begin, std::size_t end`.
+ * \param threads Number of threads; 0 selects `parallel_default_threads()`.
+ **/
+template <typename F>
+void parallel_for(const char* name, std::size_t n, std::size_t grain, F f, unsigned threads = 0) {
+  if (grain == 0) grain = 1;
+  const std::size_t chunks = (n + grain - 1) / grain;
+  if (threads == 0) threads = parallel_default_threads();
+  if (threads > chunks) threads = static_cast<unsigned>(chunks);
+  std::atomic<std::size_t> next { 0 };
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto worker = [&] {
+    trace_scope worker_scope("metric::worker");
+    for (;;) {
+      const std::size_t c = next.fetch_add(1, std::memory_order_relaxed);
+      if (c >= chunks) return;
+      const std::size_t begin = c * grain;
+      const std::size_t end = std::min(n, begin + grain);
+      try {
+        trace_scope chunk_scope(name, end - begin);
+        f(begin, end);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+        next.store(chunks, std::memory_order_relaxed);
+      }
+    }
+  };
+  // the calling thread keeps its own timeline row, which workers must not take over
+  if (trace_enabled()) __trace_thread_buffer();
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+  worker();
+  for (std::thread& t : pool) t.join();
+  if (error) std::rethrow_exception(error);
+}
+
+/**
+ * \brief Cast `n` distances starting at `first` to `ToDistance` in parallel.
+ * \param first Pointer to first input element.
+ * \param n Number of elements.
+ * \param out Pointer to first output element; must not overlap the input
+ *            unless `out == first`.
+ * \param threads Number of threads; 0 selects `parallel_default_threads()`.
+ **/
+template <class ToDistance, class Repr, class Ratio>
+typename std::enable_if<is_distance<ToDistance>::value>::type
+parallel_cast_n(const distance<Repr, Ratio>* first, std::size_t n, ToDistance* out, unsigned threads = 0) {
+  parallel_for("metric::parallel_cast_n", n, parallel_default_grain, [=](std::size_t b, std::size_t e) {
+    for (std::size_t i = b; i < e; ++i) out[i] = distance_cast<ToDistance>(first[i]);
+  }, threads);
+}
+
+/*! \brief Cast all distances in `in` to `ToDistance` in parallel (see above). **/
+template <class ToDistance, class FromDistance>
+typename std::enable_if<is_distance<ToDistance>::value && is_distance<FromDistance>::value>::type
+parallel_cast_n(strided_view<FromDistance> in, ToDistance* out, unsigned threads = 0) {
+  parallel_for("metric::parallel_cast_n", in.size(), parallel_default_grain, [=](std::size_t b, std::size_t e) {
+    distance_cast_n<ToDistance>(in.subview(b, e - b), out + b);
+  }, threads);
+}
+
+/**
+ * \brief Convert all elements of `a` to `To` within its storage in parallel
+ *        (see `convert_in_place`).
+ *
+ * Narrowing conversions first compact every chunk within its own bytes in
+ * parallel, then move the chunks to their final positions front to back.
+ *
+ * \tparam To `distance` type to convert to.
+ * \param a Array to convert; empty afterwards.
+ * \param threads Number of threads; 0 selects `parallel_default_threads()`.
+ * \return Array of the converted elements.
+ **/
+template <typename To, typename From, typename Alloc>
+distance_array<To, typename std::allocator_traits<Alloc>::template rebind_alloc<To>>
+parallel_convert_in_place(distance_array<From, Alloc>&& a, unsigned threads = 0) {
+  return __convert_in_place<To>(std::move(a), [threads](From* p, std::size_t n) {
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(p);
+    parallel_for("metric::parallel_convert_in_place", n, parallel_default_grain, [=](std::size_t b, std::size_t e) {
+      __convert_compact<To>(p, b, e, bytes + b * sizeof(From));
+    }, threads);
+    if (sizeof(To) < sizeof(From)) {
+      for (std::size_t b = parallel_default_grain; b < n; b += parallel_default_grain) {
+        const std::size_t m = std::min(n - b, parallel_default_grain);
+        std::memmove(bytes + b * sizeof(To), bytes + b * sizeof(From), m * sizeof(To));
+      }
+    }
+  });
+}
+
+/**
+ * \brief Sort distances in `[first, last)` in parallel.
+ *
+ * Sorts one run per thread and merges pairs of runs until one is left.
+ *
+ * \param first Pointer to first element.
+ * \param last Pointer past the last element.
+ * \param threads Number of threads; 0 selects `parallel_default_threads()`.
+ **/
+template <class Repr, class Ratio>
+void parallel_sort(distance<Repr, Ratio>* first, distance<Repr, Ratio>* last, unsigned threads = 0) {
+  const std::size_t n = static_cast<std::size_t>(last - first);
+  if (threads == 0) threads = parallel_default_threads();
+  std::size_t run = std::max((n + threads - 1) / threads, parallel_default_grain);
+  parallel_for("metric::parallel_sort/sort", n, run, [=](std::size_t b, std::size_t e) {
+    std::sort(first + b, first + e);
+  }, threads);
+  for (; run < n; run *= 2) {
+    const std::size_t merges = (n + 2 * run - 1) / (2 * run);
+    parallel_for("metric::parallel_sort/merge", merges, 1, [=](std::size_t b, std::size_t e) {
+      for (std::size_t m = b; m < e; ++m) {
+        const std::size_t lo = m * 2 * run;
+        const std::size_t mid = std::min(n, lo + run);
+        const std::size_t hi = std::min(n, lo + 2 * run);
+        std::inplace_merge(first + lo, first + mid, first + hi);
+      }
+    }, threads);
+  }
+}
+
+/**
+ * \brief Return sum of `n` distances starting at `first`, computed in parallel.
+ *
+ * Partial sums are formed per chunk and added in chunk order, so the result
+ * does not depend on the number of threads (also for floating-point).
+ *
+ * \param first Pointer to first element.
+ * \param n Number of elements.
+ * \param threads Number of threads; 0 selects `parallel_default_threads()`.
+ **/
+template <class Repr, class Ratio>
+distance<Repr, Ratio> parallel_sum(const distance<Repr, Ratio>* first, std::size_t n, unsigned threads = 0) {
+  const std::size_t grain = parallel_default_grain;
+  std::vector<Repr> partial((n + grain - 1) / grain, Repr());
+  Repr* p = partial.data();
+  parallel_for("metric::parallel_sum", n, grain, [=](std::size_t b, std::size_t e) {
+    Repr s = Repr();
+    for (std::size_t i = b; i < e; ++i) s += first[i].count();
+    p[b / grain] = s;
+  }, threads);
+  Repr s = Repr();
+  for (const Repr& v : partial) s += v;
+  return distance<Repr, Ratio>(s);
+}
+
+/*! \brief Return sum of all distances in `in`, computed in parallel (see above). **/
+template <class T, class D = typename std::remove_cv<T>::type>
+typename std::enable_if<is_distance<D>::value, D>::type parallel_sum(strided_view<T> in, unsigned threads = 0) {
+  using Repr = typename D::repr;
+  const std::size_t grain = parallel_default_grain;
+  std::vector<Repr> partial((in.size() + grain - 1) / grain, Repr());
+  Repr* p = partial.data();
+  parallel_for("metric::parallel_sum", in.size(), grain, [=](std::size_t b, std::size_t e) {
+    Repr s = Repr();
+    for (std::size_t i = b; i < e; ++i) s += in[i].count();
+    p[b / grain] = s;
+  }, threads);
+  Repr s = Repr();
+  for (const Repr& v : partial) s += v;
+  return D(s);
+}
+
+/* Add the histogram of `n` elements to `counts`; `count(begin, end, sub)` counts a chunk into `sub`. */
+template <typename Distance, typename F>
+void __parallel_histogram_n(std::size_t n, const fixed_bins<Distance>& bins, std::uint64_t* counts, unsigned threads,
+                            F count) {
+  if (threads == 0) threads = parallel_default_threads();
+  const std::size_t grain = std::max((n + threads - 1) / threads, parallel_default_grain);
+  const std::size_t chunks = (n + grain - 1) / grain;
+  const std::size_t line = 64 / sizeof(std::uint64_t);
+  const std::size_t stride = (bins.bins() + 2 + line - 1) / line * line;
+  std::vector<std::uint64_t> sub(chunks * stride + line);
+  std::uint64_t* const s = sub.data() + (line - reinterpret_cast<std::uintptr_t>(sub.data()) / sizeof(std::uint64_t) % line) % line;
+  parallel_for("metric::parallel_histogram_n", n, grain, [=](std::size_t begin, std::size_t end) {
+    count(begin, end, s + begin / grain * stride);
+  }, threads);
+  for (std::size_t c = 0; c < chunks; ++c)
+    for (std::size_t k = 0; k < bins.bins() + 2; ++k) counts[k] += s[c * stride + k];
+}
+
+/**
+ * \brief Add the histogram of `n` distances starting at `first` to `counts`, computed in parallel.
+ *
+ * Every chunk (one per thread) is counted into its own sub-histogram, which
+ * are cache line aligned, so that threads never write to shared counters; the
+ * sub-histograms are added to `counts` at the end.
+ *
+ * \param first Pointer to first distance.
+ * \param n Number of elements.
+ * \param bins Bins of the histogram.
+ * \param counts Counts to add to, `bins.bins() + 2` elements (see metric_histogram.h).
+ * \param threads Number of threads; 0 selects `parallel_default_threads()`.
+ **/
+template <typename Distance>
+void parallel_histogram_n(const Distance* first, std::size_t n, const fixed_bins<Distance>& bins,
+                          std::uint64_t* counts, unsigned threads = 0) {
+  const fixed_bins<Distance>* const b = &bins;
+  __parallel_histogram_n(n, bins, counts, threads, [=](std::size_t begin, std::size_t end, std::uint64_t* sub) {
+    histogram_n(first + begin, end - begin, *b, sub);
+  });
+}
+
+/*! \brief Add the histogram of all distances in `in` to `counts`, computed in parallel (see above). **/
+template <typename T, typename Distance>
+void parallel_histogram_n(strided_view<T> in, const fixed_bins<Distance>& bins, std::uint64_t* counts,
+                          unsigned threads = 0) {
+  const fixed_bins<Distance>* const b = &bins;
+  __parallel_histogram_n(in.size(), bins, counts, threads, [=](std::size_t begin, std::size_t end, std::uint64_t* sub) {
+    histogram_n(in.subview(begin, end - begin), *b, sub);
+  });
+}
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_PARALLEL_H_
@@ -0,0 +1,313 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_polyline.h
+ * \brief  Encoded polyline (Google polyline algorithm) codec for point arrays.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * An encoded polyline is a sequence of coordinate pairs, each coordinate being
+ * a fixed-point integer `round(c * 10^precision)` stored as a zig-zag encoded
+ * delta to its predecessor in 5-bit ASCII chunks. Pairs are encoded in column
+ * order of the `point_array`, i.e., with the usual (lat, lon) convention the
+ * latitude goes into column 0.
+ *
+ * Coordinates are taken in units of the `distance` type of the point array.
+ * For floating-point representations the usual precisions 5 and 6 apply; for
+ * integral representations choose the ratio of the distance type to match the
+ * fixed-point resolution and use precision 0, so counts are transported
+ * verbatim without any multiplication or division.
+**/
+
+#ifndef METRIC_METRIC_POLYLINE_H_
+#define METRIC_METRIC_POLYLINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "metric_core.h"
+#include "metric_array.h"
+#include "metric_view.h"
+
+namespace metric {
+
+/** \brief Default precision of encoded polylines (Google Maps). **/
+constexpr unsigned polyline_default_precision = 5;
+
+namespace {  // anonymous namespace for polyline helpers
+
+constexpr unsigned __polyline_max_precision = 15;
+
+inline std::int64_t __polyline_pow10(unsigned precision) {
+  static const std::int64_t p[] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL,
+    1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL,
+    100000000000000LL, 1000000000000000LL,
+  };
+  if (precision > __polyline_max_precision)
+    throw std::invalid_argument("metric: polyline precision must be at most 15");
+  return p[precision];
+}
+
+/* Conversion between coordinate counts and fixed-point polyline integers. */
+template <typename Repr, bool = treat_as_floating_point<Repr>::value>
+struct __polyline_scale {
+  explicit __polyline_scale(unsigned precision)
+    : f_(static_cast<Repr>(__polyline_pow10(precision))), inv_(Repr(1) / f_) {}
+  inline std::int64_t encode(Repr c) const {
+    const Repr v = c * f_;
+    return static_cast<std::int64_t>(v < Repr(0) ? v - Repr(0.5) : v + Repr(0.5));
+  }
+  inline Repr decode(std::int64_t v) const { return static_cast<Repr>(v) * inv_; }
+  Repr f_, inv_;
+};
+
+template <typename Repr>
+struct __polyline_scale<Repr, false> {
+  explicit __polyline_scale(unsigned precision) : f_(__polyline_pow10(precision)) {}
+  inline std::int64_t encode(Repr c) const { return static_cast<std::int64_t>(c) * f_; }
+  inline Repr decode(std::int64_t v) const {
+    // round half away from zero, as `encode` of floating-point coordinates
+    const std::int64_t q = v / f_, r = v % f_;
+    return static_cast<Repr>(2 * (r < 0 ? -r : r) >= f_ && f_ > 1 ? (v < 0 ? q - 1 : q + 1) : q);
+  }
+  std::int64_t f_;
+};
+
+inline char* __polyline_put(std::int64_t delta, char* out) {
+  std::uint64_t z = (static_cast<std::uint64_t>(delta) << 1) ^
+                    static_cast<std::uint64_t>(delta >> 63);
+  while (z >= 0x20) {
+    *out++ = static_cast<char>((0x20 | (z & 0x1f)) + 63);
+    z >>= 5;
+  }
+  *out++ = static_cast<char>(z + 63);
+  return out;
+}
+
+/*
+ * Decode one value of at most 13 characters; `CheckEnd` selects whether `p`
+ * may run into `end`, callers with enough characters left can skip the check.
+ */
+template <bool CheckEnd>
+inline std::int64_t __polyline_get(const char*& p, const char* end) {
+  std::uint64_t r = 0;
+  unsigned shift = 0;
+  std::uint64_t b;
+  do {
+    if (shift > 60)
+      throw std::runtime_error("metric: invalid encoded polyline");
+    if (CheckEnd && p == end)
+      throw std::runtime_error("metric: truncated encoded polyline");
+    b = static_cast<std::uint64_t>(static_cast<unsigned char>(*p++)) - 63;
+    if (b > 63)
+      throw std::runtime_error("metric: invalid encoded polyline");
+    r |= (b & 0x1f) << shift;
+    shift += 5;
+  } while (b >= 0x20);
+  return static_cast<std::int64_t>(r >> 1) ^ -static_cast<std::int64_t>(r & 1);
+}
+
+/*
+ * Decode `len` characters at `s` into `x` and `y`, which must provide room for
+ * `len / 2` points. Returns the number of decoded points.
+ */
+template <typename Distance>
+inline std::size_t __polyline_decode(const char* s, std::size_t len,
+                                     const __polyline_scale<typename Distance::repr>& scale,
+                                     Distance* x, Distance* y) {
+  // longest encoding of a pair of 64 bit values, below which we check bounds
+  constexpr std::size_t max_pair = 2 * 13;
+  const char* p = s;
+  const char* end = s + len;
+  std::int64_t vx = 0, vy = 0;
+  std::size_t n = 0;
+  while (end - p >= static_cast<std::ptrdiff_t>(max_pair)) {
+    vx += __polyline_get<false>(p, end);
+    vy += __polyline_get<false>(p, end);
+    x[n] = Distance(scale.decode(vx));
+    y[n] = Distance(scale.decode(vy));
+    ++n;
+  }
+  while (p != end) {
+    vx += __polyline_get<true>(p, end);
+    vy += __polyline_get<true>(p, end);
+    x[n] = Distance(scale.decode(vx));
+    y[n] = Distance(scale.decode(vy));
+    ++n;
+  }
+  return n;
+}
+
+}  // namespace
+
+/* @{ encoding */
+
+/**
+ * \brief Append encoded polyline of the points (`x[i]`, `y[i]`) to `out`.
+ * \tparam Distance `distance` type of the coordinates (may be `const`).
+ * \param x View of first coordinates.
+ * \param y View of second coordinates; must have the same size as `x`.
+ * \param out String to append to.
+ * \param precision Number of decimal places of the fixed-point encoding.
+ * \throws std::invalid_argument if the precision exceeds 15 or sizes differ.
+ **/
+template <typename Distance>
+void polyline_encode(strided_distance_view<Distance> x, strided_distance_view<Distance> y,
+                     std::string& out, unsigned precision = polyline_default_precision) {
+  using D = typename std::remove_cv<Distance>::type;
+  if (x.size() != y.size())
+    throw std::invalid_argument("metric: polyline coordinates differ in size");
+  const __polyline_scale<typename D::repr> scale(precision);
+  const std::size_t base = out.size();
+  out.resize(base + x.size() * 2 * 13);
+  char* p = &out[0] + base;
+  std::int64_t px = 0, py = 0;
+  for (std::size_t i = 0; i < x.size(); ++i) {
+    const std::int64_t vx = scale.encode(x[i].count());
+    const std::int64_t vy = scale.encode(y[i].count());
+    p = __polyline_put(vx - px, p);
+    p = __polyline_put(vy - py, p);
+    px = vx;
+    py = vy;
+  }
+  out.resize(static_cast<std::size_t>(p - out.data()));
+}
+
+/**
+ * \brief Return encoded polyline of the first two columns of `points`.
+ * \param points Points to encode.
+ * \param precision Number of decimal places of the fixed-point encoding.
+ * \throws std::invalid_argument if the precision exceeds 15.
+ **/
+template <typename Distance, std::size_t Dims, typename Alloc>
+std::string polyline_encode(const point_array<Distance, Dims, Alloc>& points,
+                            unsigned precision = polyline_default_precision) {
+  static_assert(Dims >= 2, "polyline encoding requires two coordinates");
+  std::string s;
+  polyline_encode(points.column(0).view(), points.column(1).view(), s, precision);
+  return s;
+}
+
+/* encoding @} */
+
+/* @{ decoding */
+
+/**
+ * \brief Append points of the encoded polyline `s` to `out`.
+ * \param s Pointer to encoded polyline.
+ * \param len Length of encoded polyline in characters.
+ * \param out Point array to append to (first two columns, others are zeroed).
+ * \param precision Number of decimal places of the fixed-point encoding.
+ * \return Number of decoded points.
+ * \throws std::runtime_error if the polyline is malformed; `out` is unchanged then.
+ **/
+template <typename Distance, std::size_t Dims, typename Alloc>
+std::size_t polyline_decode(const char* s, std::size_t len, point_array<Distance, Dims, Alloc>& out,
+                            unsigned precision = polyline_default_precision) {
+  static_assert(Dims >= 2, "polyline decoding requires two coordinates");
+  const __polyline_scale<typename Distance::repr> scale(precision);
+  const std::size_t base = out.size();
+  out.append_uninitialized(len / 2);
+  std::size_t n;
+  try {
+    n = __polyline_decode(s, len, scale, out.column(0).data() + base, out.column(1).data() + base);
+  } catch (...) {
+    out.resize(base);
+    throw;
+  }
+  out.resize(base + n);
+  for (std::size_t d = 2; d < Dims; ++d)
+    for (std::size_t i = base; i < base + n; ++i)
+      out.column(d)[i] = Distance(typename Distance::repr());
+  return n;
+}
+
+/**
+ * \brief Append points of the encoded polyline `s` to `out`.
+ * \param s Encoded polyline.
+ * \param out Point array to append to.
+ * \param precision Number of decimal places of the fixed-point encoding.
+ * \return Number of decoded points.
+ * \throws std::runtime_error if the polyline is malformed.
+ **/
+template <typename Distance, std::size_t Dims, typename Alloc>
+std::size_t polyline_decode(const std::string& s, point_array<Distance, Dims, Alloc>& out,
+                            unsigned precision = polyline_default_precision) {
+  return polyline_decode(s.data(), s.size(), out, precision);
+}
+
+/**
+ * \brief Decode a batch of encoded polylines into one `point_array`.
+ *
+ * The output is grown exactly once for the whole batch (by an upper bound of
+ * the number of points) and trimmed at the end; no per-polyline allocations
+ * take place.
+ *
+ * \tparam StringIt Iterator over strings with `data()` and `size()` members
+ *                  (e.g., `std::string` or `std::string_view`).
+ * \param first Iterator to first polyline.
+ * \param last Iterator past the last polyline.
+ * \param out Point array to append to.
+ * \param offsets If not `nullptr`, receives the index of the first point of
+ *                each polyline in `out`, plus an end sentinel.
+ * \param precision Number of decimal places of the fixed-point encoding.
+ * \throws std::runtime_error if any polyline is malformed; `out` is unchanged then.
+ **/
+template <typename StringIt, typename Distance, std::size_t Dims, typename Alloc>
+void polyline_decode(StringIt first, StringIt last, point_array<Distance, Dims, Alloc>& out,
+                     std::vector<std::size_t>* offsets = nullptr,
+                     unsigned precision = polyline_default_precision) {
+  static_assert(Dims >= 2, "polyline decoding requires two coordinates");
+  const __polyline_scale<typename Distance::repr> scale(precision);
+  std::size_t bound = 0, count = 0;
+  for (StringIt it = first; it != last; ++it, ++count) bound += it->size() / 2;
+  const std::size_t base = out.size();
+  out.append_uninitialized(bound);
+  if (offsets) {
+    offsets->clear();
+    offsets->reserve(count + 1);
+  }
+  std::size_t n = base;
+  try {
+    for (StringIt it = first; it != last; ++it) {
+      if (offsets) offsets->push_back(n);
+      n += __polyline_decode(it->data(), it->size(), scale,
+                             out.column(0).data() + n, out.column(1).data() + n);
+    }
+  } catch (...) {
+    out.resize(base);
+    throw;
+  }
+  if (offsets) offsets->push_back(n);
+  out.resize(n);
+  for (std::size_t d = 2; d < Dims; ++d)
+    for (std::size_t i = base; i < n; ++i)
+      out.column(d)[i] = Distance(typename Distance::repr());
+}
+
+/* decoding @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_POLYLINE_H_
@@ -0,0 +1,263 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_ranges.h
+ * \brief  Lazy range adaptors for unit conversion and fused reductions.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * `views::as<To>` casts the elements of a range of distances lazily,
+ * `views::counts` yields their counts and `views::from_counts<D>` turns counts
+ * into distances. All three are `std::views::transform` adaptors, so they
+ * compose with each other and the standard views:
+ *
+ * ~~~{.cpp}
+ * std::vector<metric::millimeters<int32_t>> ranges = ...;
+ * auto total = metric::ranges::sum(ranges | metric::views::as<metric::meters<double>>);
+ * ~~~
+ *
+ * The reductions in `metric::ranges` and `distance_cast_n` recognize chains of
+ * these adaptors over contiguous ranges and run a single loop over the
+ * underlying array with the conversions inlined; no intermediate buffers are
+ * created. Other ranges are reduced element by element. Requires C++20.
+**/
+
+#ifndef METRIC_METRIC_RANGES_H_
+#define METRIC_METRIC_RANGES_H_
+
+#if __cplusplus < 202002L
+#error "metric_ranges.h requires C++20"
+#endif
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "metric_core.h"
+#include "metric_bulk.h"
+#include "metric_view.h"
+
+namespace metric {
+
+namespace {  // anonymous namespace for adaptor functions and fusion helpers
+
+template <typename To>
+struct __as_fn {
+  template <typename Repr, typename Ratio>
+  constexpr To operator()(const distance<Repr, Ratio>& d) const { return distance_cast<To>(d); }
+};
+
+struct __counts_fn {
+  template <typename Repr, typename Ratio>
+  constexpr Repr operator()(const distance<Repr, Ratio>& d) const { return d.count(); }
+};
+
+template <typename Distance>
+struct __from_counts_fn {
+  constexpr Distance operator()(const typename Distance::repr& c) const { return Distance(c); }
+};
+
+/* Stateless element functions of the adaptors, which can be fused. */
+template <typename F> struct __fusable_fn : std::false_type {};
+template <typename To> struct __fusable_fn<__as_fn<To>> : std::true_type {};
+template <> struct __fusable_fn<__counts_fn> : std::true_type {};
+template <typename Distance> struct __fusable_fn<__from_counts_fn<Distance>> : std::true_type {};
+
+/* Chains of adaptors over a contiguous, sized range. */
+template <typename R>
+struct __fused_range : std::bool_constant<std::ranges::contiguous_range<const R> && std::ranges::sized_range<const R>> {};
+template <typename V, typename F>
+struct __fused_range<std::ranges::transform_view<V, F>>
+  : std::bool_constant<__fusable_fn<F>::value && std::copy_constructible<V> && __fused_range<V>::value> {};
+
+/* Element function `F` applied after `g`. */
+template <typename F, typename G>
+struct __compose_fn {
+  G g;
+  template <typename T>
+  constexpr decltype(auto) operator()(const T& x) const { return F()(g(x)); }
+};
+
+/* Call `k(p, n, f)` with the underlying array `p[0, n)` of `r` and the composed element function `f`. */
+template <typename R, typename K>
+constexpr decltype(auto) __fuse(const R& r, K&& k) {
+  return k(std::ranges::data(r), static_cast<std::size_t>(std::ranges::size(r)), std::identity());
+}
+
+template <typename V, typename F, typename K>
+constexpr decltype(auto) __fuse(const std::ranges::transform_view<V, F>& r, K&& k) {
+  const V base = r.base();
+  return __fuse(base, [&k](const auto* p, std::size_t n, auto g) { return k(p, n, __compose_fn<F, decltype(g)>{g}); });
+}
+
+/* Number of partial sums of the fused reductions (as in the compiled kernels). */
+constexpr std::size_t __ranges_lanes = 8;
+
+template <typename T>
+constexpr auto __ranges_count(const T& x) {
+  if constexpr (is_distance<T>::value) return x.count();
+  else return x;
+}
+
+template <typename T>
+using __ranges_count_t = decltype(__ranges_count(std::declval<T>()));
+
+template <typename T, typename U, typename F>
+constexpr T __fused_sum(const U* p, std::size_t n, F f) {
+  using C = __ranges_count_t<T>;
+  C acc[__ranges_lanes] = {};
+  std::size_t i = 0;
+  for (; i + __ranges_lanes <= n; i += __ranges_lanes)
+    for (std::size_t k = 0; k < __ranges_lanes; ++k) acc[k] += __ranges_count(f(p[i + k]));
+  C s = ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+  for (; i < n; ++i) s += __ranges_count(f(p[i]));
+  return T(s);
+}
+
+template <typename T, typename U, typename F>
+constexpr std::pair<T, T> __fused_minmax(const U* p, std::size_t n, F f) {
+  using C = __ranges_count_t<T>;
+  C lo = __ranges_count(f(p[0])), hi = lo;
+  for (std::size_t i = 1; i < n; ++i) {
+    const C c = __ranges_count(f(p[i]));
+    lo = c < lo ? c : lo;
+    hi = hi < c ? c : hi;
+  }
+  return std::pair<T, T>(T(lo), T(hi));
+}
+
+template <typename T> struct __is_strided_view : std::false_type {};
+template <typename T> struct __is_strided_view<strided_view<T>> : std::true_type {};
+
+}  // namespace
+
+/* @{ range adaptors */
+
+namespace views {
+
+/** \brief Range adaptor casting distances to `To` lazily (see `distance_cast`). **/
+template <typename To>
+inline constexpr auto as = std::views::transform(__as_fn<To>());
+
+/** \brief Range adaptor yielding the counts of distances. **/
+inline constexpr auto counts = std::views::transform(__counts_fn());
+
+/** \brief Range adaptor yielding distances of type `Distance` from counts. **/
+template <typename Distance>
+inline constexpr auto from_counts = std::views::transform(__from_counts_fn<Distance>());
+
+}  // namespace views
+
+/* range adaptors @} */
+
+/* @{ fused reductions */
+
+namespace ranges {
+
+/**
+ * \brief Return sum of the elements of `r`, distances or counts.
+ *
+ * Chains of `views` adaptors over contiguous ranges are summed in a single
+ * pass over the underlying array using eight partial sums, in the same fixed
+ * order as the compiled kernels (floating-point results may therefore differ
+ * in the last bits from a sequential sum).
+ *
+ * \param r Range to sum.
+ **/
+template <std::ranges::input_range R>
+constexpr std::ranges::range_value_t<R> sum(R&& r) {
+  using T = std::ranges::range_value_t<R>;
+  if constexpr (__fused_range<std::remove_cvref_t<R>>::value) {
+    return __fuse(r, [](const auto* p, std::size_t n, auto f) { return __fused_sum<T>(p, n, f); });
+  } else {
+    __ranges_count_t<T> s = {};
+    for (auto&& x : r) s += __ranges_count(x);
+    return T(s);
+  }
+}
+
+/**
+ * \brief Return minimum and maximum of the elements of `r`, distances or counts.
+ * \param r Non-empty range.
+ * \throws std::out_of_range if `r` is empty.
+ **/
+template <std::ranges::input_range R>
+constexpr std::pair<std::ranges::range_value_t<R>, std::ranges::range_value_t<R>> minmax(R&& r) {
+  using T = std::ranges::range_value_t<R>;
+  using C = __ranges_count_t<T>;
+  if constexpr (__fused_range<std::remove_cvref_t<R>>::value) {
+    return __fuse(r, [](const auto* p, std::size_t n, auto f) {
+      if (n == 0) throw std::out_of_range("metric: minmax of empty range");
+      return __fused_minmax<T>(p, n, f);
+    });
+  } else {
+    auto it = std::ranges::begin(r);
+    const auto last = std::ranges::end(r);
+    if (it == last) throw std::out_of_range("metric: minmax of empty range");
+    C lo = __ranges_count(*it), hi = lo;
+    for (++it; it != last; ++it) {
+      const C c = __ranges_count(*it);
+      lo = c < lo ? c : lo;
+      hi = hi < c ? c : hi;
+    }
+    return std::pair<T, T>(T(lo), T(hi));
+  }
+}
+
+}  // namespace ranges
+
+/* fused reductions @} */
+
+/* @{ distance_cast_n */
+
+/**
+ * \brief Cast the distances of `r` to `ToDistance` and store them to `out`.
+ *
+ * Chains of `views` adaptors over contiguous ranges are converted in a single
+ * pass over the underlying array.
+ *
+ * \param r Sized range of distances.
+ * \param out Pointer to first output element.
+ **/
+template <class ToDistance, std::ranges::input_range R>
+  requires(is_distance<ToDistance>::value && is_distance<std::ranges::range_value_t<R>>::value &&
+           !__is_strided_view<std::remove_cvref_t<R>>::value)
+void distance_cast_n(R&& r, ToDistance* out) {
+  if constexpr (__fused_range<std::remove_cvref_t<R>>::value) {
+    __fuse(r, [out](const auto* p, std::size_t n, auto f) {
+      if constexpr (std::is_same<decltype(f), std::identity>::value) {
+        distance_cast_n<ToDistance>(p, n, out);
+      } else {
+        for (std::size_t i = 0; i < n; ++i) out[i] = distance_cast<ToDistance>(f(p[i]));
+      }
+    });
+  } else {
+    for (auto&& x : r) *out++ = distance_cast<ToDistance>(x);
+  }
+}
+
+/* distance_cast_n @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_RANGES_H_
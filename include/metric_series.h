@@ -0,0 +1,292 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_series.h
+ * \brief  Timestamped distance series with as-of lookup and interpolation.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * `distance_series` stores timestamps and distances in separate, sorted
+ * columns. Lookups use a branchless binary search; batched lookups run
+ * several searches in lockstep, so their cache misses overlap instead of
+ * being serialized by mispredicted branches as with `std::lower_bound`:
+ *
+ * ~~~{.cpp}
+ * metric::distance_series<metric::millimeters<int64_t>> odometer;
+ * odometer.push_back(t0, metric::millimeters<int64_t>(0));
+ * odometer.push_back(t0 + std::chrono::seconds(1), metric::millimeters<int64_t>(1000));
+ * odometer.interpolate(t0 + std::chrono::milliseconds(250));  // 250 mm
+ * ~~~
+**/
+
+#ifndef METRIC_METRIC_SERIES_H_
+#define METRIC_METRIC_SERIES_H_
+
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "metric_core.h"
+#include "metric_array.h"
+
+namespace metric {
+
+namespace {  // anonymous namespace for search and interpolation helpers
+
+/* Number of searches run in lockstep by the batched lookups. */
+constexpr std::size_t __series_lanes = 8;
+
+/* Index of the last element of `t[0, n)` not greater than `q`, assuming `t[0] <= q` and `n > 0`. */
+template <typename T>
+inline std::size_t __branchless_as_of(const T* t, std::size_t n, const T& q) {
+  std::size_t base = 0;
+  while (n > 1) {
+    const std::size_t half = n / 2;
+    base = t[base + half] <= q ? base + half : base;
+    n -= half;
+  }
+  return base;
+}
+
+/* `__branchless_as_of` for `__series_lanes` queries at once. */
+template <typename T>
+inline void __branchless_as_of_lanes(const T* t, std::size_t n, const T* q, std::size_t* out) {
+  std::size_t base[__series_lanes] = { 0 };
+  while (n > 1) {
+    const std::size_t half = n / 2;
+    for (std::size_t k = 0; k < __series_lanes; ++k)
+      base[k] = t[base[k] + half] <= q[k] ? base[k] + half : base[k];
+    n -= half;
+  }
+  for (std::size_t k = 0; k < __series_lanes; ++k) out[k] = base[k];
+}
+
+/* Linear interpolation `d0 + (d1 - d0) * num / den`, rounded to nearest for integral representations. */
+template <typename Repr>
+inline typename std::enable_if<treat_as_floating_point<Repr>::value, Repr>::type
+__series_lerp(Repr d0, Repr d1, double num, double den) {
+  return d0 + static_cast<Repr>((d1 - d0) * (num / den));
+}
+
+template <typename Repr>
+inline typename std::enable_if<!treat_as_floating_point<Repr>::value, Repr>::type
+__series_lerp(Repr d0, Repr d1, double num, double den) {
+  // step away from d0 by the rounded magnitude, so that unsigned values never see a negative offset
+  const double x = (static_cast<double>(d1) - static_cast<double>(d0)) * num / den;
+  return x < 0.0 ? d0 - static_cast<Repr>(0.5 - x) : d0 + static_cast<Repr>(x + 0.5);
+}
+
+/* Value at time `x` of the samples `t`, `v` of length `n`, given that `k` is the last sample at or before `x`. */
+template <typename T, typename Distance>
+inline Distance __series_value_at(const T* t, const Distance* v, std::size_t n, std::size_t k, const T& x) {
+  if (k + 1 == n || t[k] == x) return v[k];
+  return Distance(__series_lerp(v[k].count(), v[k + 1].count(), static_cast<double>((x - t[k]).count()),
+                                static_cast<double>((t[k + 1] - t[k]).count())));
+}
+
+}  // namespace
+
+/**
+ * \brief Series of distances at ascending points in time.
+ *
+ * Values are piecewise linear between samples and held constant before the
+ * first and after the last sample.
+ *
+ * \tparam Distance `distance` type of the values.
+ * \tparam Clock Clock of the timestamps.
+ * \tparam Duration Duration of the timestamps.
+ **/
+template <typename Distance, typename Clock = std::chrono::steady_clock,
+          typename Duration = typename Clock::duration>
+class distance_series {
+  static_assert(is_distance<Distance>::value, "distance_series requires a distance type");
+
+ public:
+  using distance_type = Distance;                                ///< \brief Value type.
+  using clock = Clock;                                           ///< \brief Clock type.
+  using duration = Duration;                                     ///< \brief Duration type.
+  using time_point = std::chrono::time_point<Clock, Duration>;   ///< \brief Timestamp type.
+  using size_type = std::size_t;                                 ///< \brief Size type.
+
+  /** \brief Result of `as_of` for times before the first sample. **/
+  static constexpr size_type npos = static_cast<size_type>(-1);
+
+  /*! \brief Return number of samples. **/
+  size_type size() const noexcept { return times_.size(); }
+  /*! \brief Return true, if there are no samples. **/
+  bool empty() const noexcept { return times_.empty(); }
+  /*! \brief Return pointer to the timestamp column. **/
+  const time_point* times() const noexcept { return times_.data(); }
+  /*! \brief Return pointer to the distance column. **/
+  const Distance* values() const noexcept { return values_.data(); }
+  /*! \brief Return timestamp of sample `i`. **/
+  time_point time(size_type i) const noexcept { return times_[i]; }
+  /*! \brief Return distance of sample `i`. **/
+  Distance value(size_type i) const noexcept { return values_.data()[i]; }
+
+  /*! \brief Reserve memory for `n` samples. **/
+  void reserve(size_type n) {
+    times_.reserve(n);
+    values_.reserve(n);
+  }
+
+  /*! \brief Remove all samples. **/
+  void clear() noexcept {
+    times_.clear();
+    values_.clear();
+  }
+
+  /**
+   * \brief Append sample `d` at time `t`.
+   * \throws std::invalid_argument if `t` is earlier than the last sample.
+   **/
+  void push_back(time_point t, const Distance& d) {
+    if (!times_.empty() && t < times_.back())
+      throw std::invalid_argument("metric: distance_series timestamps must be ascending");
+    times_.push_back(t);
+    try {
+      values_.push_back(d);
+    } catch (...) {
+      times_.pop_back();
+      throw;
+    }
+  }
+
+  /* @{ lookup */
+
+  /*! \brief Return index of the last sample at or before `t`, or `npos`. **/
+  size_type as_of(time_point t) const noexcept {
+    if (times_.empty() || t < times_.front()) return npos;
+    return __branchless_as_of(times_.data(), times_.size(), t);
+  }
+
+  /**
+   * \brief Batched `as_of` of `n` queries.
+   * \param q Pointer to `n` query times (in any order).
+   * \param n Number of queries.
+   * \param out Pointer to `n` output indices.
+   **/
+  void as_of_n(const time_point* q, size_type n, size_type* out) const noexcept {
+    const size_type m = times_.size();
+    size_type i = 0;
+    if (m) {
+      time_point lanes[__series_lanes];
+      for (; i + __series_lanes <= n; i += __series_lanes) {
+        // clamp to the first sample, so all lanes can share one search
+        for (size_type k = 0; k < __series_lanes; ++k)
+          lanes[k] = q[i + k] < times_.front() ? times_.front() : q[i + k];
+        __branchless_as_of_lanes(times_.data(), m, lanes, out + i);
+        for (size_type k = 0; k < __series_lanes; ++k)
+          if (q[i + k] < times_.front()) out[i + k] = npos;
+      }
+    }
+    for (; i < n; ++i) out[i] = as_of(q[i]);
+  }
+
+  /* lookup @} */
+
+  /* @{ interpolation */
+
+  /**
+   * \brief Return linearly interpolated distance at time `t`.
+   * \throws std::out_of_range if the series is empty.
+   **/
+  Distance interpolate(time_point t) const {
+    if (times_.empty()) throw std::out_of_range("metric: interpolate on empty distance_series");
+    return interpolate_at(as_of(t), t);
+  }
+
+  /**
+   * \brief Batched `interpolate` of `n` queries.
+   * \param q Pointer to `n` query times (in any order).
+   * \param n Number of queries.
+   * \param out Pointer to `n` output distances.
+   * \throws std::out_of_range if the series is empty and `n > 0`.
+   **/
+  void interpolate_n(const time_point* q, size_type n, Distance* out) const {
+    if (n && times_.empty()) throw std::out_of_range("metric: interpolate on empty distance_series");
+    size_type idx[__series_lanes];
+    for (size_type i = 0; i < n; i += __series_lanes) {
+      const size_type m = n - i < __series_lanes ? n - i : __series_lanes;
+      as_of_n(q + i, m, idx);
+      for (size_type k = 0; k < m; ++k) out[i + k] = interpolate_at(idx[k], q[i + k]);
+    }
+  }
+
+  /* interpolation @} */
+
+ private:
+  /* Interpolate at `t`, given `i = as_of(t)`. */
+  Distance interpolate_at(size_type i, time_point t) const noexcept {
+    if (i == npos) return values_.front();
+    return __series_value_at(times_.data(), values_.data(), times_.size(), i, t);
+  }
+
+  std::vector<time_point> times_;
+  distance_array<Distance> values_;
+};
+
+template <typename Distance, typename Clock, typename Duration>
+constexpr typename distance_series<Distance, Clock, Duration>::size_type distance_series<Distance, Clock, Duration>::npos;
+
+/**
+ * \brief Resample two series onto their common timebase.
+ *
+ * The timebase consists of all timestamps of `a` and `b` in the interval in
+ * which both series are defined; each series is interpolated at the
+ * timestamps of the other. Both series are traversed once, without searches.
+ *
+ * \param a First series.
+ * \param b Second series.
+ * \return Pair of resampled series with identical timestamps; both empty, if
+ *         the series do not overlap.
+ **/
+template <typename D1, typename D2, typename Clock, typename Duration>
+std::pair<distance_series<D1, Clock, Duration>, distance_series<D2, Clock, Duration>>
+merge_resample(const distance_series<D1, Clock, Duration>& a, const distance_series<D2, Clock, Duration>& b) {
+  using time_point = std::chrono::time_point<Clock, Duration>;
+  std::pair<distance_series<D1, Clock, Duration>, distance_series<D2, Clock, Duration>> r;
+  if (a.empty() || b.empty()) return r;
+  const time_point first = a.time(0) < b.time(0) ? b.time(0) : a.time(0);
+  const time_point last = a.time(a.size() - 1) < b.time(b.size() - 1) ? a.time(a.size() - 1) : b.time(b.size() - 1);
+  if (last < first) return r;
+  // first samples at or after `first`, and samples of each series at or before the current time
+  std::size_t i = a.as_of(first), j = b.as_of(first);
+  std::size_t ni = a.time(i) < first ? i + 1 : i, nj = b.time(j) < first ? j + 1 : j;
+  r.first.reserve(a.size() - ni + b.size() - nj);
+  r.second.reserve(a.size() - ni + b.size() - nj);
+  for (;;) {
+    const bool more_a = ni < a.size() && !(last < a.time(ni));
+    const bool more_b = nj < b.size() && !(last < b.time(nj));
+    if (!more_a && !more_b) break;
+    const time_point t = !more_b || (more_a && a.time(ni) < b.time(nj)) ? a.time(ni) : b.time(nj);
+    while (ni < a.size() && a.time(ni) <= t) i = ni++;
+    while (nj < b.size() && b.time(nj) <= t) j = nj++;
+    r.first.push_back(t, __series_value_at(a.times(), a.values(), a.size(), i, t));
+    r.second.push_back(t, __series_value_at(b.times(), b.values(), b.size(), j, t));
+  }
+  return r;
+}
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_SERIES_H_
@@ -0,0 +1,347 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_snapshot.h
+ * \brief  Versioned binary snapshots of distance containers.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * A snapshot consists of a 64 byte header followed by a number of columns of
+ * raw distance counts, each starting at a 64 byte boundary:
+ *
+ * | Offset | Type       | Content                                        |
+ * |--------|------------|------------------------------------------------|
+ * | 0      | `char[8]`  | magic `"METRICSN"`                             |
+ * | 8      | `uint32`   | format version (`snapshot_version`)            |
+ * | 12     | `uint32`   | kind of state (`snapshot_kind`)                |
+ * | 16     | `uint32`   | representation: 0 signed, 1 unsigned, 2 float  |
+ * | 20     | `uint32`   | size of representation in bytes                |
+ * | 24     | `int64`    | numerator of the distance ratio                |
+ * | 32     | `int64`    | denominator of the distance ratio              |
+ * | 40     | `uint64`   | number of elements per column                  |
+ * | 48     | `uint32`   | number of columns                              |
+ *
+ * All values are little-endian. Since the payload is the in-memory layout of
+ * the columns, a snapshot is restored by mapping it (`mapped_snapshot`); no
+ * parsing takes place.
+**/
+
+#ifndef METRIC_METRIC_SNAPSHOT_H_
+#define METRIC_METRIC_SNAPSHOT_H_
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "metric_core.h"
+#include "metric_array.h"
+#include "metric_mmap.h"
+#include "metric_view.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "metric_snapshot.h maps little-endian snapshots in place and requires a little-endian host"
+#endif
+
+namespace metric {
+
+/** \brief Current version of the snapshot format. **/
+constexpr std::uint32_t snapshot_version = 1;
+
+/** \brief Kinds of state stored in snapshots. **/
+enum class snapshot_kind : std::uint32_t {
+  columns = 1,  ///< \brief `distance_array` (one column) or `point_array`.
+};
+
+namespace {  // anonymous namespace for snapshot helpers
+
+constexpr std::size_t __snapshot_align = 64;
+
+struct __snapshot_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t kind;
+  std::uint32_t repr_kind;
+  std::uint32_t repr_size;
+  std::int64_t ratio_num;
+  std::int64_t ratio_den;
+  std::uint64_t count;
+  std::uint32_t columns;
+  std::uint32_t reserved[3];
+};
+
+static_assert(sizeof(__snapshot_header) == __snapshot_align, "snapshot header must fill one block");
+
+template <typename Distance>
+inline __snapshot_header __snapshot_make_header(snapshot_kind kind, std::uint64_t count,
+                                                std::uint32_t columns) {
+  using repr = typename Distance::repr;
+  static_assert(std::is_arithmetic<repr>::value, "snapshots require arithmetic representations");
+  __snapshot_header h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, "METRICSN", 8);
+  h.version = snapshot_version;
+  h.kind = static_cast<std::uint32_t>(kind);
+  // bit layout in the low bits; integers treated as floating-point are flagged
+  // separately, since they do not round like their plain counterparts
+  h.repr_kind = (std::is_floating_point<repr>::value ? 2 : std::is_signed<repr>::value ? 0 : 1) |
+                (treat_as_floating_point<repr>::value && !std::is_floating_point<repr>::value ? 4 : 0);
+  h.repr_size = sizeof(repr);
+  h.ratio_num = Distance::ratio::num;
+  h.ratio_den = Distance::ratio::den;
+  h.count = count;
+  h.columns = columns;
+  return h;
+}
+
+inline std::size_t __snapshot_padded(std::size_t bytes) {
+  return (bytes + __snapshot_align - 1) / __snapshot_align * __snapshot_align;
+}
+
+[[noreturn]] inline void __snapshot_fail_errno(const char* what, const std::string& path) {
+  throw std::system_error(errno, std::generic_category(),
+                          std::string("metric: ") + what + " '" + path + "'");
+}
+
+/* Flush the directory entries of the directory containing `path` to disk. */
+inline void __snapshot_sync_directory(const std::string& path) {
+  const std::string::size_type slash = path.rfind('/');
+  const std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+  const int fd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) __snapshot_fail_errno("cannot open directory", dir);
+  // some file systems do not support syncing directories
+  const int err = ::fsync(fd) != 0 && errno != EINVAL ? errno : 0;
+  ::close(fd);
+  if (err) {
+    errno = err;
+    __snapshot_fail_errno("cannot flush directory", dir);
+  }
+}
+
+/*
+ * Write header and columns (pointer, size in bytes) to `path` atomically: the
+ * data goes to a unique temporary file in the same directory, is flushed to
+ * disk and renamed over `path`, then the directory is flushed.
+ */
+inline void __snapshot_write(const std::string& path, const __snapshot_header& h,
+                             const std::vector<std::pair<const void*, std::size_t>>& columns) {
+  std::vector<char> name(path.begin(), path.end());
+  const char suffix[] = ".XXXXXX";
+  name.insert(name.end(), suffix, suffix + sizeof(suffix));
+  const int fd = ::mkstemp(name.data());
+  const std::string tmp(name.data());
+  if (fd < 0) __snapshot_fail_errno("cannot create", tmp);
+  auto fail = [&](const char* what, int err) {
+    ::unlink(tmp.c_str());
+    errno = err;
+    __snapshot_fail_errno(what, tmp);
+  };
+  if (::fcntl(fd, F_SETFD, FD_CLOEXEC) != 0 || ::fchmod(fd, 0644) != 0) {
+    const int err = errno;
+    ::close(fd);
+    fail("cannot create", err);
+  }
+  static const unsigned char zeros[__snapshot_align] = {};
+  auto put = [&](const void* data, std::size_t n) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    while (n > 0) {
+      const ssize_t w = ::write(fd, p, n);
+      if (w < 0) {
+        if (errno == EINTR) continue;
+        const int err = errno;
+        ::close(fd);
+        fail("cannot write", err);
+      }
+      p += w;
+      n -= static_cast<std::size_t>(w);
+    }
+  };
+  put(&h, sizeof(h));
+  for (const auto& c : columns) {
+    put(c.first, c.second);
+    put(zeros, __snapshot_padded(c.second) - c.second);
+  }
+  // close in any case, report the first error
+  int err = ::fsync(fd) != 0 ? errno : 0;
+  if (::close(fd) != 0 && !err) err = errno;
+  if (err) fail("cannot flush", err);
+  if (::rename(tmp.c_str(), path.c_str()) != 0) fail("cannot rename", errno);
+  __snapshot_sync_directory(path);
+}
+
+/* Validate header of mapped snapshot `f` against `expected` (count is ignored). */
+inline const __snapshot_header& __snapshot_check(const mapped_file& f, const __snapshot_header& expected,
+                                                 const std::string& path) {
+  if (f.size() < sizeof(__snapshot_header))
+    throw std::runtime_error("metric: not a snapshot '" + path + "'");
+  const __snapshot_header& h = *reinterpret_cast<const __snapshot_header*>(f.data());
+  if (std::memcmp(h.magic, expected.magic, sizeof(h.magic)) != 0)
+    throw std::runtime_error("metric: not a snapshot '" + path + "'");
+  if (h.version != expected.version)
+    throw std::runtime_error("metric: unsupported snapshot version '" + path + "'");
+  if (h.kind != expected.kind || h.repr_kind != expected.repr_kind ||
+      h.repr_size != expected.repr_size || h.ratio_num != expected.ratio_num ||
+      h.ratio_den != expected.ratio_den)
+    throw std::runtime_error("metric: snapshot type mismatch '" + path + "'");
+  const std::size_t column_bytes = __snapshot_padded(static_cast<std::size_t>(h.count) * h.repr_size);
+  if (h.count > f.size() || (f.size() - sizeof(h)) / (column_bytes ? column_bytes : 1) < h.columns)
+    throw std::runtime_error("metric: truncated snapshot '" + path + "'");
+  return h;
+}
+
+}  // namespace
+
+/* @{ writing */
+
+/**
+ * \brief Write snapshot of `a` to `path`.
+ *
+ * The file is replaced atomically, so readers never see a partial snapshot.
+ *
+ * \throws std::system_error on I/O errors.
+ **/
+template <typename Distance, typename Alloc>
+void write_snapshot(const std::string& path, const distance_array<Distance, Alloc>& a) {
+  __snapshot_write(path, __snapshot_make_header<Distance>(snapshot_kind::columns, a.size(), 1),
+                   { { a.data(), a.size() * sizeof(Distance) } });
+}
+
+/**
+ * \brief Write snapshot of `p` to `path`.
+ * \throws std::system_error on I/O errors.
+ **/
+template <typename Distance, std::size_t Dims, typename Alloc>
+void write_snapshot(const std::string& path, const point_array<Distance, Dims, Alloc>& p) {
+  std::vector<std::pair<const void*, std::size_t>> columns;
+  for (std::size_t d = 0; d < Dims; ++d)
+    columns.emplace_back(p.column(d).data(), p.size() * sizeof(Distance));
+  __snapshot_write(path, __snapshot_make_header<Distance>(snapshot_kind::columns, p.size(), Dims),
+                   columns);
+}
+
+/**
+ * \brief Write snapshot of `state` to `path` on a background thread.
+ *
+ * `state` is taken by value: move it in to hand it over, or copy it to keep
+ * working on the original while the snapshot is written.
+ *
+ * \return Future which becomes ready when the snapshot is on disk and rethrows
+ *         I/O errors from `get()`.
+ **/
+template <typename State>
+std::future<void> write_snapshot_async(std::string path, State state) {
+  return std::async(std::launch::async, [](const std::string& p, const State& s) {
+    write_snapshot(p, s);
+  }, std::move(path), std::move(state));
+}
+
+/* writing @} */
+
+/* @{ restoring */
+
+/**
+ * \brief Read-only, memory-mapped snapshot of distance columns.
+ *
+ * Opening only validates the header; the columns are accessed in place and
+ * paged in lazily.
+ *
+ * \tparam Distance `distance` type of the snapshot.
+ **/
+template <typename Distance>
+class mapped_snapshot {
+ public:
+  using view_type = strided_distance_view<const Distance>;  ///< \brief Column view type.
+
+  /*!
+   * \brief Map snapshot at `path`.
+   * \throws std::system_error if the file cannot be mapped.
+   * \throws std::runtime_error if it is no snapshot of `Distance` columns.
+   **/
+  explicit mapped_snapshot(const std::string& path) : file_(path) {
+    const __snapshot_header& h = __snapshot_check(
+        file_, __snapshot_make_header<Distance>(snapshot_kind::columns, 0, 0), path);
+    size_ = static_cast<std::size_t>(h.count);
+    columns_ = h.columns;
+  }
+
+  /*! \brief Return number of elements per column. **/
+  std::size_t size() const noexcept { return size_; }
+
+  /*! \brief Return number of columns. **/
+  std::size_t columns() const noexcept { return columns_; }
+
+  /*! \brief Return view of column `c`. \throws std::out_of_range for invalid `c`. **/
+  view_type column(std::size_t c = 0) const {
+    if (c >= columns_) throw std::out_of_range("metric: snapshot column out of range");
+    const unsigned char* p = file_.data() + sizeof(__snapshot_header) +
+                             c * __snapshot_padded(size_ * sizeof(Distance));
+    return view_type(p, sizeof(Distance), size_);
+  }
+
+  /*! \brief Return pointer to the elements of column `c` (suitably aligned). **/
+  const Distance* data(std::size_t c = 0) const {
+    return reinterpret_cast<const Distance*>(column(c).data());
+  }
+
+ private:
+  mapped_file file_;
+  std::size_t size_;
+  std::size_t columns_;
+};
+
+/**
+ * \brief Restore `a` from the snapshot at `path` (copying the elements).
+ * \throws std::runtime_error if the snapshot does not hold exactly one column.
+ **/
+template <typename Distance, typename Alloc>
+void read_snapshot(const std::string& path, distance_array<Distance, Alloc>& a) {
+  mapped_snapshot<Distance> s(path);
+  if (s.columns() != 1) throw std::runtime_error("metric: snapshot column mismatch '" + path + "'");
+  a.assign(s.data(), s.size());
+}
+
+/**
+ * \brief Restore `p` from the snapshot at `path` (copying the elements).
+ * \throws std::runtime_error if the snapshot does not hold exactly `Dims` columns.
+ **/
+template <typename Distance, std::size_t Dims, typename Alloc>
+void read_snapshot(const std::string& path, point_array<Distance, Dims, Alloc>& p) {
+  mapped_snapshot<Distance> s(path);
+  if (s.columns() != Dims) throw std::runtime_error("metric: snapshot column mismatch '" + path + "'");
+  for (std::size_t d = 0; d < Dims; ++d)
+    p.column(d).assign(s.data(d), s.size());
+}
+
+/* restoring @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_SNAPSHOT_H_
@@ -0,0 +1,244 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_tof.h
+ * \brief  Time-of-flight to distance conversion for ranging sensors.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Ranging sensors measure the round-trip time of a pulse, so the range is
+ * `speed * time / 2`. The kernels fold speed, halving, the period of the
+ * duration and the ratio of the distance into a single factor. For integral
+ * durations and distances this factor is applied as one 128 bit
+ * multiply-shift (rounding to nearest), otherwise as one double multiply:
+ *
+ * ~~~{.cpp}
+ * std::vector<std::chrono::nanoseconds> echoes = ...;
+ * metric::distance_array<metric::millimeters<int32_t>> ranges;
+ * metric::tof_distance_n<metric::millimeters<int32_t>>(echoes.data(), echoes.size(), ranges);
+ * ~~~
+**/
+
+#ifndef METRIC_METRIC_TOF_H_
+#define METRIC_METRIC_TOF_H_
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+
+#include "metric_core.h"
+#include "metric_array.h"
+#include "metric_bulk.h"
+#include "metric_velocity.h"
+
+namespace metric {
+
+/* @{ propagation speeds */
+
+/** \brief Speed of light in vacuum in m/s (for LiDAR and radar). **/
+using speed_of_light = std::ratio<299792458>;
+
+/** \brief Speed of sound in dry air at 20 degrees Celsius in m/s (for ultrasonic sensors). **/
+using speed_of_sound_20c = std::ratio<3432, 10>;
+
+/**
+ * \brief Return speed of sound in dry air at temperature `celsius`.
+ * \param celsius Air temperature in degrees Celsius.
+ **/
+inline meters_per_second<double> speed_of_sound(double celsius) noexcept {
+  return meters_per_second<double>(331.3 * std::sqrt(1.0 + celsius / 273.15));
+}
+
+/* propagation speeds @} */
+
+namespace {  // anonymous namespace for multiply-shift helpers
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef __int128 __tof_int128;
+__extension__ typedef unsigned __int128 __tof_uint128;
+#endif
+
+constexpr int __tof_bit_width(std::uintmax_t x) { return x ? 1 + __tof_bit_width(x >> 1) : 0; }
+
+/* Factor from duration counts of `Period` to round-trip distance counts of `Ratio`. */
+template <typename Speed, typename Period, typename Ratio>
+using __tof_factor = typename std::ratio_divide<
+  typename std::ratio_multiply<Speed, Period>::type,
+  typename std::ratio_multiply<Ratio, std::ratio<2>>::type>::type;
+
+/* Fixed-point multiplier `mul / 2^shift` with `mul < 2^62`. */
+struct __multiply_shift {
+  std::int64_t mul;
+  int shift;
+
+#if defined(__SIZEOF_INT128__)
+  inline std::int64_t operator()(std::int64_t x) const noexcept {
+    return static_cast<std::int64_t>((static_cast<__tof_int128>(x) * mul + (__tof_int128(1) << (shift - 1))) >> shift);
+  }
+#endif
+};
+
+/* `__multiply_shift` of the ratio `F`, computed at compile-time. */
+template <typename F>
+struct __static_multiply_shift {
+  static_assert(F::num / F::den < (std::intmax_t(1) << 61), "time-of-flight factor too large for multiply-shift");
+  static constexpr int shift = 62 - __tof_bit_width(static_cast<std::uintmax_t>(F::num / F::den));
+#if defined(__SIZEOF_INT128__)
+  static constexpr std::int64_t mul = static_cast<std::int64_t>(
+    ((static_cast<__tof_uint128>(F::num) << shift) + static_cast<__tof_uint128>(F::den / 2)) / F::den);
+#endif
+};
+
+/* `__multiply_shift` of the factor `f`, computed at runtime. */
+inline __multiply_shift __dynamic_multiply_shift(double f) {
+  if (!(f > 0.0) || !(f < std::ldexp(1.0, 61)))
+    throw std::domain_error("metric: time-of-flight factor out of range for multiply-shift");
+  const int shift = 62 - __tof_bit_width(static_cast<std::uintmax_t>(f));
+  return __multiply_shift { static_cast<std::int64_t>(std::ldexp(f, shift) + 0.5), shift };
+}
+
+/* True, if the conversion from `Rep` counts to `ToRepr` counts uses the multiply-shift path. */
+template <typename Rep, typename ToRepr>
+struct __tof_integral : std::integral_constant<bool,
+#if defined(__SIZEOF_INT128__)
+  std::is_integral<Rep>::value && std::is_integral<ToRepr>::value
+#else
+  false
+#endif
+> {};
+
+/* Multiplier of the compile-time factor `F`. */
+template <typename F>
+inline __multiply_shift __tof_multiplier(std::true_type) noexcept {
+  return __multiply_shift { __static_multiply_shift<F>::mul, __static_multiply_shift<F>::shift };
+}
+
+template <typename F>
+inline constexpr double __tof_multiplier(std::false_type) noexcept {
+  return static_cast<double>(F::num) / static_cast<double>(F::den);
+}
+
+/* Multiplier of the runtime factor `f`. */
+inline __multiply_shift __tof_multiplier(double f, std::true_type) { return __dynamic_multiply_shift(f); }
+inline double __tof_multiplier(double f, std::false_type) noexcept { return f; }
+
+template <class ToDistance, class Rep, class Period>
+inline void __tof_distance_n(const std::chrono::duration<Rep, Period>* first, std::size_t n, __multiply_shift ms,
+                             ToDistance* out, std::true_type) {
+  using ToRepr = typename ToDistance::repr;
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = ToDistance(static_cast<ToRepr>(ms(static_cast<std::int64_t>(first[i].count()))));
+}
+
+template <class ToDistance, class Rep, class Period>
+inline void __tof_distance_n(const std::chrono::duration<Rep, Period>* first, std::size_t n, double f,
+                             ToDistance* out, std::false_type) {
+  using ToRepr = typename ToDistance::repr;
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = ToDistance(__calibrated_round<ToRepr>()(static_cast<double>(first[i].count()) * f));
+}
+
+}  // namespace
+
+/* @{ time-of-flight conversion */
+
+/**
+ * \brief Convert `n` round-trip times starting at `first` to ranges.
+ *
+ * All constants are folded at compile-time; integral paths need a single
+ * multiply-shift per element.
+ *
+ * \tparam ToDistance `distance` type of the ranges.
+ * \tparam Speed Propagation speed in m/s as `std::ratio`, e.g., `speed_of_light`.
+ * \param first Pointer to first round-trip time.
+ * \param n Number of elements.
+ * \param out Pointer to first output element.
+ **/
+template <class ToDistance, class Speed = speed_of_light, class Rep, class Period>
+inline typename std::enable_if<is_distance<ToDistance>::value>::type
+tof_distance_n(const std::chrono::duration<Rep, Period>* first, std::size_t n, ToDistance* out) {
+  using F = __tof_factor<Speed, Period, typename ToDistance::ratio>;
+  using integral = __tof_integral<Rep, typename ToDistance::repr>;
+  __tof_distance_n(first, n, __tof_multiplier<F>(integral()), out, integral());
+}
+
+/**
+ * \brief Convert `n` round-trip times starting at `first` to ranges at runtime speed `speed`.
+ *
+ * Use this overload for speeds known at runtime only, e.g., the speed of
+ * sound at the current air temperature (see `speed_of_sound`).
+ *
+ * \tparam ToDistance `distance` type of the ranges.
+ * \param first Pointer to first round-trip time.
+ * \param n Number of elements.
+ * \param speed Propagation speed.
+ * \param out Pointer to first output element.
+ * \throws std::domain_error if `speed` is not positive or too large for the
+ *         multiply-shift of integral conversions.
+ **/
+template <class ToDistance, class Rep, class Period, class VRepr, class VRatio, class VPeriod>
+inline typename std::enable_if<is_distance<ToDistance>::value>::type
+tof_distance_n(const std::chrono::duration<Rep, Period>* first, std::size_t n,
+               const velocity<VRepr, VRatio, VPeriod>& speed, ToDistance* out) {
+  using F = __tof_factor<std::ratio<1>, Period, typename ToDistance::ratio>;
+  using integral = __tof_integral<Rep, typename ToDistance::repr>;
+  const double f = velocity_cast<meters_per_second<double>>(speed).count() * F::num / F::den;
+  __tof_distance_n(first, n, __tof_multiplier(f, integral()), out, integral());
+}
+
+/**
+ * \brief Convert `n` round-trip times starting at `first` to ranges stored in `out`.
+ * \tparam ToDistance `distance` type of the ranges.
+ * \tparam Speed Propagation speed in m/s as `std::ratio`.
+ * \param first Pointer to first round-trip time.
+ * \param n Number of elements.
+ * \param out Array of ranges, resized to `n`.
+ **/
+template <class ToDistance, class Speed = speed_of_light, class Rep, class Period, class Alloc>
+inline void tof_distance_n(const std::chrono::duration<Rep, Period>* first, std::size_t n,
+                           distance_array<ToDistance, Alloc>& out) {
+  out.clear();
+  tof_distance_n<ToDistance, Speed>(first, n, out.append_uninitialized(n));
+}
+
+/**
+ * \brief Convert `n` round-trip times starting at `first` to ranges at runtime speed `speed` stored in `out`.
+ * \tparam ToDistance `distance` type of the ranges.
+ * \param first Pointer to first round-trip time.
+ * \param n Number of elements.
+ * \param speed Propagation speed.
+ * \param out Array of ranges, resized to `n`.
+ * \throws std::domain_error see above.
+ **/
+template <class ToDistance, class Rep, class Period, class VRepr, class VRatio, class VPeriod, class Alloc>
+inline void tof_distance_n(const std::chrono::duration<Rep, Period>* first, std::size_t n,
+                           const velocity<VRepr, VRatio, VPeriod>& speed, distance_array<ToDistance, Alloc>& out) {
+  out.clear();
+  tof_distance_n<ToDistance>(first, n, speed, out.append_uninitialized(n));
+}
+
+/* time-of-flight conversion @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_TOF_H_
@@ -0,0 +1,242 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_trace.h
+ * \brief  Timeline tracing of (parallel) distance kernels.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Kernels mark tasks with a `trace_scope`, which records a complete event
+ * (name, thread, begin, duration and an element count) into a buffer owned by
+ * the calling thread. Tracing is off by default; then a `trace_scope` costs a
+ * relaxed atomic load and a well-predicted branch.
+ *
+ * ~~~{.cpp}
+ * metric::trace_enable();
+ * metric::parallel_cast_n<metric::meters<double>>(in.data(), in.size(), out.data());
+ * metric::write_chrome_trace("trace.json");   // open in chrome://tracing or Perfetto
+ * ~~~
+**/
+
+#ifndef METRIC_METRIC_TRACE_H_
+#define METRIC_METRIC_TRACE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace metric {
+
+/** \brief Complete event of the trace timeline. **/
+struct trace_event {
+  const char* name;         ///< \brief Task name (string literal).
+  std::uint32_t thread;     ///< \brief Small sequential thread id.
+  std::uint64_t begin;      ///< \brief Begin in ns since tracing was first used.
+  std::uint64_t duration;   ///< \brief Duration in ns.
+  std::uint64_t elements;   ///< \brief Number of elements processed by the task.
+};
+
+/* @{ implementation details */
+
+struct __trace_buffer {
+  std::mutex mutex;         // uncontended, except during export
+  std::uint32_t thread;
+  std::vector<trace_event> events;
+};
+
+struct __trace_registry {
+  std::atomic<bool> enabled { false };
+  std::mutex mutex;
+  std::vector<std::shared_ptr<__trace_buffer>> buffers;  // outlive their threads
+  std::vector<std::uint32_t> idle;                       // buffers of exited threads
+  const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+inline __trace_registry& __trace_registry_instance() {
+  static __trace_registry r;
+  return r;
+}
+
+/* Buffer of the current thread, handed on to the next new thread when this one exits. */
+struct __trace_thread_handle {
+  std::shared_ptr<__trace_buffer> buffer;
+
+  ~__trace_thread_handle() {
+    if (!buffer) return;
+    __trace_registry& r = __trace_registry_instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.idle.push_back(buffer->thread);
+  }
+};
+
+/*
+ * Return buffer of the current thread. Threads reuse the buffers and ids of
+ * exited threads, lowest id first, so that short-lived workers (one set per
+ * parallel kernel call) do not grow the registry. Since a thread takes its
+ * buffer when its first event begins, the events of threads sharing a buffer
+ * never overlap.
+ */
+inline __trace_buffer& __trace_thread_buffer() {
+  thread_local __trace_thread_handle h;
+  if (!h.buffer) {
+    __trace_registry& r = __trace_registry_instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (r.idle.empty()) {
+      h.buffer = std::make_shared<__trace_buffer>();
+      h.buffer->thread = static_cast<std::uint32_t>(r.buffers.size());
+      r.buffers.push_back(h.buffer);
+    } else {
+      const auto i = std::min_element(r.idle.begin(), r.idle.end());
+      h.buffer = r.buffers[*i];
+      r.idle.erase(i);
+    }
+  }
+  return *h.buffer;
+}
+
+inline std::uint64_t __trace_now() {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - __trace_registry_instance().epoch).count());
+}
+
+/* Write `ns` as microseconds with three decimals, as Chrome traces expect. */
+inline void __trace_write_us(std::ostream& os, std::uint64_t ns) {
+  const char frac[] = {
+    '.', static_cast<char>('0' + ns / 100 % 10), static_cast<char>('0' + ns / 10 % 10),
+    static_cast<char>('0' + ns % 10), '\0',
+  };
+  os << ns / 1000 << frac;
+}
+
+/* implementation details @} */
+
+/** \brief Return true, if tracing is enabled. **/
+inline bool trace_enabled() noexcept {
+  return __trace_registry_instance().enabled.load(std::memory_order_relaxed);
+}
+
+/** \brief Enable (or disable) tracing. **/
+inline void trace_enable(bool enable = true) noexcept {
+  __trace_registry_instance().enabled.store(enable, std::memory_order_relaxed);
+}
+
+/**
+ * \brief Records the lifetime of the object as one trace event.
+ *
+ * Whether tracing is enabled is decided when the scope is entered.
+ **/
+class trace_scope {
+ public:
+  /*!
+   * \brief Begin event.
+   * \param name Task name; must outlive the trace (e.g., a string literal).
+   * \param elements Number of elements processed by the task.
+   **/
+  explicit trace_scope(const char* name, std::uint64_t elements = 0) noexcept
+    : name_(trace_enabled() ? name : nullptr), buffer_(name_ ? &__trace_thread_buffer() : nullptr),
+      elements_(elements), begin_(name_ ? __trace_now() : 0) {}
+
+  /*! \brief End event and record it. **/
+  ~trace_scope() {
+    if (!name_) return;
+    const std::uint64_t end = __trace_now();
+    std::lock_guard<std::mutex> lock(buffer_->mutex);
+    buffer_->events.push_back(trace_event { name_, buffer_->thread, begin_, end - begin_, elements_ });
+  }
+
+  trace_scope(const trace_scope&) = delete;
+  trace_scope& operator=(const trace_scope&) = delete;
+
+ private:
+  const char* name_;
+  __trace_buffer* buffer_;
+  std::uint64_t elements_;
+  std::uint64_t begin_;
+};
+
+/** \brief Return all recorded events of all threads, ordered by thread. **/
+inline std::vector<trace_event> trace_events() {
+  __trace_registry& r = __trace_registry_instance();
+  std::vector<trace_event> v;
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (const std::shared_ptr<__trace_buffer>& b : r.buffers) {
+    std::lock_guard<std::mutex> block(b->mutex);
+    v.insert(v.end(), b->events.begin(), b->events.end());
+  }
+  return v;
+}
+
+/** \brief Discard all recorded events. **/
+inline void trace_clear() {
+  __trace_registry& r = __trace_registry_instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (const std::shared_ptr<__trace_buffer>& b : r.buffers) {
+    std::lock_guard<std::mutex> block(b->mutex);
+    b->events.clear();
+  }
+}
+
+/**
+ * \brief Write all recorded events as Chrome trace event JSON.
+ *
+ * The format is understood by `chrome://tracing` and the Perfetto UI; gaps
+ * between the events of a thread show its idle time.
+ **/
+inline void write_chrome_trace(std::ostream& os) {
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (const trace_event& e : trace_events()) {
+    if (!first) os << ',';
+    first = false;
+    os << "\n{\"name\":\"";
+    for (const char* c = e.name; *c; ++c) {
+      if (*c == '"' || *c == '\\') os << '\\';
+      os << *c;
+    }
+    os << "\",\"cat\":\"metric\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread << ",\"ts\":";
+    __trace_write_us(os, e.begin);
+    os << ",\"dur\":";
+    __trace_write_us(os, e.duration);
+    os << ",\"args\":{\"elements\":" << e.elements << "}}";
+  }
+  os << "\n]}\n";
+}
+
+/**
+ * \brief Write all recorded events as Chrome trace event JSON to file `path`.
+ * \throws std::system_error if the file cannot be written.
+ **/
+inline void write_chrome_trace(const std::string& path) {
+  std::ofstream f(path);
+  if (f) write_chrome_trace(f);
+  if (!f) throw std::system_error(errno, std::generic_category(), "metric: cannot write " + path);
+}
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_TRACE_H_
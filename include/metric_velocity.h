@@ -0,0 +1,415 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_velocity.h
+ * \brief  Velocities as `distance` per `std::chrono::duration`.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * A `velocity` stores a count of `DistRatio` meters per `Period` seconds.
+ * Dividing a `distance` by a `std::chrono::duration` yields a `velocity` in
+ * exactly the units of the operands, without any conversion:
+ *
+ * ~~~{.cpp}
+ * using namespace std::chrono;
+ * auto v { millimeters<int64_t>(1500) / milliseconds(500) };  // 3 mm/ms
+ * auto d { v * seconds(2) };                                  // meters<int64_t>(6)
+ * auto kmh { velocity_cast<kilometers_per_hour<double>>(v) }; // 10.8 km/h
+ * ~~~
+ *
+ * Conversions fold the distance and the time ratio into one compile-time
+ * factor, i.e., they compile to a single multiplication and/or division, like
+ * `distance_cast`. Multiplying a `velocity` by a `duration` yields a `distance`
+ * whose ratio absorbs the time ratios, so it is exact for integers as well.
+**/
+
+#ifndef METRIC_METRIC_VELOCITY_H_
+#define METRIC_METRIC_VELOCITY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <ratio>
+#include <type_traits>
+
+#include "metric_core.h"
+
+namespace metric {
+
+/* @{ base types */
+
+/** \brief *Primary template:* Types are not velocities by default. **/
+template <typename T>
+struct is_velocity : std::false_type {};
+
+/**
+ * \brief Velocity type: `Repr` units of `DistRatio` meters per `Period` seconds.
+ * \tparam Repr Representation type of unit values.
+ * \tparam DistRatio Instance of `std::ratio`: distance unit w.r.t. meters.
+ * \tparam Period Instance of `std::ratio`: time unit w.r.t. seconds.
+ **/
+template <typename Repr, typename DistRatio = std::ratio<1>, typename Period = std::ratio<1>>
+struct velocity {
+  static_assert(!is_distance<Repr>::value, "A velocity representation can not be distance");
+  static_assert(std::__is_ratio<DistRatio>::value, "Second template parameter of velocity must be std::ratio");
+  static_assert(std::__is_ratio<Period>::value, "Third template parameter of velocity must be std::ratio");
+  static_assert(DistRatio::num > 0 && Period::num > 0, "velocity ratios must be positive");
+
+  using repr = Repr;                  ///< \brief Representation type for unit values.
+  using distance_ratio = DistRatio;   ///< \brief Ratio of distance unit to meters.
+  using period = Period;              ///< \brief Ratio of time unit to seconds.
+  /// \brief Ratio of the velocity unit to m/s.
+  using ratio = typename std::ratio_divide<DistRatio, Period>::type;
+  using distance_type = distance<Repr, DistRatio>;            ///< \brief Distance per unit.
+  using duration_type = std::chrono::duration<Repr, Period>;  ///< \brief Time unit.
+
+  /*! \brief Default constructor. **/
+  constexpr velocity() noexcept = default;
+
+  /*!
+   * \brief Construct velocity from representation of unit values.
+   * \tparam Repr2 Type of unit representation (can be same as `Repr`).
+   * \param r Unit values.
+   **/
+  template <class Repr2, typename = typename std::enable_if<
+    std::is_convertible<Repr2, Repr>::value &&
+    (treat_as_floating_point<Repr>::value || !treat_as_floating_point<Repr2>::value)
+  >::type>
+  inline constexpr explicit velocity(const Repr2& r) : count_(static_cast<Repr>(r)) {}
+
+  /*! \brief Increase this velocity by `rhs.count()` unit values. **/
+  inline _METRIC_CONSTEXPR_AFTER_CXX14
+  velocity& operator +=(const velocity& rhs) { count_ += rhs.count_; return *this; }
+
+  /*! \brief Decrease this velocity by `rhs.count()` unit values. **/
+  inline _METRIC_CONSTEXPR_AFTER_CXX14
+  velocity& operator -=(const velocity& rhs) { count_ -= rhs.count_; return *this; }
+
+  /*! \brief Multiply this velocity by `s`. **/
+  inline _METRIC_CONSTEXPR_AFTER_CXX14
+  velocity& operator *=(const repr& s) { count_ *= s; return *this; }
+
+  /*! \brief Divide this velocity by `s`. **/
+  inline _METRIC_CONSTEXPR_AFTER_CXX14
+  velocity& operator /=(const repr& s) { count_ /= s; return *this; }
+
+  /*! \brief Return number of unit values. **/
+  inline constexpr Repr count() const noexcept { return count_; }
+
+ private:
+  Repr count_;
+};
+
+/** \brief *Specialization:* instances of `velocity` are velocities. **/
+template <typename Repr, typename DistRatio, typename Period>
+struct is_velocity<velocity<Repr, DistRatio, Period>> : std::true_type {};
+
+/** \brief *Specialization:* `const` instances of `velocity` are velocities. **/
+template <typename Repr, typename DistRatio, typename Period>
+struct is_velocity<const velocity<Repr, DistRatio, Period>> : std::true_type {};
+
+/* base types @} */
+
+/* @{ type shorthands */
+template <typename Repr> using meters_per_second      = velocity<Repr>;
+template <typename Repr> using millimeters_per_second = velocity<Repr, std::milli>;
+template <typename Repr> using kilometers_per_hour    = velocity<Repr, std::kilo, std::ratio<3600>>;
+/* type shorthands @} */
+
+namespace {  // anonymous namespace for velocity helpers
+
+constexpr std::intmax_t __velocity_gcd(std::intmax_t a, std::intmax_t b) {
+  return b == 0 ? a : __velocity_gcd(b, a % b);
+}
+
+/* Least common multiple of two (positive) ratios. */
+template <typename R1, typename R2>
+struct __velocity_ratio_lcm {
+  using type = std::ratio<R1::num / __velocity_gcd(R1::num, R2::num) * R2::num,
+                          __velocity_gcd(R1::den, R2::den)>;
+};
+
+}  // namespace
+
+}  // namespace metric
+
+/*! @{ Specialization of `std::common_type` for `velocity`. **/
+template <typename Repr1, typename DistRatio1, typename Period1,
+          typename Repr2, typename DistRatio2, typename Period2>
+struct std::common_type<metric::velocity<Repr1, DistRatio1, Period1>,
+                        metric::velocity<Repr2, DistRatio2, Period2>> {
+  /// Common type: GCD of distance units per LCM of time units, both convert exactly.
+  using type = metric::velocity<typename std::common_type<Repr1, Repr2>::type,
+                                typename __ratio_gcd<DistRatio1, DistRatio2>::type,
+                                typename metric::__velocity_ratio_lcm<Period1, Period2>::type>;
+};
+/*! @} */
+
+namespace metric {
+
+/* @{ velocity_cast */
+
+/**
+ * \brief Cast given `velocity` instance to `ToVelocity` type.
+ *
+ * Distance and time ratios are folded into one factor at compile-time, so the
+ * cast is one multiplication, division or both (or nothing), like `distance_cast`.
+ *
+ * \tparam ToVelocity `velocity` type to cast to.
+ * \param v The `velocity` instance to convert.
+ * \return v In units of `ToVelocity`.
+ **/
+template <class ToVelocity, class Repr, class DistRatio, class Period>
+constexpr typename std::enable_if<is_velocity<ToVelocity>::value, ToVelocity>::type
+velocity_cast(const velocity<Repr, DistRatio, Period>& v) {
+  using From = velocity<Repr, DistRatio, Period>;
+  using Factor = typename std::ratio_divide<typename From::ratio, typename ToVelocity::ratio>::type;
+  return __distance_cast<From, ToVelocity, Factor>()(v);
+}
+
+/**
+ * \brief Cast `n` velocities starting at `first` to `ToVelocity` and store them to `out`.
+ * \param first Pointer to first input element.
+ * \param n Number of elements.
+ * \param out Pointer to first output element.
+ **/
+template <class ToVelocity, class Repr, class DistRatio, class Period>
+inline typename std::enable_if<is_velocity<ToVelocity>::value>::type
+velocity_cast_n(const velocity<Repr, DistRatio, Period>* first, std::size_t n, ToVelocity* out) {
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = velocity_cast<ToVelocity>(first[i]);
+}
+
+/* velocity_cast @} */
+
+/* @{ relational operators */
+
+namespace {  // anonymous namespace for velocity comparison helpers
+
+template <typename Repr>
+inline constexpr bool __velocity_eq(const Repr& lhs, const Repr& rhs, std::true_type) {
+  return lhs > rhs ?
+    lhs - rhs <= static_cast<Repr>(std::numeric_limits<float>::epsilon()) :
+    rhs - lhs <= static_cast<Repr>(std::numeric_limits<float>::epsilon());
+}
+
+template <typename Repr>
+inline constexpr bool __velocity_eq(const Repr& lhs, const Repr& rhs, std::false_type) {
+  return lhs == rhs;
+}
+
+template <typename Velocity>
+inline constexpr bool __velocity_eq(const Velocity& lhs, const Velocity& rhs) {
+  using repr = typename Velocity::repr;
+  return __velocity_eq(lhs.count(), rhs.count(), std::integral_constant<bool, treat_as_floating_point<repr>::value>());
+}
+
+}  // namespace
+
+/** \brief Equality across `velocity` instances of any units. **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr bool operator==(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  using CT = typename std::common_type<velocity<R1, D1, P1>, velocity<R2, D2, P2>>::type;
+  return __velocity_eq(velocity_cast<CT>(lhs), velocity_cast<CT>(rhs));
+}
+
+/** \brief Inequality across `velocity` instances of any units. **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr bool operator!=(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  return !(lhs == rhs);
+}
+
+/** \brief Less-than relation across `velocity` instances of any units. **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr bool operator<(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  using CT = typename std::common_type<velocity<R1, D1, P1>, velocity<R2, D2, P2>>::type;
+  return velocity_cast<CT>(lhs).count() < velocity_cast<CT>(rhs).count();
+}
+
+/** \brief Greater-than relation across `velocity` instances of any units. **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr bool operator>(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  return rhs < lhs;
+}
+
+/** \brief Less-or-equal relation across `velocity` instances of any units. **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr bool operator<=(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  return !(rhs < lhs);
+}
+
+/** \brief Greater-or-equal relation across `velocity` instances of any units. **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr bool operator>=(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  return !(lhs < rhs);
+}
+
+/* relational operators @} */
+
+/* @{ arithmetic operators */
+
+/** \brief Sum of velocities, in their common type. **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr typename std::common_type<velocity<R1, D1, P1>, velocity<R2, D2, P2>>::type
+operator +(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  using CT = typename std::common_type<velocity<R1, D1, P1>, velocity<R2, D2, P2>>::type;
+  return CT(velocity_cast<CT>(lhs).count() + velocity_cast<CT>(rhs).count());
+}
+
+/** \brief Difference of velocities, in their common type. **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr typename std::common_type<velocity<R1, D1, P1>, velocity<R2, D2, P2>>::type
+operator -(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  using CT = typename std::common_type<velocity<R1, D1, P1>, velocity<R2, D2, P2>>::type;
+  return CT(velocity_cast<CT>(lhs).count() - velocity_cast<CT>(rhs).count());
+}
+
+/** \brief Ratio of velocities (a scalar). **/
+template <typename R1, typename D1, typename P1, typename R2, typename D2, typename P2>
+inline constexpr typename std::common_type<R1, R2>::type
+operator /(const velocity<R1, D1, P1>& lhs, const velocity<R2, D2, P2>& rhs) {
+  using CT = typename std::common_type<velocity<R1, D1, P1>, velocity<R2, D2, P2>>::type;
+  return velocity_cast<CT>(lhs).count() / velocity_cast<CT>(rhs).count();
+}
+
+/** \brief Velocity `v` multiplied by scalar `s`. **/
+template <typename R1, typename D1, typename P1, typename R2>
+inline constexpr typename std::enable_if<
+  std::is_arithmetic<R2>::value, velocity<typename std::common_type<R1, R2>::type, D1, P1>
+>::type
+operator *(const velocity<R1, D1, P1>& v, const R2& s) {
+  using CR = typename std::common_type<R1, R2>::type;
+  return velocity<CR, D1, P1>(static_cast<CR>(v.count()) * static_cast<CR>(s));
+}
+
+/** \brief Velocity `v` multiplied by scalar `s`. **/
+template <typename R1, typename D1, typename P1, typename R2>
+inline constexpr typename std::enable_if<
+  std::is_arithmetic<R2>::value, velocity<typename std::common_type<R1, R2>::type, D1, P1>
+>::type
+operator *(const R2& s, const velocity<R1, D1, P1>& v) {
+  return v * s;
+}
+
+/** \brief Velocity `v` divided by scalar `s`. **/
+template <typename R1, typename D1, typename P1, typename R2>
+inline constexpr typename std::enable_if<
+  std::is_arithmetic<R2>::value, velocity<typename std::common_type<R1, R2>::type, D1, P1>
+>::type
+operator /(const velocity<R1, D1, P1>& v, const R2& s) {
+  using CR = typename std::common_type<R1, R2>::type;
+  return velocity<CR, D1, P1>(static_cast<CR>(v.count()) / static_cast<CR>(s));
+}
+
+/**
+ * \brief Velocity of covering distance `d` in time `t`.
+ *
+ * The result is in units of the operands (e.g., mm per ms); no conversion
+ * takes place. For integral representations, the division truncates like
+ * `std::chrono` does, so choose units fine enough for the required resolution.
+ **/
+template <typename R1, typename DistRatio, typename R2, typename Period>
+inline constexpr velocity<typename std::common_type<R1, R2>::type, DistRatio, Period>
+operator /(const distance<R1, DistRatio>& d, const std::chrono::duration<R2, Period>& t) {
+  using CR = typename std::common_type<R1, R2>::type;
+  return velocity<CR, DistRatio, Period>(static_cast<CR>(d.count()) / static_cast<CR>(t.count()));
+}
+
+/**
+ * \brief Distance covered at velocity `v` in time `t`; exact also for integers.
+ *
+ * The ratio of the result is `DistRatio * Period2 / Period1`, e.g., mm/s times
+ * ms yields micrometers.
+ **/
+template <typename R1, typename DistRatio, typename Period1, typename R2, typename Period2>
+inline constexpr distance<typename std::common_type<R1, R2>::type,
+                          typename std::ratio_multiply<DistRatio, typename std::ratio_divide<Period2, Period1>::type>::type>
+operator *(const velocity<R1, DistRatio, Period1>& v, const std::chrono::duration<R2, Period2>& t) {
+  using CR = typename std::common_type<R1, R2>::type;
+  using D = distance<CR, typename std::ratio_multiply<DistRatio, typename std::ratio_divide<Period2, Period1>::type>::type>;
+  return D(static_cast<CR>(v.count()) * static_cast<CR>(t.count()));
+}
+
+/** \brief Distance covered at velocity `v` in time `t`; exact also for integers. **/
+template <typename R1, typename DistRatio, typename Period1, typename R2, typename Period2>
+inline constexpr distance<typename std::common_type<R1, R2>::type,
+                          typename std::ratio_multiply<DistRatio, typename std::ratio_divide<Period2, Period1>::type>::type>
+operator *(const std::chrono::duration<R2, Period2>& t, const velocity<R1, DistRatio, Period1>& v) {
+  return v * t;
+}
+
+/**
+ * \brief Time needed to cover distance `d` at velocity `v`.
+ *
+ * The period of the result is `Period * DistRatio1 / DistRatio2`.
+ **/
+template <typename R1, typename DistRatio1, typename R2, typename DistRatio2, typename Period>
+inline constexpr std::chrono::duration<typename std::common_type<R1, R2>::type,
+                 typename std::ratio_multiply<Period, typename std::ratio_divide<DistRatio1, DistRatio2>::type>::type>
+operator /(const distance<R1, DistRatio1>& d, const velocity<R2, DistRatio2, Period>& v) {
+  using CR = typename std::common_type<R1, R2>::type;
+  using T = std::chrono::duration<CR,
+      typename std::ratio_multiply<Period, typename std::ratio_divide<DistRatio1, DistRatio2>::type>::type>;
+  return T(static_cast<CR>(d.count()) / static_cast<CR>(v.count()));
+}
+
+/* arithmetic operators @} */
+
+/* @{ stream operators */
+
+/**
+ * \brief *Primary template:* stream operator for generic `velocity` instances.
+ *
+ * Outputs format: "<UNITS> <NUM>/<DEN> m/s" with the combined ratio.
+ **/
+template <typename Repr, typename DistRatio, typename Period>
+std::ostream& operator <<(std::ostream& o, const velocity<Repr, DistRatio, Period>& v) {
+  using R = typename velocity<Repr, DistRatio, Period>::ratio;
+  o << v.count() << " " << R::num << "/" << R::den << " m/s";
+  return o;
+}
+
+/** \brief *Specialization:* stream operator for meters per second. **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const velocity<Repr, std::ratio<1>, std::ratio<1>>& v) {
+  o << v.count() << " m/s";
+  return o;
+}
+
+/** \brief *Specialization:* stream operator for millimeters per second. **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const velocity<Repr, std::milli, std::ratio<1>>& v) {
+  o << v.count() << " mm/s";
+  return o;
+}
+
+/** \brief *Specialization:* stream operator for kilometers per hour. **/
+template <typename Repr>
+std::ostream& operator <<(std::ostream& o, const velocity<Repr, std::kilo, std::ratio<3600>>& v) {
+  o << v.count() << " km/h";
+  return o;
+}
+
+/* stream operators @} */
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_VELOCITY_H_
@@ -0,0 +1,257 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_view.h
+ * \brief  Non-owning strided views over values in foreign memory.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Bulk kernels accept strided views wherever they accept pointers, so fields
+ * inside larger records are processed without copying them into an array
+ * first. Element-wise conversions read the fields in place; kernels working on
+ * arrays (histograms, lookup tables, aggregation, the compiled kernels) gather
+ * views that are not contiguous in blocks into a small buffer on the stack,
+ * which stays in L1 (see `for_each_block`):
+ *
+ * ~~~{.cpp}
+ * struct Return { metric::meters<float> range; float intensity; };
+ * std::vector<Return> returns = ...;
+ * std::vector<metric::millimeters<int32_t>> mm(returns.size());
+ * metric::distance_cast_n<metric::millimeters<int32_t>>(
+ *   metric::make_strided_view(returns.data(), returns.size(), &Return::range), mm.data());
+ * ~~~
+**/
+
+#ifndef METRIC_METRIC_VIEW_H_
+#define METRIC_METRIC_VIEW_H_
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#include "metric_core.h"
+
+namespace metric {
+
+namespace {  // anonymous namespace for blocked access
+
+/* Bytes per block of gathered elements (see `for_each_block`). */
+constexpr std::size_t __strided_block_bytes = 4096;
+
+}  // namespace
+
+/**
+ * \brief Non-owning view of `size()` values of type `T`, `stride()` bytes apart.
+ *
+ * The viewed values need not be aligned: elements are loaded (and stored) by
+ * `std::memcpy`, which compiles to plain moves on all relevant targets. This
+ * makes it possible to look at fields inside packed file records or foreign
+ * structs without copying them first.
+ *
+ * \tparam T Trivially copyable element type; a `const` qualified `T` yields a
+ *           read-only view.
+ **/
+template <typename T>
+class strided_view {
+ public:
+  using value_type = typename std::remove_cv<T>::type;  ///< \brief Element type.
+  using size_type = std::size_t;                          ///< \brief Size type.
+  using difference_type = std::ptrdiff_t;                 ///< \brief Stride type.
+  /// \brief Pointer type to the raw bytes of the view.
+  using byte_pointer = typename std::conditional<std::is_const<T>::value,
+                                                 const unsigned char*,
+                                                 unsigned char*>::type;
+  /// \brief Untyped pointer type accepted by the constructors.
+  using void_pointer = typename std::conditional<std::is_const<T>::value,
+                                                 const void*, void*>::type;
+
+  static_assert(std::is_trivially_copyable<value_type>::value,
+                "strided_view requires a trivially copyable element type");
+
+  /*! \brief Input iterator yielding the viewed values by value. **/
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = typename strided_view::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = value_type;
+
+    const_iterator() noexcept : p_(nullptr), stride_(0) {}
+    const_iterator(byte_pointer p, difference_type stride) noexcept : p_(p), stride_(stride) {}
+
+    value_type operator*() const noexcept {
+      value_type v;
+      std::memcpy(&v, p_, sizeof(v));
+      return v;
+    }
+
+    const_iterator& operator++() noexcept { p_ += stride_; return *this; }
+    const_iterator operator++(int) noexcept { const_iterator t(*this); p_ += stride_; return t; }
+
+    bool operator==(const const_iterator& rhs) const noexcept { return p_ == rhs.p_; }
+    bool operator!=(const const_iterator& rhs) const noexcept { return p_ != rhs.p_; }
+
+   private:
+    byte_pointer p_;
+    difference_type stride_;
+  };
+
+  /*! \brief Construct empty view. **/
+  constexpr strided_view() noexcept : data_(nullptr), stride_(sizeof(value_type)), size_(0) {}
+
+  /*!
+   * \brief Construct view over `n` elements starting at `data`.
+   * \param data Address of the first element (need not be aligned).
+   * \param stride Distance between consecutive elements in bytes.
+   * \param n Number of elements.
+   **/
+  strided_view(void_pointer data, difference_type stride, size_type n) noexcept
+    : data_(static_cast<byte_pointer>(data)), stride_(stride), size_(n) {}
+
+  /*!
+   * \brief Construct view over contiguous array of `n` elements.
+   * \param data Address of the first element.
+   * \param n Number of elements.
+   **/
+  strided_view(T* data, size_type n) noexcept
+    : data_(reinterpret_cast<byte_pointer>(data)), stride_(sizeof(value_type)), size_(n) {}
+
+  /*! \brief Implicit conversion of mutable views to read-only views. **/
+  template <typename U, typename = typename std::enable_if<
+    std::is_const<T>::value && std::is_same<U, value_type>::value
+  >::type>
+  strided_view(const strided_view<U>& other) noexcept
+    : data_(other.data()), stride_(other.stride()), size_(other.size()) {}
+
+  /*! \brief Return the `i`-th element. **/
+  value_type operator[](size_type i) const noexcept {
+    value_type v;
+    std::memcpy(&v, data_ + static_cast<difference_type>(i) * stride_, sizeof(v));
+    return v;
+  }
+
+  /*! \brief Overwrite the `i`-th element with `v` (mutable views only). **/
+  void store(size_type i, const value_type& v) const noexcept {
+    static_assert(!std::is_const<T>::value, "cannot store into a read-only strided_view");
+    std::memcpy(data_ + static_cast<difference_type>(i) * stride_, &v, sizeof(v));
+  }
+
+  /*! \brief Copy `n` elements starting at element `pos` to the array `out`. **/
+  void gather(size_type pos, size_type n, value_type* out) const noexcept {
+    byte_pointer p = data_ + static_cast<difference_type>(pos) * stride_;
+    for (size_type i = 0; i < n; ++i, p += stride_) std::memcpy(out + i, p, sizeof(value_type));
+  }
+
+  /*! \brief Return sub-view of `n` elements starting at element `pos`. **/
+  strided_view subview(size_type pos, size_type n) const noexcept {
+    return strided_view(data_ + static_cast<difference_type>(pos) * stride_, stride_, n);
+  }
+
+  /*! \brief Return address of the first element. **/
+  byte_pointer data() const noexcept { return data_; }
+
+  /*! \brief Return distance between consecutive elements in bytes. **/
+  difference_type stride() const noexcept { return stride_; }
+
+  /*! \brief Return number of elements. **/
+  size_type size() const noexcept { return size_; }
+
+  /*! \brief Return true, iff. the view has no elements. **/
+  bool empty() const noexcept { return size_ == 0; }
+
+  /*!
+   * \brief Return true, iff. the elements form a properly aligned array of `T`,
+   *        i.e., `data()` can be used as `T*`.
+   **/
+  bool is_contiguous() const noexcept {
+    return stride_ == static_cast<difference_type>(sizeof(value_type)) &&
+           reinterpret_cast<std::size_t>(data_) % alignof(value_type) == 0;
+  }
+
+  /*! \brief Return iterator to first element. **/
+  const_iterator begin() const noexcept { return const_iterator(data_, stride_); }
+
+  /*! \brief Return iterator past the last element. **/
+  const_iterator end() const noexcept {
+    return const_iterator(data_ + static_cast<difference_type>(size_) * stride_, stride_);
+  }
+
+ private:
+  byte_pointer data_;
+  difference_type stride_;
+  size_type size_;
+};
+
+/**
+ * \brief Strided view over `distance` values.
+ * \tparam Distance `distance` type, possibly `const` qualified.
+ **/
+template <typename Distance>
+using strided_distance_view = strided_view<Distance>;
+
+/**
+ * \brief Return view of the field `member` of `n` records starting at `records`.
+ * \param records Pointer to first record.
+ * \param n Number of records.
+ * \param member Pointer to the viewed data member.
+ **/
+template <typename Record, typename Field>
+inline strided_view<Field> make_strided_view(Record* records, std::size_t n, Field Record::*member) noexcept {
+  return strided_view<Field>(n ? &(records->*member) : nullptr, sizeof(Record), n);
+}
+
+/*! \brief Return read-only view of the field `member` of `n` records starting at `records`. **/
+template <typename Record, typename Field>
+inline strided_view<const Field> make_strided_view(const Record* records, std::size_t n,
+                                                   Field Record::*member) noexcept {
+  return strided_view<const Field>(n ? &(records->*member) : nullptr, sizeof(Record), n);
+}
+
+/**
+ * \brief Call `f(block, pos, m)` for consecutive blocks of the elements of `in`,
+ *        where `block` points to an array of the `m` elements starting at `pos`.
+ *
+ * Contiguous views are passed as a single block without copying; otherwise the
+ * elements are gathered into blocks of 4 KiB on the stack.
+ *
+ * \param in View of input elements.
+ * \param f Function called for each block.
+ **/
+template <typename T, typename F>
+inline void for_each_block(strided_view<T> in, F f) {
+  using V = typename strided_view<T>::value_type;
+  if (in.empty()) return;
+  if (in.is_contiguous()) {
+    f(reinterpret_cast<const V*>(in.data()), std::size_t(0), in.size());
+    return;
+  }
+  constexpr std::size_t block = __strided_block_bytes / sizeof(V) ? __strided_block_bytes / sizeof(V) : 1;
+  V buf[block];
+  for (std::size_t pos = 0; pos < in.size(); pos += block) {
+    const std::size_t m = in.size() - pos < block ? in.size() - pos : block;
+    in.gather(pos, m, buf);
+    f(static_cast<const V*>(buf), pos, m);
+  }
+}
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_VIEW_H_
@@ -0,0 +1,411 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_wkb.h
+ * \brief  Zero-copy Well-Known Binary (WKB) geometry reader.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Supports Point, LineString and Polygon in ISO WKB (including Z, M and ZM
+ * variants) and PostGIS EWKB (Z/M flags and SRID).
+**/
+
+#ifndef METRIC_METRIC_WKB_H_
+#define METRIC_METRIC_WKB_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include "metric_core.h"
+#include "metric_array.h"
+#include "metric_bulk.h"
+#include "metric_view.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "metric_wkb.h views little-endian WKB coordinates in place and requires a little-endian host"
+#endif
+
+namespace metric {
+
+/** \brief Supported WKB geometry types. **/
+enum class wkb_type : std::uint32_t {
+  point = 1,        ///< \brief Single point.
+  line_string = 2,  ///< \brief Sequence of points.
+  polygon = 3,      ///< \brief Sequence of linear rings.
+};
+
+/** \brief Offsets produced by a batched WKB decode (cf. `wkb_decode`). **/
+struct wkb_offsets {
+  /// \brief Index of the first ring of each geometry in `rings`, plus end sentinel.
+  std::vector<std::size_t> geometries;
+  /// \brief Index of the first point of each ring, plus end sentinel.
+  std::vector<std::size_t> rings;
+};
+
+namespace {  // anonymous namespace for WKB parsing helpers
+
+struct __wkb_header {
+  wkb_type type;
+  bool big_endian;
+  bool has_z;
+  bool has_m;
+  unsigned dims;
+  std::uint32_t srid;
+  std::size_t bytes;
+};
+
+inline std::uint32_t __wkb_u32(const unsigned char* p, bool swap) {
+  std::uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return swap ? __builtin_bswap32(v) : v;
+}
+
+[[noreturn]] inline void __wkb_fail(const char* what) {
+  throw std::runtime_error(std::string("metric: ") + what);
+}
+
+/*
+ * Parse structure of one WKB geometry and call `on_ring(header, offset, count)`
+ * for each ring (Point and LineString have exactly one). Coordinates are not read.
+ */
+template <typename OnRing>
+inline __wkb_header __wkb_parse(const unsigned char* p, std::size_t size, OnRing&& on_ring) {
+  if (size < 5) __wkb_fail("truncated WKB header");
+  if (p[0] > 1) __wkb_fail("invalid WKB byte order");
+  __wkb_header h;
+  h.big_endian = p[0] == 0;
+  std::uint32_t t = __wkb_u32(p + 1, h.big_endian);
+  std::size_t pos = 5;
+  h.has_z = (t & 0x80000000u) != 0;
+  h.has_m = (t & 0x40000000u) != 0;
+  h.srid = 0;
+  if (t & 0x20000000u) {
+    if (size < pos + 4) __wkb_fail("truncated WKB SRID");
+    h.srid = __wkb_u32(p + pos, h.big_endian);
+    pos += 4;
+  }
+  t &= 0x0fffffffu;
+  const std::uint32_t iso = t / 1000;
+  if (iso > 3) __wkb_fail("unsupported WKB geometry type");
+  h.has_z = h.has_z || iso == 1 || iso == 3;
+  h.has_m = h.has_m || iso == 2 || iso == 3;
+  t %= 1000;
+  if (t < 1 || t > 3) __wkb_fail("unsupported WKB geometry type");
+  h.type = static_cast<wkb_type>(t);
+  h.dims = 2 + (h.has_z ? 1 : 0) + (h.has_m ? 1 : 0);
+  const std::size_t point_bytes = 8 * h.dims;
+
+  auto ring = [&](std::size_t count) {
+    if (count > (size - pos) / point_bytes) __wkb_fail("truncated WKB coordinates");
+    on_ring(static_cast<const __wkb_header&>(h), pos, count);
+    pos += count * point_bytes;
+  };
+  auto count = [&]() -> std::size_t {
+    if (size < pos + 4) __wkb_fail("truncated WKB count");
+    std::size_t n = __wkb_u32(p + pos, h.big_endian);
+    pos += 4;
+    return n;
+  };
+
+  switch (h.type) {
+  case wkb_type::point: ring(1); break;
+  case wkb_type::line_string: ring(count()); break;
+  case wkb_type::polygon:
+    for (std::size_t r = count(); r > 0; --r) ring(count());
+    break;
+  }
+  h.bytes = pos;
+  return h;
+}
+
+/*
+ * Copy `n` doubles from `src` to `dst`, swapping their byte order if `swap`.
+ * The swapping path uses byte shuffles when SSSE3 (or AVX2) is available.
+ */
+inline void __wkb_load_doubles(const unsigned char* src, std::size_t n, bool swap, double* dst) {
+  if (!swap) {
+    std::memcpy(dst, src, n * sizeof(double));
+    return;
+  }
+  std::size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i mask256 = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                                          8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 8 * i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, mask256));
+  }
+#endif
+#if defined(__SSSE3__)
+  const __m128i mask = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+  for (; i + 2 <= n; i += 2) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8 * i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, mask));
+  }
+#endif
+  for (; i < n; ++i) {
+    std::uint64_t u;
+    std::memcpy(&u, src + 8 * i, sizeof(u));
+    u = __builtin_bswap64(u);
+    std::memcpy(dst + i, &u, sizeof(u));
+  }
+}
+
+/* Convert coordinate `v` in units of `Ratio` to `Distance`. */
+template <typename Ratio, typename Distance, bool = treat_as_floating_point<typename Distance::repr>::value>
+struct __wkb_coordinate {
+  static Distance convert(double v) { return distance_cast<Distance>(distance<double, Ratio>(v)); }
+};
+
+/* Integral columns round half away from zero; NaN (e.g., `POINT EMPTY`) and out-of-range coordinates throw. */
+template <typename Ratio, typename Distance>
+struct __wkb_coordinate<Ratio, Distance, false> {
+  static Distance convert(double v) {
+    using repr = typename Distance::repr;
+    using limits = std::numeric_limits<repr>;
+    const double x = v * __calibrated_factor<Ratio, typename Distance::ratio>();
+    if (x != x) __wkb_fail("NaN coordinate cannot be decoded to an integral representation");
+    if (limits::is_specialized && !(x > static_cast<double>(limits::lowest()) - 0.5 &&
+                                    x < static_cast<double>(limits::max()) + 0.5))
+      __wkb_fail("coordinate out of range of the integral representation");
+    return Distance(__calibrated_round<repr>()(x));
+  }
+};
+
+/*
+ * Decode `count` points at `src` into `out` starting at point `base`.
+ * Coordinates are staged block-wise in a small buffer, then scattered to the
+ * columns and converted from `distance<double, Ratio>` to the column type.
+ */
+template <typename Ratio, typename Distance, std::size_t Dims, typename Alloc>
+inline void __wkb_decode_ring(const unsigned char* src, std::size_t count, const __wkb_header& h,
+                              point_array<Distance, Dims, Alloc>& out, std::size_t base) {
+  constexpr std::size_t block = 128;
+  double tmp[block * 4];
+  const int source[4] = { 0, 1, h.has_z ? 2 : -1, h.has_m ? (h.has_z ? 3 : 2) : -1 };
+  for (std::size_t done = 0; done < count; ) {
+    const std::size_t b = std::min(block, count - done);
+    __wkb_load_doubles(src + done * 8 * h.dims, b * h.dims, h.big_endian, tmp);
+    for (std::size_t d = 0; d < Dims; ++d) {
+      Distance* col = out.column(d).data() + base + done;
+      const int s = d < 4 ? source[d] : -1;
+      if (s < 0) {
+        std::fill(col, col + b, Distance(typename Distance::repr()));
+      } else {
+        for (std::size_t i = 0; i < b; ++i)
+          col[i] = __wkb_coordinate<Ratio, Distance>::convert(tmp[i * h.dims + s]);
+      }
+    }
+    done += b;
+  }
+}
+
+}  // namespace
+
+/**
+ * \brief Zero-copy view of a single WKB geometry.
+ *
+ * Construction parses the geometry structure only (O(number of rings)); the
+ * coordinates stay in the blob. For little-endian blobs they can be accessed in
+ * place as strided `distance` views, big-endian blobs have to be `decode`d.
+ * The blob must outlive the `wkb_geometry`.
+ *
+ * ~~~{.cpp}
+ * metric::wkb_geometry<std::milli> g(blob.data(), blob.size());  // mm coordinates
+ * for (std::size_t r = 0; r < g.rings(); ++r)
+ *   for (auto x : g.x(r)) ...
+ * ~~~
+ *
+ * \tparam Ratio Unit of the coordinates, defaults to meters.
+ **/
+template <typename Ratio = std::ratio<1>>
+class wkb_geometry {
+ public:
+  using distance_type = distance<double, Ratio>;                  ///< \brief Coordinate type.
+  using view_type = strided_distance_view<const distance_type>;   ///< \brief Coordinate view type.
+
+  /*!
+   * \brief Parse WKB geometry in `size` bytes at `blob`.
+   * \throws std::runtime_error if the blob is malformed or of unsupported type.
+   **/
+  wkb_geometry(const void* blob, std::size_t size)
+    : data_(static_cast<const unsigned char*>(blob)) {
+    header_ = __wkb_parse(data_, size, [this](const __wkb_header&, std::size_t offset, std::size_t count) {
+      rings_.push_back(ring_type { offset, count });
+    });
+  }
+
+  /*! \brief Return geometry type. **/
+  wkb_type type() const noexcept { return header_.type; }
+  /*! \brief Return number of coordinates per point (2 - 4). **/
+  unsigned dimensions() const noexcept { return header_.dims; }
+  /*! \brief Return true, iff. points have a Z coordinate. **/
+  bool has_z() const noexcept { return header_.has_z; }
+  /*! \brief Return true, iff. points have an M coordinate. **/
+  bool has_m() const noexcept { return header_.has_m; }
+  /*! \brief Return true, iff. the blob is big-endian (XDR). **/
+  bool big_endian() const noexcept { return header_.big_endian; }
+  /*! \brief Return EWKB SRID, or 0 if none. **/
+  std::uint32_t srid() const noexcept { return header_.srid; }
+  /*! \brief Return number of bytes the geometry occupies in the blob. **/
+  std::size_t bytes() const noexcept { return header_.bytes; }
+
+  /*! \brief Return number of rings (1 for Point and LineString). **/
+  std::size_t rings() const noexcept { return rings_.size(); }
+
+  /*! \brief Return number of points in ring `r`. **/
+  std::size_t size(std::size_t r) const { return rings_.at(r).count; }
+
+  /*! \brief Return total number of points. **/
+  std::size_t size() const noexcept {
+    std::size_t n = 0;
+    for (const ring_type& r : rings_) n += r.count;
+    return n;
+  }
+
+  /*! \brief Return view of X coordinates in ring `r`. \throws std::domain_error for big-endian blobs. **/
+  view_type x(std::size_t r = 0) const { return coordinate(r, 0); }
+  /*! \brief Return view of Y coordinates in ring `r`. \throws std::domain_error for big-endian blobs. **/
+  view_type y(std::size_t r = 0) const { return coordinate(r, 1); }
+  /*! \brief Return view of Z coordinates in ring `r`. \throws std::domain_error if there are none. **/
+  view_type z(std::size_t r = 0) const {
+    if (!header_.has_z) throw std::domain_error("metric: WKB geometry has no Z coordinate");
+    return coordinate(r, 2);
+  }
+  /*! \brief Return view of M coordinates in ring `r`. \throws std::domain_error if there are none. **/
+  view_type m(std::size_t r = 0) const {
+    if (!header_.has_m) throw std::domain_error("metric: WKB geometry has no M coordinate");
+    return coordinate(r, header_.has_z ? 3 : 2);
+  }
+
+  /*!
+   * \brief Append all points (of all rings) to `out`, converting to `Distance`.
+   *
+   * Columns of `out` are filled with X, Y, Z and M in this order; columns the
+   * geometry has no coordinates for are set to zero. Integral columns are
+   * rounded half away from zero.
+   *
+   * \throws std::runtime_error if `Distance` is integral and a coordinate is
+   *         NaN or out of range; `out` is left unchanged.
+   **/
+  template <typename Distance, std::size_t Dims, typename Alloc>
+  void decode(point_array<Distance, Dims, Alloc>& out) const {
+    const std::size_t size0 = out.size();
+    std::size_t base = size0;
+    out.append_uninitialized(size());
+    try {
+      for (const ring_type& r : rings_) {
+        __wkb_decode_ring<Ratio>(data_ + r.offset, r.count, header_, out, base);
+        base += r.count;
+      }
+    } catch (...) {
+      out.resize(size0);
+      throw;
+    }
+  }
+
+ private:
+  struct ring_type {
+    std::size_t offset;
+    std::size_t count;
+  };
+
+  view_type coordinate(std::size_t r, unsigned c) const {
+    if (header_.big_endian)
+      throw std::domain_error("metric: big-endian WKB cannot be viewed in place, use decode()");
+    const ring_type& ring = rings_.at(r);
+    return view_type(data_ + ring.offset + 8 * c, 8 * header_.dims, ring.count);
+  }
+
+  const unsigned char* data_;
+  __wkb_header header_;
+  std::vector<ring_type> rings_;
+};
+
+/**
+ * \brief Decode a batch of WKB blobs into one `point_array`.
+ *
+ * The blob structures are parsed twice: first to size `out` exactly once, then
+ * to decode the coordinates; no per-blob allocations take place.
+ *
+ * \tparam Ratio Unit of the coordinates in the blobs, defaults to meters.
+ * \tparam BlobIt Iterator over blobs with `data()` and `size()` members (e.g.,
+ *                `std::string` or `std::vector<unsigned char>`).
+ * \param first Iterator to first blob.
+ * \param last Iterator past the last blob.
+ * \param out Point array to append to.
+ * \param offsets If not `nullptr`, receives geometry and ring offsets into `out`.
+ * \throws std::runtime_error if any blob is malformed, or if `Distance` is
+ *         integral and a coordinate is NaN or out of range (see
+ *         `wkb_geometry::decode`); `out` is left unchanged.
+ **/
+template <typename Ratio = std::ratio<1>, typename BlobIt, typename Distance, std::size_t Dims,
+          typename Alloc>
+void wkb_decode(BlobIt first, BlobIt last, point_array<Distance, Dims, Alloc>& out,
+                wkb_offsets* offsets = nullptr) {
+  std::size_t total = 0, rings = 0, geometries = 0;
+  for (BlobIt it = first; it != last; ++it, ++geometries)
+    __wkb_parse(reinterpret_cast<const unsigned char*>(it->data()), it->size(),
+                [&](const __wkb_header&, std::size_t, std::size_t count) {
+                  total += count;
+                  ++rings;
+                });
+
+  const std::size_t size0 = out.size();
+  std::size_t base = size0;
+  out.append_uninitialized(total);
+  if (offsets) {
+    offsets->geometries.clear();
+    offsets->rings.clear();
+    offsets->geometries.reserve(geometries + 1);
+    offsets->rings.reserve(rings + 1);
+  }
+  try {
+    for (BlobIt it = first; it != last; ++it) {
+      const unsigned char* p = reinterpret_cast<const unsigned char*>(it->data());
+      if (offsets) offsets->geometries.push_back(offsets->rings.size());
+      __wkb_parse(p, it->size(), [&](const __wkb_header& h, std::size_t offset, std::size_t count) {
+        if (offsets) offsets->rings.push_back(base);
+        __wkb_decode_ring<Ratio>(p + offset, count, h, out, base);
+        base += count;
+      });
+    }
+  } catch (...) {
+    out.resize(size0);
+    throw;
+  }
+  if (offsets) {
+    offsets->geometries.push_back(offsets->rings.size());
+    offsets->rings.push_back(base);
+  }
+}
+
+}  // namespace metric
+
+#endif  // METRIC_METRIC_WKB_H_
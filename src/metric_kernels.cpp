@@ -0,0 +1,120 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_kernels.cpp
+ * \brief  Instruction set selection and entry points of the metric_kernels library.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+**/
+
+#include <cstdlib>
+#include <cstring>
+
+#include "metric_kernels.h"
+#include "metric_kernels_table.h"
+
+namespace metric {
+namespace kernels {
+
+namespace {
+
+const isa __levels[] = { isa::generic, isa::avx2, isa::avx512 };
+
+bool __cpu_supports(isa level) noexcept {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  switch (level) {
+  case isa::avx2: return __builtin_cpu_supports("avx2");
+  case isa::avx512: return __builtin_cpu_supports("avx512f");
+  default: return true;
+  }
+#else
+  return level == isa::generic;
+#endif
+}
+
+const __kernel_table* __table_of(isa level) noexcept {
+  switch (level) {
+#if defined(METRIC_KERNELS_AVX2)
+  case isa::avx2: return &avx2::table;
+#endif
+#if defined(METRIC_KERNELS_AVX512)
+  case isa::avx512: return &avx512::table;
+#endif
+  case isa::generic: return &generic::table;
+  default: return nullptr;
+  }
+}
+
+/* Best supported level, limited by `METRIC_KERNELS_ISA` if set. */
+isa __select() noexcept {
+  const char* limit = std::getenv("METRIC_KERNELS_ISA");
+  isa best = isa::generic;
+  for (isa level : __levels) {
+    if (isa_supported(level)) best = level;
+    if (limit && std::strcmp(limit, isa_name(level)) == 0) break;
+  }
+  return best;
+}
+
+struct __dispatch {
+  isa level;
+  const __kernel_table* table;
+
+  __dispatch() noexcept : level(__select()), table(__table_of(level)) {}
+};
+
+const __dispatch& __active() noexcept {
+  static const __dispatch d;
+  return d;
+}
+
+}  // namespace
+
+const char* isa_name(isa level) noexcept {
+  switch (level) {
+  case isa::avx2: return "avx2";
+  case isa::avx512: return "avx512";
+  default: return "generic";
+  }
+}
+
+bool isa_supported(isa level) noexcept {
+  return __table_of(level) != nullptr && __cpu_supports(level);
+}
+
+isa active_isa() noexcept { return __active().level; }
+
+void affine_i32_f64(const std::int32_t* in, std::size_t n, double scale, double offset, double* out) noexcept {
+  __active().table->affine_i32_f64(in, n, scale, offset, out);
+}
+
+void scale_f64_i32(const double* in, std::size_t n, double scale, std::int32_t* out) noexcept {
+  __active().table->scale_f64_i32(in, n, scale, out);
+}
+
+double sum_f64(const double* in, std::size_t n) noexcept {
+  return __active().table->sum_f64(in, n);
+}
+
+void minmax_i32(const std::int32_t* in, std::size_t n, std::int32_t* min, std::int32_t* max) noexcept {
+  __active().table->minmax_i32(in, n, min, max);
+}
+
+}  // namespace kernels
+}  // namespace metric
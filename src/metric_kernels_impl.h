@@ -0,0 +1,88 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_kernels_impl.h
+ * \brief  Kernels of metric_kernels.h, compiled once per instruction set level.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+ *
+ * Included by metric_kernels_<level>.cpp with `METRIC_KERNELS_ISA` defined to
+ * the level; the compiler vectorizes the loops for the instruction set the
+ * including file is compiled for. The loops are written such that vectorized
+ * and scalar code compute the same results: reductions keep eight independent
+ * partial sums, which are combined in a fixed order.
+**/
+
+#ifndef METRIC_KERNELS_ISA
+#error "define METRIC_KERNELS_ISA before including metric_kernels_impl.h"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#include "metric_kernels_table.h"
+
+namespace metric {
+namespace kernels {
+namespace METRIC_KERNELS_ISA {
+
+namespace {
+
+/* Number of partial sums of the reductions. */
+constexpr std::size_t __lanes = 8;
+
+void affine_i32_f64(const std::int32_t* in, std::size_t n, double scale, double offset, double* out) noexcept {
+  for (std::size_t i = 0; i < n; ++i) out[i] = static_cast<double>(in[i]) * scale + offset;
+}
+
+void scale_f64_i32(const double* in, std::size_t n, double scale, std::int32_t* out) noexcept {
+  for (std::size_t i = 0; i < n; ++i) {
+    const double x = in[i] * scale;
+    out[i] = static_cast<std::int32_t>(x < 0.0 ? x - 0.5 : x + 0.5);
+  }
+}
+
+double sum_f64(const double* in, std::size_t n) noexcept {
+  double acc[__lanes] = { 0.0 };
+  std::size_t i = 0;
+  for (; i + __lanes <= n; i += __lanes)
+    for (std::size_t k = 0; k < __lanes; ++k) acc[k] += in[i + k];
+  double s = ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+  for (; i < n; ++i) s += in[i];
+  return s;
+}
+
+void minmax_i32(const std::int32_t* in, std::size_t n, std::int32_t* min, std::int32_t* max) noexcept {
+  std::int32_t lo = in[0], hi = in[0];
+  for (std::size_t i = 1; i < n; ++i) {
+    lo = in[i] < lo ? in[i] : lo;
+    hi = in[i] > hi ? in[i] : hi;
+  }
+  *min = lo;
+  *max = hi;
+}
+
+}  // namespace
+
+extern const __kernel_table table;
+const __kernel_table table = { affine_i32_f64, scale_f64_i32, sum_f64, minmax_i32 };
+
+}  // namespace METRIC_KERNELS_ISA
+}  // namespace kernels
+}  // namespace metric
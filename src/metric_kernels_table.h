@@ -0,0 +1,54 @@
+/* Copyright (C) 2019 J. Korinth
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA  02110-1301  USA
+ */
+
+/**
+ * \file   metric_kernels_table.h
+ * \brief  Dispatch table of the metric_kernels library.
+ * \author Jens Korinth <jkorinth@gmx.net>
+ * \copyright GNU Lesser General Public License.
+**/
+
+#ifndef METRIC_METRIC_KERNELS_TABLE_H_
+#define METRIC_METRIC_KERNELS_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace metric {
+namespace kernels {
+
+/* Kernels of one instruction set level; see metric_kernels.h for their semantics. */
+struct __kernel_table {
+  void (*affine_i32_f64)(const std::int32_t*, std::size_t, double, double, double*) noexcept;
+  void (*scale_f64_i32)(const double*, std::size_t, double, std::int32_t*) noexcept;
+  double (*sum_f64)(const double*, std::size_t) noexcept;
+  void (*minmax_i32)(const std::int32_t*, std::size_t, std::int32_t*, std::int32_t*) noexcept;
+};
+
+namespace generic { extern const __kernel_table table; }
+#if defined(METRIC_KERNELS_AVX2)
+namespace avx2 { extern const __kernel_table table; }
+#endif
+#if defined(METRIC_KERNELS_AVX512)
+namespace avx512 { extern const __kernel_table table; }
+#endif
+
+}  // namespace kernels
+}  // namespace metric
+
+#endif  // METRIC_METRIC_KERNELS_TABLE_H_
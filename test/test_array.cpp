@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <type_traits>
+#include <stdexcept>
+#include "metric_array.h"
+
+using namespace metric;
+using namespace metric::literals;
+
+TEST(ArrayTest, distance_array_basics) {
+  distance_array<millimeters<std::int32_t>> a;
+  EXPECT_TRUE(a.empty());
+  for (std::int32_t i = 0; i < 100; ++i) a.push_back(millimeters<std::int32_t>(i));
+  EXPECT_EQ(a.size(), 100u);
+  EXPECT_EQ(a[42], 42_mm);
+  EXPECT_EQ(a.back(), 99_mm);
+  EXPECT_THROW(a.at(100), std::out_of_range);
+
+  distance_array<millimeters<std::int32_t>> b(a);
+  EXPECT_EQ(a, b);
+  b[0] = millimeters<std::int32_t>(1);
+  EXPECT_NE(a, b);
+
+  distance_array<millimeters<std::int32_t>> c(std::move(b));
+  EXPECT_TRUE(b.empty());
+  EXPECT_EQ(c[0], 1_mm);
+
+  c.resize(200);
+  EXPECT_EQ(c[150], 0_mm);
+  c.resize(10);
+  c.shrink_to_fit();
+  EXPECT_EQ(c.capacity(), 10u);
+
+  auto* p = c.append_uninitialized(5);
+  for (int i = 0; i < 5; ++i) p[i] = millimeters<std::int32_t>(7);
+  EXPECT_EQ(c.size(), 15u);
+  EXPECT_EQ(c.view()[14], 7_mm);
+}
+
+TEST(ArrayTest, self_referencing_growth) {
+  distance_array<millimeters<std::int32_t>> a;
+  a.push_back(millimeters<std::int32_t>(3));
+  for (int i = 0; i < 5; ++i) {
+    a.shrink_to_fit();
+    a.push_back(a[0]);
+  }
+  EXPECT_EQ(a.back(), 3_mm);
+  a.resize(a.capacity());
+  a[0] = millimeters<std::int32_t>(5);
+  a.resize(a.size() + 100, a[0]);
+  EXPECT_EQ(a.back(), 5_mm);
+}
+
+TEST(ArrayTest, point_array_columns) {
+  point_array<meters<long double>, 3> pts;
+  pts.push_back({ 1.0_m, 2.0_m, 3.0_m });
+  pts.push_back({ 4.0_m, 5.0_m, 6.0_m });
+  EXPECT_EQ(pts.size(), 2u);
+  EXPECT_EQ(pts.x()[1], 4.0_m);
+  EXPECT_EQ(pts.z()[0], 3.0_m);
+  EXPECT_EQ(pts.column(1).size(), 2u);
+  EXPECT_THROW(pts.push_back({ 1.0_m }), std::invalid_argument);
+  pts.clear();
+  EXPECT_TRUE(pts.empty());
+}
+
+TEST(ArrayTest, convert_in_place) {
+  distance_array<micrometers<std::int64_t>> a;
+  for (std::int64_t i = 0; i < 5000; ++i) a.push_back(micrometers<std::int64_t>(i * 1001 - 2000000));
+  const void* storage = a.data();
+  const std::size_t capacity = a.capacity();
+  // same size, converted in place
+  distance_array<millimeters<std::int64_t>> mm = convert_in_place<millimeters<std::int64_t>>(std::move(a));
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(static_cast<const void*>(mm.data()), storage);
+  EXPECT_EQ(mm.capacity(), capacity);
+  ASSERT_EQ(mm.size(), 5000u);
+  for (std::int64_t i = 0; i < 5000; ++i) ASSERT_EQ(mm[i].count(), (i * 1001 - 2000000) / 1000) << i;
+  // narrowing, compacted over more than one block
+  auto cm = convert_in_place<centimeters<std::int32_t>>(std::move(mm));
+  static_assert(std::is_same<decltype(cm), distance_array<centimeters<std::int32_t>>>::value, "rebound");
+  EXPECT_EQ(static_cast<const void*>(cm.data()), storage);
+  EXPECT_EQ(cm.capacity(), 2 * capacity);
+  for (std::int64_t i = 0; i < 5000; ++i) ASSERT_EQ(cm[i].count(), (i * 1001 - 2000000) / 1000 / 10) << i;
+  cm.push_back(centimeters<std::int32_t>(1));
+  EXPECT_EQ(cm.back().count(), 1);
+  distance_array<meters<double>> d { meters<double>(1.5), meters<double>(2.25) };
+  const auto f = convert_in_place<millimeters<float>>(std::move(d));
+  EXPECT_EQ(f[1].count(), 2250.0f);
+  EXPECT_TRUE(convert_in_place<meters<float>>(distance_array<meters<double>>()).empty());
+}
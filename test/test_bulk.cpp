@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "metric_bulk.h"
+
+using namespace metric;
+using namespace metric::literals;
+
+TEST(BulkTest, distance_cast_n_contiguous) {
+  std::vector<millimeters<std::int64_t>> in;
+  for (std::int64_t i = 0; i < 100; ++i) in.emplace_back(i * 10);
+  std::vector<centimeters<std::int64_t>> out(in.size());
+  distance_cast_n<centimeters<std::int64_t>>(in.data(), in.size(), out.data());
+  for (std::size_t i = 0; i < in.size(); ++i)
+    EXPECT_EQ(out[i], in[i]);
+}
+
+TEST(BulkTest, distance_cast_n_strided) {
+  struct record { char tag; meters<float> range; float intensity; };
+  std::vector<record> rs;
+  for (int i = 0; i < 10; ++i) rs.push_back(record { 'r', meters<float>(i * 0.5f), 1.0f });
+  strided_distance_view<const meters<float>> v(&rs[0].range, sizeof(record), rs.size());
+  EXPECT_FALSE(v.is_contiguous());
+  std::vector<millimeters<float>> out(v.size());
+  distance_cast_n<millimeters<float>>(v, out.data());
+  for (std::size_t i = 0; i < rs.size(); ++i)
+    EXPECT_FLOAT_EQ(out[i].count(), rs[i].range.count() * 1000.0f);
+}
+
+TEST(BulkTest, make_strided_view) {
+  struct record { std::int32_t id; millimeters<std::int32_t> range; float intensity; };
+  std::vector<record> rs(3000);
+  for (std::size_t i = 0; i < rs.size(); ++i) rs[i].range = millimeters<std::int32_t>(static_cast<std::int32_t>(i) * 7 - 900);
+  const strided_distance_view<millimeters<std::int32_t>> v = make_strided_view(rs.data(), rs.size(), &record::range);
+  EXPECT_EQ(v.stride(), static_cast<std::ptrdiff_t>(sizeof(record)));
+  EXPECT_EQ(v[2].count(), -886);
+  // more elements than fit into one block
+  std::vector<meters<double>> out(v.size());
+  distance_cast_n<meters<double>>(v, out.data());
+  for (std::size_t i = 0; i < rs.size(); ++i) ASSERT_DOUBLE_EQ(out[i].count(), rs[i].range.count() / 1000.0) << i;
+  const record* crs = rs.data();
+  strided_view<const millimeters<std::int32_t>> cv = make_strided_view(crs, rs.size(), &record::range);
+  std::vector<millimeters<std::int32_t>> g(10);
+  cv.gather(5, 10, g.data());
+  EXPECT_EQ(g[9].count(), 14 * 7 - 900);
+  EXPECT_TRUE(make_strided_view(crs, 0, &record::range).empty());
+}
+
+TEST(BulkTest, strided_view_store) {
+  std::vector<std::int32_t> raw { 1, 2, 3, 4, 5, 6 };
+  strided_view<std::int32_t> evens(raw.data(), 2 * sizeof(std::int32_t), 3);
+  evens.store(1, 42);
+  EXPECT_EQ(raw[2], 42);
+  strided_view<const std::int32_t> ro(evens);
+  std::int32_t sum = 0;
+  for (auto c : ro) sum += c;
+  EXPECT_EQ(sum, 1 + 42 + 5);
+  EXPECT_EQ(ro.subview(1, 2)[1], 5);
+}
+
+TEST(BulkTest, calibrated_cast_n) {
+  std::vector<std::int32_t> counts { -2, -1, 0, 1, 1000 };
+  linear_calibration<std::ratio<1>> cal { 0.01, 100.0 };  // cm counts, 100 m origin
+  std::vector<millimeters<std::int64_t>> mm(counts.size());
+  calibrated_cast_n(counts.data(), counts.size(), cal, mm.data());
+  EXPECT_EQ(mm[0], millimeters<std::int64_t>(99980));
+  EXPECT_EQ(mm[1], millimeters<std::int64_t>(99990));
+  EXPECT_EQ(mm[2], millimeters<std::int64_t>(100000));
+  EXPECT_EQ(mm[3], millimeters<std::int64_t>(100010));
+  EXPECT_EQ(mm[4], millimeters<std::int64_t>(110000));
+
+  linear_calibration<std::kilo> km_cal { 0.001, 0.0 };  // counts are meters
+  std::vector<meters<double>> m(counts.size());
+  calibrated_cast_n(strided_view<const std::int32_t>(counts.data(), counts.size()), km_cal, m.data());
+  EXPECT_DOUBLE_EQ(m[4].count(), 1000.0);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "metric.h"
+
+using namespace metric;
+using namespace metric::literals;
+
+#if !defined(METRIC_COUNT_CONVERSIONS)
+#error "test_conversions.cpp must be compiled with METRIC_COUNT_CONVERSIONS"
+#endif
+
+static_assert(distance_cast<millimeters<int>>(centimeters<int>(3)).count() == 30,
+              "instrumented casts remain constant expressions");
+
+TEST(ConversionCountTest, counts_rescaling_casts_per_type_pair) {
+  reset_conversion_counts();
+  for (int i = 0; i < 5; ++i) distance_cast<millimeters<std::int64_t>>(meters<std::int64_t>(i));
+  distance_cast<meters<double>>(millimeters<double>(1.0));
+  distance_cast<meters<double>>(meters<std::int64_t>(1));   // identity ratio: not counted
+
+  const std::vector<conversion_record> c = conversion_counts();
+  ASSERT_EQ(c.size(), 2u);
+  EXPECT_EQ(c[0].count, 5u);
+  EXPECT_NE(c[0].from.find("1/1 m"), std::string::npos);
+  EXPECT_NE(c[0].to.find("1/1000 m"), std::string::npos);
+  EXPECT_EQ(c[1].count, 1u);
+}
+
+TEST(ConversionCountTest, counts_operator_rescales) {
+  reset_conversion_counts();
+  const auto d = 1_cm + 5_m;      // 5 m are rescaled to cm
+  EXPECT_EQ(d, 501_cm);
+  EXPECT_TRUE(5_cm > 15_mm);      // 5 cm are rescaled to mm
+  std::uint64_t total = 0;
+  for (const conversion_record& r : conversion_counts()) total += r.count;
+  EXPECT_EQ(total, 2u);
+}
+
+#if defined(_METRIC_HAS_SOURCE_LOCATION)
+TEST(ConversionCountTest, counts_call_sites) {
+  reset_conversion_counts();
+  for (int i = 0; i < 3; ++i) distance_cast<millimeters<int>>(centimeters<int>(i));
+  distance_cast<millimeters<int>>(centimeters<int>(1));
+
+  const std::vector<conversion_record> s = conversion_sites();
+  ASSERT_EQ(s.size(), 2u);
+  EXPECT_EQ(s[0].count, 3u);
+  EXPECT_EQ(s[1].count, 1u);
+  EXPECT_NE(s[0].site.find("test_conversions.cpp"), std::string::npos);
+  EXPECT_EQ(conversion_counts().at(0).count, 4u);
+}
+
+TEST(ConversionCountTest, counts_call_sites_from_threads) {
+  reset_conversion_counts();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+    threads.emplace_back([] {
+      for (int i = 0; i < 1000; ++i) distance_cast<micrometers<int>>(millimeters<int>(i));
+    });
+  for (std::thread& t : threads) t.join();
+  const std::vector<conversion_record> s = conversion_sites();
+  ASSERT_EQ(s.size(), 1u);
+  EXPECT_EQ(s[0].count, 4000u);
+  reset_conversion_counts();
+  EXPECT_TRUE(conversion_sites().empty());
+}
+#endif
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include "metric_format.h"
+
+using namespace metric;
+
+namespace {
+
+constexpr format_spec parse(std::string_view s, bool integral = false) {
+  format_spec spec;
+  spec.parse(s.begin(), s.end(), integral);
+  return spec;
+}
+
+constexpr bool valid(std::string_view s, bool integral = false) { return parse(s, integral).error == nullptr; }
+
+template <typename Distance>
+std::string fmt(const Distance& d, std::string_view s = "") {
+  const format_spec spec = parse(s, !std::is_floating_point<typename Distance::repr>::value);
+  EXPECT_EQ(spec.error, nullptr) << s;
+  std::string out;
+  format_distance(std::back_inserter(out), d, spec);
+  return out;
+}
+
+}  // namespace
+
+TEST(FormatTest, parse) {
+  static_assert(valid("") && valid("}") && valid("a}") && valid("m") && valid("Mm"), "units");
+  static_assert(valid("*^#12.3km}") && valid("<5") && valid(".0"), "full specifications");
+  static_assert(parse("*^#12.3km").fill == '*' && parse("*^#12.3km").align == '^', "fill and align");
+  static_assert(parse("*^#12.3km").bare && parse("*^#12.3km").width == 12, "bare and width");
+  static_assert(parse("*^#12.3km").precision == 3 && parse("*^#12.3km").unit == format_unit::km, "precision and unit");
+  static_assert(parse("m").unit == format_unit::m && parse("mm").unit == format_unit::mm, "m and mm");
+  static_assert(!valid("x") && !valid("kmx") && !valid(".") && !valid(".m") && !valid("{<"), "invalid specifications");
+  static_assert(!valid("1000") && !valid(".101"), "width and precision limits");
+  static_assert(!valid(".2", true) && valid(".2m", true) && valid(".2", false), "precision of integral distances");
+}
+
+TEST(FormatTest, native) {
+  EXPECT_EQ(fmt(millimeters<int>(1500)), "1500 mm");
+  EXPECT_EQ(fmt(meters<double>(1.25)), "1.25 m");
+  EXPECT_EQ(fmt(kilometers<std::int64_t>(-3)), "-3 km");
+  EXPECT_EQ(fmt(distance<int, std::ratio<1, 256>>(7)), "7 1/256 m");
+  EXPECT_EQ(fmt(meters<double>(1.0 / 3), ".3"), "0.333 m");
+  EXPECT_EQ(fmt(micrometers<int>(42), "#"), "42");
+}
+
+TEST(FormatTest, units) {
+  EXPECT_EQ(fmt(millimeters<int>(1500), ".2m"), "1.50 m");
+  EXPECT_EQ(fmt(millimeters<int>(1500), "m"), "1.5 m");
+  EXPECT_EQ(fmt(meters<int>(12345), ">#8.1km"), "    12.3");
+  EXPECT_EQ(fmt(kilometers<double>(2.5), "cm"), "250000 cm");
+  EXPECT_EQ(fmt(distance<int, std::ratio<1, 256>>(384), "mm"), "1500 mm");
+}
+
+TEST(FormatTest, automatic) {
+  EXPECT_EQ(fmt(meters<double>(0.004), "a"), "4 mm");
+  EXPECT_EQ(fmt(millimeters<int>(-2500000), "a"), "-2.5 km");
+  EXPECT_EQ(fmt(nanometers<std::int64_t>(1500), "a"), "1.5 um");
+  EXPECT_EQ(fmt(kilometers<int>(7000), ".1a"), "7.0 Mm");
+  EXPECT_EQ(fmt(meters<int>(0), "a"), "0 m");
+}
+
+TEST(FormatTest, alignment) {
+  EXPECT_EQ(fmt(meters<int>(5), "8"), "     5 m");
+  EXPECT_EQ(fmt(meters<int>(5), "<8"), "5 m     ");
+  EXPECT_EQ(fmt(meters<int>(5), "*^8"), "**5 m***");
+  EXPECT_EQ(fmt(meters<int>(12345), "2"), "12345 m");
+}
+
+TEST(FormatTest, output_iterators) {
+  char buf[32];
+  const format_spec spec = parse(".1a");
+  char* end = format_distance(buf, millimeters<int>(1234), spec);
+  EXPECT_EQ(std::string(buf, end), "1.2 m");
+  // fixed notation does not fit the stack buffer: falls back to scientific notation
+  EXPECT_EQ(fmt(meters<long double>(1e1000L), ".2"), "1.00e+1000 m");
+}
+
+#if defined(METRIC_EXPERIMENTAL_FORMATTER) && defined(__cpp_lib_format)
+TEST(FormatTest, std_format) {
+  EXPECT_EQ(std::format("{}", millimeters<int>(1500)), "1500 mm");
+  EXPECT_EQ(std::format("{:.2m}", millimeters<int>(1500)), "1.50 m");
+  EXPECT_EQ(std::format("{:a}", meters<double>(0.0042)), "4.2 mm");
+  EXPECT_EQ(std::format("[{:>#8.1km}]", meters<int>(12345)), "[    12.3]");
+}
+#endif
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
+#include "metric_hash.h"
+
+using namespace metric;
+
+TEST(HashTest, unit_normalized) {
+  const std::size_t h = hash_value(millimeters<int>(50));
+  EXPECT_EQ(hash_value(centimeters<int>(5)), h);
+  EXPECT_EQ(hash_value(micrometers<std::int64_t>(50000)), h);
+  EXPECT_EQ(hash_value(meters<double>(0.05)), h);
+  EXPECT_EQ(std::hash<centimeters<short>>()(centimeters<short>(5)), h);
+  EXPECT_NE(hash_value(millimeters<int>(51)), h);
+  EXPECT_EQ(hash_value(distance<int, std::ratio<1, 256>>(-3)), hash_value(nanometers<std::int64_t>(-11718750)));
+  EXPECT_EQ(hash_value(kilometers<int>(-7)), hash_value(meters<std::int64_t>(-7000)));
+}
+
+TEST(HashTest, unordered_set) {
+  std::unordered_set<millimeters<std::int64_t>> s;
+  for (int i = 0; i < 1000; ++i) s.insert(millimeters<std::int64_t>(i % 100));
+  EXPECT_EQ(s.size(), 100u);
+  EXPECT_EQ(s.count(millimeters<std::int64_t>(42)), 1u);
+}
+
+TEST(HashTest, hash_n) {
+  std::vector<millimeters<std::int32_t>> d;
+  for (std::int32_t i = -500; i < 500; ++i) d.push_back(millimeters<std::int32_t>(i * 7919));
+  std::vector<std::size_t> h(d.size());
+  hash_n(d.data(), d.size(), h.data());
+  for (std::size_t i = 0; i < d.size(); ++i) ASSERT_EQ(h[i], hash_value(d[i])) << i;
+}
+
+TEST(HashTest, quantizer) {
+  const distance_quantizer<centimeters<int>> q(centimeters<int>(10));
+  EXPECT_EQ(q(millimeters<int>(0)), 0);
+  EXPECT_EQ(q(millimeters<int>(99)), 0);
+  EXPECT_EQ(q(millimeters<int>(100)), 1);
+  EXPECT_EQ(q(millimeters<int>(-1)), -1);
+  EXPECT_EQ(q(millimeters<int>(-100)), -1);
+  EXPECT_EQ(q(millimeters<int>(-101)), -2);
+  EXPECT_EQ(q(meters<double>(0.25)), 2);
+  EXPECT_EQ(q(meters<double>(-0.05)), -1);
+  EXPECT_EQ(q(distance<int, std::ratio<1, 3>>(3)), 10);  // exactly one meter
+  EXPECT_EQ(q.lower(-2), centimeters<int>(-20));
+  EXPECT_THROW(distance_quantizer<meters<int>>(meters<int>(0)), std::invalid_argument);
+}
+
+TEST(HashTest, aggregate) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<std::int32_t> dist(-100000, 100000);
+  std::vector<millimeters<std::int32_t>> d(100000);
+  for (auto& x : d) x = millimeters<std::int32_t>(dist(rng));
+
+  distance_aggregate<millimeters<std::int32_t>, meters<std::int64_t>> a(meters<std::int64_t>(1));
+  a.add_n(d.data(), d.size());
+
+  struct ref { std::size_t count = 0; std::int64_t sum = 0; std::int32_t min = INT32_MAX, max = INT32_MIN; };
+  std::map<std::int64_t, ref> r;
+  for (const auto& x : d) {
+    ref& g = r[x.count() >= 0 ? x.count() / 1000 : (x.count() - 999) / 1000];
+    ++g.count;
+    g.sum += x.count();
+    if (x.count() < g.min) g.min = x.count();
+    if (x.count() > g.max) g.max = x.count();
+  }
+  ASSERT_EQ(a.size(), r.size());
+  EXPECT_EQ(a.begin()->key, a.quantizer()(d[0]));
+  for (const auto& g : a) {
+    const ref& e = r.at(g.key);
+    EXPECT_EQ(g.count, e.count) << g.key;
+    EXPECT_EQ(g.sum.count(), e.sum) << g.key;
+    EXPECT_EQ(g.min.count(), e.min) << g.key;
+    EXPECT_EQ(g.max.count(), e.max) << g.key;
+    EXPECT_LE(a.lower(g.key), g.min);
+  }
+  ASSERT_NE(a.find(meters<double>(-99.5)), nullptr);
+  EXPECT_EQ(a.find(meters<double>(-99.5))->key, -100);
+  EXPECT_EQ(a.find(std::int64_t(5000)), nullptr);
+
+  distance_aggregate<millimeters<std::int32_t>, meters<std::int64_t>> b(meters<std::int64_t>(1));
+  for (const auto& x : d) b.add(x);
+  ASSERT_EQ(b.size(), a.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(b.begin()[i].key, a.begin()[i].key);
+    EXPECT_EQ(b.begin()[i].sum, a.begin()[i].sum);
+  }
+
+  // enough groups for batches to hash ahead
+  distance_aggregate<millimeters<std::int32_t>, centimeters<std::int64_t>> fine(centimeters<std::int64_t>(1));
+  distance_aggregate<millimeters<std::int32_t>, centimeters<std::int64_t>> fine_ref(centimeters<std::int64_t>(1));
+  fine.add_n(d.data(), d.size());
+  for (const auto& x : d) fine_ref.add(x);
+  ASSERT_GT(fine.size(), 10000u);
+  ASSERT_EQ(fine.size(), fine_ref.size());
+  for (std::size_t i = 0; i < fine.size(); ++i) {
+    ASSERT_EQ(fine.begin()[i].key, fine_ref.begin()[i].key);
+    ASSERT_EQ(fine.begin()[i].count, fine_ref.begin()[i].count);
+    ASSERT_EQ(fine.begin()[i].min, fine_ref.begin()[i].min);
+  }
+  a.clear();
+  EXPECT_TRUE(a.empty());
+  EXPECT_EQ(a.find(std::int64_t(0)), nullptr);
+}
+
+TEST(HashTest, strided) {
+  struct record { std::int32_t id; millimeters<std::int32_t> range; meters<double> height; };
+  std::vector<record> rs(1000);
+  for (std::size_t i = 0; i < rs.size(); ++i) {
+    rs[i].range = millimeters<std::int32_t>(static_cast<std::int32_t>(i * 37 % 1000));
+    rs[i].height = meters<double>(static_cast<double>(i % 3));
+  }
+  const auto ranges = make_strided_view(rs.data(), rs.size(), &record::range);
+  std::vector<std::size_t> h(rs.size());
+  hash_n(ranges, h.data());
+  for (std::size_t i = 0; i < rs.size(); ++i) ASSERT_EQ(h[i], hash_value(rs[i].range)) << i;
+  std::vector<std::int64_t> k(rs.size());
+  const distance_quantizer<centimeters<int>> q(centimeters<int>(10));
+  q(ranges, k.data());
+  EXPECT_EQ(k[1], 0);
+  EXPECT_EQ(k[30], 1);
+  distance_aggregate<millimeters<std::int32_t>, centimeters<int>> a(centimeters<int>(10));
+  a.add_n(ranges);
+  EXPECT_EQ(a.size(), 10u);
+  EXPECT_EQ(a.find(millimeters<std::int32_t>(0))->count, 100u);
+  distance_aggregate<meters<double>, centimeters<int>> b(centimeters<int>(50));
+  b.add_n(ranges, make_strided_view(rs.data(), rs.size(), &record::height));
+  EXPECT_EQ(b.size(), 2u);
+  EXPECT_THROW(b.add_n(ranges, make_strided_view(rs.data(), 10, &record::height)), std::invalid_argument);
+}
+
+TEST(HashTest, aggregate_by_key) {
+  const meters<double> keys[] = { meters<double>(0.5), meters<double>(12.0), meters<double>(3.0), meters<double>(15.0) };
+  const millimeters<double> values[] = { millimeters<double>(1), millimeters<double>(2),
+                                         millimeters<double>(4), millimeters<double>(8) };
+  distance_aggregate<millimeters<double>, meters<int>> a(meters<int>(10));
+  a.add_n(keys, values, 4);
+  ASSERT_EQ(a.size(), 2u);
+  EXPECT_EQ(a.find(std::int64_t(0))->sum.count(), 5.0);
+  EXPECT_EQ(a.find(std::int64_t(1))->count, 2u);
+  EXPECT_EQ(a.find(std::int64_t(1))->max, millimeters<double>(8));
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "metric_histogram.h"
+#include "metric_parallel.h"
+
+using namespace metric;
+
+namespace {
+
+/* Reference bin index plus 1 by floor division, `width` given as `p / q` units. */
+std::size_t reference(std::int64_t x, std::int64_t origin, std::int64_t p, std::int64_t q, std::size_t bins) {
+  const std::int64_t n = (x - origin) * q;
+  if (n < 0) return 0;
+  const std::uint64_t k = static_cast<std::uint64_t>(n / p);
+  return k >= bins ? bins + 1 : k + 1;
+}
+
+}  // namespace
+
+TEST(HistogramTest, integral_boundaries) {
+  const fixed_bins<millimeters<std::int32_t>> bins(meters<int>(-1), centimeters<int>(10), 30);
+  EXPECT_EQ(bins.bins(), 30u);
+  EXPECT_DOUBLE_EQ(bins.width(), 100.0);
+  EXPECT_DOUBLE_EQ(bins.lower(30).count(), 2000.0);
+  for (std::int32_t x = -1200; x <= 2200; ++x)
+    ASSERT_EQ(bins(millimeters<std::int32_t>(x)), reference(x, -1000, 100, 1, 30)) << x;
+  EXPECT_EQ(bins(millimeters<std::int32_t>(INT32_MIN)), 0u);
+  EXPECT_EQ(bins(millimeters<std::int32_t>(INT32_MAX)), 31u);
+}
+
+TEST(HistogramTest, fractional_width) {
+  // 1 cm is 2.56 units of 1/256 m: bin boundaries fall between units
+  using fine = distance<std::int32_t, std::ratio<1, 256>>;
+  const fixed_bins<fine> bins(meters<int>(0), centimeters<int>(1), 1000);
+  for (std::int32_t x = -10; x <= 2600; ++x) ASSERT_EQ(bins(fine(x)), reference(x, 0, 64, 25, 1000)) << x;
+  const fixed_bins<millimeters<std::int64_t>> odd(millimeters<int>(3), micrometers<int>(2500), 7);
+  for (std::int64_t x = -5; x <= 30; ++x) ASSERT_EQ(odd(millimeters<std::int64_t>(x)), reference(x, 3, 5, 2, 7)) << x;
+}
+
+TEST(HistogramTest, sub_unit_width) {
+  // 5 mm is half a unit: everything below the origin is below the first bin
+  const fixed_bins<centimeters<std::int32_t>> bins(centimeters<int>(10), millimeters<int>(5), 4);
+  EXPECT_EQ(bins(centimeters<std::int32_t>(7)), 0u);
+  EXPECT_EQ(bins(centimeters<std::int32_t>(8)), 0u);
+  EXPECT_EQ(bins(centimeters<std::int32_t>(9)), 0u);
+  EXPECT_EQ(bins(centimeters<std::int32_t>(INT32_MIN)), 0u);
+  for (std::int32_t x = -5; x <= 20; ++x) ASSERT_EQ(bins(centimeters<std::int32_t>(x)), reference(x, 10, 1, 2, 4)) << x;
+  EXPECT_EQ(bins(centimeters<std::int32_t>(INT32_MAX)), 5u);
+}
+
+TEST(HistogramTest, floating_point) {
+  const fixed_bins<meters<double>> bins(meters<double>(0.5), centimeters<int>(25), 4);
+  EXPECT_EQ(bins(meters<double>(0.4)), 0u);
+  EXPECT_EQ(bins(meters<double>(0.5)), 1u);
+  EXPECT_EQ(bins(meters<double>(0.8)), 2u);
+  EXPECT_EQ(bins(meters<double>(1.49)), 4u);
+  EXPECT_EQ(bins(meters<double>(1.5)), 5u);
+  EXPECT_EQ(bins(meters<double>(std::numeric_limits<double>::quiet_NaN())), 0u);
+  EXPECT_EQ(bins(meters<double>(std::numeric_limits<double>::infinity())), 5u);
+}
+
+TEST(HistogramTest, invalid) {
+  using mm = millimeters<std::int32_t>;
+  EXPECT_THROW(fixed_bins<mm>(mm(0), mm(0), 10), std::invalid_argument);
+  EXPECT_THROW(fixed_bins<mm>(mm(0), mm(-5), 10), std::invalid_argument);
+  EXPECT_THROW(fixed_bins<mm>(mm(0), mm(5), 0), std::invalid_argument);
+  EXPECT_THROW(fixed_bins<mm>(mm(0), kilometers<int>(1), 1u << 12), std::domain_error);
+  EXPECT_NO_THROW(fixed_bins<mm>(mm(0), kilometers<int>(1), 1000));
+}
+
+TEST(HistogramTest, histogram_n) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<std::int32_t> dist(-500, 100500);
+  std::vector<millimeters<std::int32_t>> v(100000);
+  for (auto& d : v) d = millimeters<std::int32_t>(dist(gen));
+  const fixed_bins<millimeters<std::int32_t>> bins(meters<int>(0), centimeters<int>(10), 1000);
+  std::vector<std::uint64_t> expected(bins.bins() + 2), counts(bins.bins() + 2, 0);
+  for (const auto& d : v) ++expected[reference(d.count(), 0, 100, 1, 1000)];
+  histogram_n(v.data(), v.size(), bins, counts.data());
+  EXPECT_EQ(counts, expected);
+  // adds to the counts, small inputs count directly
+  histogram_n(v.data(), 10, bins, counts.data());
+  for (std::size_t i = 0; i < 10; ++i) ++expected[bins(v[i])];
+  EXPECT_EQ(counts, expected);
+}
+
+TEST(HistogramTest, strided) {
+  struct record { float intensity; millimeters<std::int32_t> range; };
+  std::vector<record> rs(5000);
+  for (std::size_t i = 0; i < rs.size(); ++i) rs[i].range = millimeters<std::int32_t>(static_cast<std::int32_t>(i * 31 % 2100) - 50);
+  const fixed_bins<millimeters<std::int32_t>> bins(meters<int>(0), centimeters<int>(10), 20);
+  std::vector<std::uint64_t> expected(bins.bins() + 2, 0), counts(bins.bins() + 2, 0), parallel(bins.bins() + 2, 0);
+  for (const auto& r : rs) ++expected[bins(r.range)];
+  const auto v = make_strided_view(rs.data(), rs.size(), &record::range);
+  histogram_n(v, bins, counts.data());
+  EXPECT_EQ(counts, expected);
+  parallel_histogram_n(v, bins, parallel.data(), 3);
+  EXPECT_EQ(parallel, expected);
+  std::vector<std::size_t> k(rs.size());
+  bins(v, k.data());
+  EXPECT_EQ(k[7], bins(rs[7].range));
+}
+
+TEST(HistogramTest, parallel_histogram_n) {
+  std::mt19937 gen(7);
+  std::normal_distribution<double> dist(50.0, 20.0);
+  std::vector<meters<float>> v((1 << 18) + 13);
+  for (auto& d : v) d = meters<float>(static_cast<float>(dist(gen)));
+  const fixed_bins<meters<float>> bins(meters<int>(0), centimeters<int>(50), 200);
+  std::vector<std::uint64_t> serial(bins.bins() + 2, 0), parallel(bins.bins() + 2, 0);
+  histogram_n(v.data(), v.size(), bins, serial.data());
+  parallel_histogram_n(v.data(), v.size(), bins, parallel.data(), 4);
+  EXPECT_EQ(parallel, serial);
+}
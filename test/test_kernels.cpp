@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "metric_kernels.h"
+
+using namespace metric;
+
+TEST(KernelsTest, selects_requested_isa) {
+  const char* forced = std::getenv("METRIC_KERNELS_ISA");
+  const kernels::isa active = kernels::active_isa();
+  EXPECT_TRUE(kernels::isa_supported(active));
+  EXPECT_TRUE(kernels::isa_supported(kernels::isa::generic));
+  if (!forced) return;
+  for (kernels::isa level : { kernels::isa::generic, kernels::isa::avx2, kernels::isa::avx512 }) {
+    if (std::strcmp(forced, kernels::isa_name(level)) != 0) continue;
+    if (!kernels::isa_supported(level)) GTEST_SKIP() << forced << " is not supported here";
+    EXPECT_EQ(active, level);
+  }
+}
+
+TEST(KernelsTest, casts) {
+  std::vector<millimeters<std::int32_t>> in;
+  for (std::int32_t i = -500; i < 1500; ++i) in.push_back(millimeters<std::int32_t>(i * 37));
+  std::vector<meters<double>> m(in.size());
+  kernels::cast_n(in.data(), in.size(), m.data());
+  for (std::size_t i = 0; i < in.size(); ++i) ASSERT_EQ(m[i].count(), in[i].count() * 0.001) << i;
+
+  std::vector<centimeters<std::int32_t>> cm(in.size());
+  kernels::cast_n(m.data(), m.size(), cm.data());
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    const double x = m[i].count() * 100.0;
+    ASSERT_EQ(cm[i].count(), static_cast<std::int32_t>(x < 0 ? x - 0.5 : x + 0.5)) << i;
+  }
+
+  distance_array<millimeters<std::int32_t>> a({ millimeters<std::int32_t>(1), millimeters<std::int32_t>(-2) });
+  distance_array<micrometers<double>> um;
+  kernels::cast(a, um);
+  ASSERT_EQ(um.size(), 2u);
+  EXPECT_EQ(um.data()[1].count(), -2000.0);
+
+  const std::int32_t counts[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  meters<double> cal[10];
+  kernels::calibrated_cast_n(counts, 10, linear_calibration<std::milli> { 0.25, 100.0 }, cal);
+  EXPECT_DOUBLE_EQ(cal[9].count(), 0.10225);
+}
+
+TEST(KernelsTest, reductions) {
+  for (std::size_t n : { 1, 7, 8, 9, 1000, 4099 }) {
+    std::vector<meters<double>> d(n);
+    std::vector<millimeters<std::int32_t>> c(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      d[i] = meters<double>(0.1 * static_cast<double>((i * 7919) % 1013) - 30.0);
+      c[i] = millimeters<std::int32_t>(static_cast<std::int32_t>((i * 7919) % 1013) - 400);
+    }
+    // reference with the documented summation order
+    double acc[8] = { 0.0 };
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+      for (std::size_t k = 0; k < 8; ++k) acc[k] += d[i + k].count();
+    double s = ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+    for (; i < n; ++i) s += d[i].count();
+    ASSERT_EQ(kernels::sum(d.data(), n).count(), s) << n;
+
+    std::int32_t lo = std::numeric_limits<std::int32_t>::max(), hi = std::numeric_limits<std::int32_t>::min();
+    for (const millimeters<std::int32_t>& x : c) {
+      lo = std::min(lo, x.count());
+      hi = std::max(hi, x.count());
+    }
+    const auto mm = kernels::minmax(c.data(), n);
+    ASSERT_EQ(mm.first.count(), lo) << n;
+    ASSERT_EQ(mm.second.count(), hi) << n;
+  }
+}
+
+TEST(KernelsTest, strided) {
+  struct record { std::int32_t id; millimeters<std::int32_t> range; meters<double> height; };
+  std::vector<record> r(3000);
+  for (std::size_t i = 0; i < r.size(); ++i) {
+    r[i].range = millimeters<std::int32_t>(static_cast<std::int32_t>((i * 7919) % 1013) - 400);
+    r[i].height = meters<double>(0.5 * static_cast<double>(i % 17));
+  }
+  const record* p = r.data();
+  std::vector<meters<double>> m(r.size());
+  kernels::cast_n(make_strided_view(p, r.size(), &record::range), m.data());
+  for (std::size_t i = 0; i < r.size(); ++i) ASSERT_EQ(m[i].count(), r[i].range.count() * 0.001) << i;
+  const auto mm = kernels::minmax(make_strided_view(p, r.size(), &record::range));
+  EXPECT_EQ(mm.first.count(), -400);
+  EXPECT_EQ(mm.second.count(), 612);
+  double s = 0.0;
+  for (const record& x : r) s += x.height.count();
+  EXPECT_DOUBLE_EQ(kernels::sum(make_strided_view(r.data(), r.size(), &record::height)).count(), s);
+}
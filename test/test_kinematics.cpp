@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "metric_kinematics.h"
+
+using namespace metric;
+using namespace std::chrono;
+
+TEST(KinematicsTest, trapezoid_is_exact_for_linear_velocity) {
+  // v(t) = 2 mm/s * t[s] sampled at irregular ms timestamps; x(t) = 1 mm * t^2
+  const std::vector<milliseconds> t = { milliseconds(0), milliseconds(1000), milliseconds(1500),
+                                        milliseconds(3000), milliseconds(4000) };
+  std::vector<millimeters_per_second<std::int64_t>> v;
+  for (const milliseconds& s : t) v.emplace_back(2 * s.count() / 1000);
+  std::vector<micrometers<std::int64_t>> x(t.size());
+  integrate_trapezoid(t.data(), v.data(), t.size(), x.data());
+  EXPECT_EQ(x[0].count(), 0);
+  EXPECT_EQ(x[1].count(), 1000);
+  EXPECT_EQ(x[2].count(), 2250);
+  EXPECT_EQ(x[3].count(), 9000);
+  EXPECT_EQ(x[4].count(), 16000);
+}
+
+TEST(KinematicsTest, trapezoid_rounds_once) {
+  // 1 mm/s for 1 ms in steps: each step adds 1 um exactly; 1/2 um steps must not accumulate errors
+  const std::size_t n = 2000;
+  std::vector<steady_clock::time_point> t(n);
+  std::vector<millimeters_per_second<std::int64_t>> v(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    t[i] = steady_clock::time_point(milliseconds(i));
+    v[i] = millimeters_per_second<std::int64_t>(i % 2);
+  }
+  std::vector<micrometers<std::int64_t>> x(n);
+  integrate_trapezoid(t.data(), v.data(), n, x.data(), micrometers<std::int64_t>(7));
+  for (std::size_t i = 0; i < n; ++i) ASSERT_EQ(x[i].count(), 7 + static_cast<std::int64_t>(i) / 2) << i;
+}
+
+TEST(KinematicsTest, trapezoid_floating_point) {
+  const std::size_t n = 1001;
+  std::vector<duration<double>> t(n);
+  std::vector<meters_per_second<double>> v(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    t[i] = duration<double>(i * 0.01);
+    v[i] = meters_per_second<double>(2.0 * t[i].count());
+  }
+  std::vector<meters<double>> x(n);
+  integrate_trapezoid(t.data(), v.data(), n, x.data());
+  EXPECT_NEAR(x[n - 1].count(), 100.0, 1e-9);
+  EXPECT_NEAR(x[500].count(), 25.0, 1e-9);
+}
+
+TEST(KinematicsTest, simpson_is_exact_for_cubics) {
+  // v(t) = t^3 mm/s at t = 0..8 s; x(t) = t^4 / 4 mm
+  std::vector<millimeters_per_second<std::int64_t>> v;
+  for (std::int64_t i = 0; i <= 8; ++i) v.emplace_back(i * i * i);
+  std::vector<micrometers<std::int64_t>> x(5);
+  EXPECT_EQ(integrate_simpson(v.data(), v.size(), seconds(1), x.data()), 5u);
+  for (std::int64_t k = 0; k < 5; ++k) EXPECT_EQ(x[k].count(), 250 * (2 * k) * (2 * k) * (2 * k) * (2 * k)) << k;
+  EXPECT_EQ(integrate_simpson(v.data(), 0, seconds(1), x.data()), 0u);
+  EXPECT_EQ(integrate_simpson(v.data(), 4, seconds(1), x.data()), 2u);  // trailing interval is dropped
+  EXPECT_EQ(x[1].count(), 4000);
+}
+
+TEST(KinematicsTest, integral_overflow_throws) {
+  // 1 km/s in mm/s with ns timestamps: the accumulator counts 1/2 pm and holds about 4600 km
+  const std::size_t n = 6001;
+  std::vector<nanoseconds> t(n);
+  std::vector<millimeters_per_second<std::int64_t>> v(n, millimeters_per_second<std::int64_t>(1000000));
+  for (std::size_t i = 0; i < n; ++i) t[i] = seconds(static_cast<std::int64_t>(i));
+  std::vector<meters<std::int64_t>> x(n);
+  integrate_trapezoid(t.data(), v.data(), 4001, x.data());
+  EXPECT_EQ(x[4000].count(), 4000000);
+  EXPECT_THROW(integrate_trapezoid(t.data(), v.data(), n, x.data()), std::overflow_error);
+  EXPECT_THROW(integrate_simpson(v.data(), n, nanoseconds(seconds(1)), x.data()), std::overflow_error);
+  std::vector<millimeters_per_second<std::int64_t>> fast(3, millimeters_per_second<std::int64_t>(INT64_MAX / 2));
+  EXPECT_THROW(integrate_trapezoid(t.data(), fast.data(), 3, x.data()), std::overflow_error);
+  // floating-point samples are not limited
+  std::vector<millimeters_per_second<double>> vd(n, millimeters_per_second<double>(1e6));
+  std::vector<meters<double>> xd(n);
+  integrate_trapezoid(t.data(), vd.data(), n, xd.data());
+  EXPECT_DOUBLE_EQ(xd[n - 1].count(), 6e6);
+}
+
+TEST(KinematicsTest, differentiate) {
+  const milliseconds t[] = { milliseconds(0), milliseconds(100), milliseconds(300), milliseconds(400) };
+  const millimeters<std::int64_t> d[] = { millimeters<std::int64_t>(0), millimeters<std::int64_t>(100),
+                                          millimeters<std::int64_t>(500), millimeters<std::int64_t>(900) };
+  millimeters_per_second<std::int64_t> v[4];
+  differentiate(t, d, 4, v);
+  EXPECT_EQ(v[0].count(), 1000);
+  EXPECT_EQ(v[1].count(), 1666);
+  EXPECT_EQ(v[2].count(), 2666);
+  EXPECT_EQ(v[3].count(), 4000);
+}
+
+TEST(KinematicsTest, integrate_then_differentiate) {
+  const std::size_t n = 3000;  // spans several blocks
+  std::vector<microseconds> t(n);
+  std::vector<millimeters_per_second<std::int64_t>> v(n, millimeters_per_second<std::int64_t>(250));
+  for (std::size_t i = 0; i < n; ++i) t[i] = microseconds(static_cast<std::int64_t>(i * i % 7 + 10 * i));
+  std::vector<nanometers<std::int64_t>> x(n);
+  integrate_trapezoid(t.data(), v.data(), n, x.data());
+  EXPECT_EQ(x[n - 1].count(), 250 * t[n - 1].count());
+  std::vector<millimeters_per_second<std::int64_t>> w(n);
+  differentiate(t.data(), x.data(), n, w.data());
+  for (std::size_t i = 0; i < n; ++i) ASSERT_EQ(w[i], v[i]) << i;
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "metric_las.h"
+
+using namespace metric;
+using namespace metric::literals;
+
+namespace {
+
+template <typename T>
+void put(std::vector<unsigned char>& buf, std::size_t off, T v) {
+  std::memcpy(&buf[off], &v, sizeof(v));
+}
+
+// Writes a LAS 1.2 file with point format 0 (20 byte records).
+std::string write_las(const std::string& name, const std::vector<std::int32_t>& xyz,
+                      std::uint8_t format = 0) {
+  const std::size_t n = xyz.size() / 3;
+  std::vector<unsigned char> buf(227 + n * 20, 0);
+  std::memcpy(&buf[0], "LASF", 4);
+  put<std::uint8_t>(buf, 24, 1);
+  put<std::uint8_t>(buf, 25, 2);
+  put<std::uint16_t>(buf, 94, 227);
+  put<std::uint32_t>(buf, 96, 227);
+  put<std::uint8_t>(buf, 104, format);
+  put<std::uint16_t>(buf, 105, 20);
+  put<std::uint32_t>(buf, 107, static_cast<std::uint32_t>(n));
+  put<double>(buf, 131, 0.001);   // x scale: mm
+  put<double>(buf, 139, 0.01);    // y scale: cm
+  put<double>(buf, 147, 0.001);   // z scale: mm
+  put<double>(buf, 155, 1000.0);  // x offset
+  put<double>(buf, 163, 0.0);     // y offset
+  put<double>(buf, 171, -5.0);    // z offset
+  for (std::size_t i = 0; i < n; ++i)
+    for (std::size_t a = 0; a < 3; ++a)
+      put<std::int32_t>(buf, 227 + i * 20 + a * 4, xyz[3 * i + a]);
+  const std::string path = testing::TempDir() + name;
+  std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(buf.data()),
+                                              static_cast<std::streamsize>(buf.size()));
+  return path;
+}
+
+}  // namespace
+
+TEST(LasTest, header_and_views) {
+  las_file las(write_las("metric_las_views.las", { 1, 2, 3, -4, 5, 6, 7000, 8, 9 }));
+  EXPECT_EQ(las.size(), 3u);
+  EXPECT_EQ(las.record_length(), 20u);
+  EXPECT_EQ(las.point_format(), 0u);
+  EXPECT_DOUBLE_EQ(las.y().scale(), 0.01);
+  EXPECT_EQ(las.x().counts()[1], -4);
+
+  auto x = las.x().as<std::milli>();
+  EXPECT_EQ(x.size(), 3u);
+  EXPECT_EQ(x[2], 7_m);
+  auto y = las.y().as<std::centi>();
+  EXPECT_EQ(y[1], 5_cm);
+  EXPECT_THROW(las.y().as<std::milli>(), std::domain_error);
+}
+
+TEST(LasTest, calibrated_conversion) {
+  las_file las(write_las("metric_las_convert.las", { 1, 2, 3, -4, 5, 6, 7000, 8, 9 }));
+  std::vector<millimeters<std::int64_t>> x(las.size());
+  las.x().convert(x.data());
+  EXPECT_EQ(x[0], millimeters<std::int64_t>(1000001));
+  EXPECT_EQ(x[1], millimeters<std::int64_t>(999996));
+  EXPECT_EQ(x[2], millimeters<std::int64_t>(1007000));
+  std::vector<meters<double>> z(las.size());
+  las.z().convert(z.data());
+  EXPECT_DOUBLE_EQ(z[0].count(), -4.997);
+}
+
+TEST(LasTest, rejects_invalid_files) {
+  EXPECT_THROW(las_file(testing::TempDir() + "metric_las_missing.las"), std::system_error);
+  EXPECT_THROW(las_file(write_las("metric_las_laz.las", { 1, 2, 3 }, 0x80)), std::runtime_error);
+  const std::string junk = testing::TempDir() + "metric_las_junk.las";
+  std::ofstream(junk) << "definitely not a point cloud";
+  EXPECT_THROW(las_file { junk }, std::runtime_error);
+  // LAS 1.4 header size, but the file ends after the 1.2 header
+  const std::string truncated = write_las("metric_las_truncated.las", {});
+  std::fstream f(truncated, std::ios::in | std::ios::out | std::ios::binary);
+  const char minor = 4;
+  const std::uint16_t header_size = 375;
+  f.seekp(25);
+  f.write(&minor, 1);
+  f.seekp(94);
+  f.write(reinterpret_cast<const char*>(&header_size), sizeof(header_size));
+  f.close();
+  EXPECT_THROW(las_file { truncated }, std::runtime_error);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "metric_lut.h"
+
+using namespace metric;
+
+namespace {
+
+/* Reference evaluation by binary search. */
+double reference(const std::vector<double>& x, const std::vector<double>& y, double t) {
+  if (t <= x.front()) return y.front();
+  if (t >= x.back()) return y.back();
+  const std::size_t k = static_cast<std::size_t>(std::upper_bound(x.begin(), x.end(), t) - x.begin()) - 1;
+  return y[k] + (y[k + 1] - y[k]) / (x[k + 1] - x[k]) * (t - x[k]);
+}
+
+}  // namespace
+
+TEST(LutTest, uniform) {
+  const double grade[] = { 0.0, 0.02, 0.05, 0.01 };
+  const distance_lut<meters<double>> lut(meters<int>(0), centimeters<int>(25000), grade, 4);
+  EXPECT_TRUE(lut.uniform());
+  EXPECT_EQ(lut.size(), 4u);
+  EXPECT_DOUBLE_EQ(lut.breakpoint(3).count(), 750.0);
+  EXPECT_DOUBLE_EQ(lut(meters<double>(100.0)), 0.008);
+  EXPECT_DOUBLE_EQ(lut(meters<double>(250.0)), 0.02);
+  EXPECT_DOUBLE_EQ(lut(meters<double>(625.0)), 0.03);
+  EXPECT_DOUBLE_EQ(lut(meters<double>(-1.0)), 0.0);
+  EXPECT_DOUBLE_EQ(lut(meters<double>(750.0)), 0.01);
+  EXPECT_DOUBLE_EQ(lut(meters<double>(1e9)), 0.01);
+}
+
+TEST(LutTest, breakpoints) {
+  const millimeters<std::int32_t> x[] = { millimeters<std::int32_t>(-500), millimeters<std::int32_t>(0),
+                                          millimeters<std::int32_t>(10), millimeters<std::int32_t>(4000) };
+  const float y[] = { 1.0f, 2.0f, 4.0f, 0.0f };
+  const distance_lut<millimeters<std::int32_t>, float> lut(x, y, 4);
+  EXPECT_FALSE(lut.uniform());
+  EXPECT_DOUBLE_EQ(lut.breakpoint(1).count(), 0.0);
+  EXPECT_FLOAT_EQ(lut(millimeters<std::int32_t>(-1000)), 1.0f);
+  EXPECT_FLOAT_EQ(lut(millimeters<std::int32_t>(-250)), 1.5f);
+  EXPECT_FLOAT_EQ(lut(millimeters<std::int32_t>(0)), 2.0f);
+  EXPECT_FLOAT_EQ(lut(millimeters<std::int32_t>(5)), 3.0f);
+  EXPECT_FLOAT_EQ(lut(millimeters<std::int32_t>(2005)), 2.0f);
+  EXPECT_FLOAT_EQ(lut(millimeters<std::int32_t>(4000)), 0.0f);
+  EXPECT_FLOAT_EQ(lut(millimeters<std::int32_t>(9000)), 0.0f);
+}
+
+TEST(LutTest, non_finite) {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const meters<double> x[] = { meters<double>(0.0), meters<double>(1.0), meters<double>(3.0) };
+  const double y[] = { 1.0, 2.0, 4.0 };
+  const distance_lut<meters<double>> lut(x, y, 3);
+  const distance_lut<meters<double>> uniform(meters<double>(0.0), meters<double>(1.0), y, 3);
+  for (const distance_lut<meters<double>>* l : { &lut, &uniform }) {
+    EXPECT_DOUBLE_EQ((*l)(meters<double>(inf)), 4.0);
+    EXPECT_DOUBLE_EQ((*l)(meters<double>(-inf)), 1.0);
+    EXPECT_TRUE(std::isnan((*l)(meters<double>(nan))));
+    const meters<double> q[] = { meters<double>(inf), meters<double>(nan), meters<double>(-inf), meters<double>(0.5) };
+    double out[4];
+    (*l)(q, 4, out);
+    EXPECT_DOUBLE_EQ(out[0], 4.0);
+    EXPECT_TRUE(std::isnan(out[1]));
+    EXPECT_DOUBLE_EQ(out[2], 1.0);
+    EXPECT_DOUBLE_EQ(out[3], 1.5);
+  }
+}
+
+TEST(LutTest, invalid) {
+  const double y[] = { 1.0, 2.0 };
+  EXPECT_THROW(distance_lut<meters<double>>(meters<double>(0.0), meters<double>(0.0), y, 2), std::invalid_argument);
+  EXPECT_THROW(distance_lut<meters<double>>(meters<double>(0.0), meters<double>(1.0), y, 1), std::invalid_argument);
+  const meters<double> x[] = { meters<double>(1.0), meters<double>(1.0) };
+  EXPECT_THROW(distance_lut<meters<double>>(x, y, 2), std::invalid_argument);
+}
+
+TEST(LutTest, clustered_breakpoints) {
+  // most breakpoints fall into a single bucket of the guide table
+  std::vector<double> xs, ys;
+  for (int i = 0; i < 100; ++i) xs.push_back(i * 1e-3);
+  xs.push_back(1000.0);
+  for (std::size_t i = 0; i < xs.size(); ++i) ys.push_back(std::sin(static_cast<double>(i)));
+  std::vector<meters<double>> x(xs.begin(), xs.end());
+  const distance_lut<meters<double>> lut(x.data(), ys.data(), x.size());
+  for (double t = -0.01; t < 0.2; t += 1.7e-4) ASSERT_NEAR(lut(meters<double>(t)), reference(xs, ys, t), 1e-9) << t;
+  EXPECT_NEAR(lut(meters<double>(500.0)), reference(xs, ys, 500.0), 1e-9);
+}
+
+TEST(LutTest, batch) {
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<double> step(0.1, 10.0), value(-1.0, 1.0), query(-100.0, 6000.0);
+  std::vector<double> xs(1000), ys(1000);
+  double t = 0.0;
+  for (std::size_t i = 0; i < xs.size(); ++i) {
+    xs[i] = t += step(gen);
+    ys[i] = value(gen);
+  }
+  std::vector<meters<double>> x(xs.begin(), xs.end());
+  const distance_lut<meters<double>> lut(x.data(), ys.data(), x.size());
+  std::vector<meters<double>> q(5000);
+  for (auto& d : q) d = meters<double>(query(gen));
+  std::vector<double> out(q.size());
+  lut(q.data(), q.size(), out.data());
+  for (std::size_t i = 0; i < q.size(); ++i) ASSERT_NEAR(out[i], reference(xs, ys, q[i].count()), 1e-9) << i;
+  std::sort(q.begin(), q.end());
+  lut(q.data(), q.size(), out.data());
+  for (std::size_t i = 0; i < q.size(); ++i) ASSERT_NEAR(out[i], reference(xs, ys, q[i].count()), 1e-9) << i;
+}
+
+TEST(LutTest, batch_large_table) {
+  // breakpoints exceed the cache, queries in blocks
+  const std::size_t n = std::size_t(1) << 17;
+  std::vector<millimeters<std::int64_t>> x(n);
+  std::vector<double> xs(n), ys(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    x[i] = millimeters<std::int64_t>(static_cast<std::int64_t>(i * 3 + (i & 1)));
+    xs[i] = static_cast<double>(x[i].count());
+    ys[i] = static_cast<double>(i % 17);
+  }
+  const distance_lut<millimeters<std::int64_t>> lut(x.data(), ys.data(), n);
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<std::int64_t> query(-10, static_cast<std::int64_t>(3 * n + 10));
+  std::vector<millimeters<std::int64_t>> q(2 * n);
+  for (auto& d : q) d = millimeters<std::int64_t>(query(gen));
+  std::vector<double> out(q.size());
+  lut(q.data(), q.size(), out.data());
+  for (std::size_t i = 0; i < q.size(); ++i) ASSERT_NEAR(out[i], reference(xs, ys, static_cast<double>(q[i].count())), 1e-9) << i;
+}
+
+TEST(LutTest, strided) {
+  struct record { float intensity; meters<double> range; };
+  const meters<double> x[] = { meters<double>(0.0), meters<double>(1.0), meters<double>(4.0) };
+  const double y[] = { 0.0, 1.0, 7.0 };
+  const distance_lut<meters<double>> lut(x, y, 3);
+  std::vector<record> rs(1000);
+  for (std::size_t i = 0; i < rs.size(); ++i) rs[i].range = meters<double>(static_cast<double>(i) * 0.005);
+  std::vector<double> out(rs.size());
+  lut(make_strided_view(rs.data(), rs.size(), &record::range), out.data());
+  for (std::size_t i = 0; i < rs.size(); ++i) ASSERT_DOUBLE_EQ(out[i], lut(rs[i].range)) << i;
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "metric_memory.h"
+
+using namespace metric;
+
+namespace {
+
+struct scans { static const char* name() { return "scans"; } };
+struct points { static const char* name() { return "points"; } };
+
+}  // namespace
+
+TEST(MemoryTest, accounts_bytes_and_peak_per_tag) {
+  const std::size_t before = memory_usage_of<scans>().bytes;
+  {
+    tracked_distance_array<millimeters<std::int32_t>, scans> a;
+    a.reserve(1000);
+    EXPECT_EQ(memory_usage_of<scans>().bytes, before + 4000);
+    a.reserve(3000);
+    EXPECT_EQ(memory_usage_of<scans>().bytes, before + 12000);
+    EXPECT_GE(memory_usage_of<scans>().peak, before + 16000);  // old and new buffer during growth
+    a.shrink_to_fit();
+    EXPECT_EQ(memory_usage_of<scans>().bytes, before);
+    reset_memory_peak<scans>();
+    EXPECT_EQ(memory_usage_of<scans>().peak, before);
+    a.resize(10);
+    auto b = a;
+    EXPECT_EQ(b.size(), 10u);
+    EXPECT_EQ(memory_usage_of<scans>().bytes, before + 80);
+  }
+  const memory_usage u = memory_usage_of<scans>();
+  EXPECT_EQ(u.bytes, before);
+  EXPECT_EQ(u.tag, "scans");
+  EXPECT_EQ(u.allocations, u.deallocations);
+}
+
+TEST(MemoryTest, point_arrays_and_report) {
+  {
+    tracked_point_array<meters<double>, 3, points> p;
+    p.resize(100);
+    EXPECT_EQ(memory_usage_of<points>().bytes, 3 * 100 * sizeof(double));
+    std::size_t seen = 0;
+    for (const memory_usage& u : memory_usage_report())
+      if (u.tag == "points") seen = u.bytes;
+    EXPECT_EQ(seen, 3 * 100 * sizeof(double));
+  }
+  EXPECT_EQ(memory_usage_of<points>().bytes, 0u);
+  EXPECT_EQ(memory_usage_of<points>().peak, 3 * 100 * sizeof(double));
+}
+
+TEST(MemoryTest, wraps_standard_containers) {
+  {
+    std::vector<meters<float>, tracking_allocator<meters<float>>> v(16);
+    EXPECT_GE(memory_usage_of<default_memory_tag>().bytes, 16 * sizeof(float));
+  }
+  EXPECT_EQ(memory_usage_of<default_memory_tag>().bytes, 0u);
+  EXPECT_TRUE(tracking_allocator<int>() == tracking_allocator<double>());
+}
+
+TEST(MemoryTest, convert_in_place_allocates_nothing) {
+  const memory_usage before = memory_usage_of<scans>();
+  {
+    tracked_distance_array<micrometers<std::int64_t>, scans> a(1000);
+    auto b = convert_in_place<millimeters<std::int32_t>>(std::move(a));
+    EXPECT_EQ(b.size(), 1000u);
+    EXPECT_EQ(memory_usage_of<scans>().bytes, before.bytes + 8000);
+    EXPECT_EQ(memory_usage_of<scans>().allocations, before.allocations + 1);
+  }
+  EXPECT_EQ(memory_usage_of<scans>().bytes, before.bytes);
+  EXPECT_EQ(memory_usage_of<scans>().deallocations, before.deallocations + 1);
+}
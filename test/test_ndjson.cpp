@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "metric_ndjson.h"
+
+using namespace metric;
+using namespace metric::literals;
+
+TEST(NdjsonTest, extracts_fields_in_target_unit) {
+  const std::string text =
+      "{\"id\": 1, \"range_m\": 12.345, \"offset_cm\": -4}\n"
+      "{\"offset_cm\":250,\"range_m\":1e-3,\"note\":\"range_m: 99\"}\r\n"
+      "\n"
+      "{\"nested\": {\"range_m\": 5}, \"range_m\": null}\n"
+      "{\"name\": \"a \\\"quoted\\\" range_m\", \"range_m\": 0.5, \"tags\": [1, {\"x\": 2}]}";
+  ndjson_extractor<millimeters<double>> ex;
+  EXPECT_EQ(ex.add_field<std::ratio<1>>("range_m"), 0u);
+  EXPECT_EQ(ex.add_field<std::centi>("offset_cm"), 1u);
+  std::vector<distance_array<millimeters<double>>> cols;
+  EXPECT_EQ(ex.extract(text, cols), 4u);
+  ASSERT_EQ(cols.size(), 2u);
+  ASSERT_EQ(cols[0].size(), 4u);
+  EXPECT_DOUBLE_EQ(cols[0][0].count(), 12345.0);
+  EXPECT_DOUBLE_EQ(cols[0][1].count(), 1.0);
+  EXPECT_TRUE(std::isnan(cols[0][2].count()));
+  EXPECT_DOUBLE_EQ(cols[0][3].count(), 500.0);
+  EXPECT_DOUBLE_EQ(cols[1][0].count(), -40.0);
+  EXPECT_DOUBLE_EQ(cols[1][1].count(), 2500.0);
+  EXPECT_TRUE(std::isnan(cols[1][3].count()));
+}
+
+TEST(NdjsonTest, integral_targets_are_exact) {
+  const std::string text =
+      "{\"d_km\": 9007199254740993}\n"
+      "{\"d_km\": 1.25}\n"
+      "{\"d_km\": -2}\n";
+  ndjson_extractor<meters<std::int64_t>> ex;
+  ex.add_field<std::kilo>("d_km");
+  std::vector<distance_array<meters<std::int64_t>>> cols;
+  ex.extract(text, cols);
+  ASSERT_EQ(cols[0].size(), 3u);
+  EXPECT_EQ(cols[0][0].count(), 9007199254740993LL * 1000);
+  EXPECT_EQ(cols[0][1].count(), 1250);
+  EXPECT_EQ(cols[0][2].count(), -2000);
+}
+
+TEST(NdjsonTest, integral_targets_round) {
+  const std::string text =
+      "{\"d_mm\": 1499, \"d_km\": 9300000000000000}\n"
+      "{\"d_mm\": 1500, \"d_km\": -9300000000000000}\n"
+      "{\"d_mm\": -1500, \"d_km\": 1}\n"
+      "{\"d_mm\": -1499.0, \"d_km\": 0}\n";
+  ndjson_extractor<meters<std::int64_t>> ex;
+  ex.add_field<std::milli>("d_mm");
+  ex.add_field<std::kilo>("d_km");
+  std::vector<distance_array<meters<std::int64_t>>> cols;
+  ex.extract(text, cols);
+  ASSERT_EQ(cols[0].size(), 4u);
+  EXPECT_EQ(cols[0][0].count(), 1);
+  EXPECT_EQ(cols[0][1].count(), 2);
+  EXPECT_EQ(cols[0][2].count(), -2);
+  EXPECT_EQ(cols[0][3].count(), -1);
+  // beyond the range of the representation
+  EXPECT_EQ(cols[1][0].count(), std::numeric_limits<std::int64_t>::max());
+  EXPECT_EQ(cols[1][1].count(), std::numeric_limits<std::int64_t>::lowest());
+  EXPECT_EQ(cols[1][2].count(), 1000);
+}
+
+TEST(NdjsonTest, long_records_use_vector_scan) {
+  std::string text;
+  for (int i = 0; i < 100; ++i) {
+    text += "{\"padding\": \"" + std::string(static_cast<std::size_t>(i), 'x') +
+            "\", \"r\": " + std::to_string(i) + "}\n";
+  }
+  ndjson_extractor<meters<long double>> ex;
+  ex.add_field<std::ratio<1>>("r");
+  std::vector<distance_array<meters<long double>>> cols;
+  EXPECT_EQ(ex.extract(text, cols), 100u);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(cols[0][static_cast<std::size_t>(i)], meters<long double>(i));
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "metric_parallel.h"
+
+using namespace metric;
+
+namespace {
+
+std::vector<millimeters<std::int64_t>> shuffled(std::size_t n) {
+  std::vector<millimeters<std::int64_t>> v(n);
+  std::uint64_t s = 1;
+  for (std::size_t i = 0; i < n; ++i) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    v[i] = millimeters<std::int64_t>(static_cast<std::int64_t>(s >> 40) - (std::int64_t(1) << 23));
+  }
+  return v;
+}
+
+}  // namespace
+
+TEST(ParallelTest, cast_matches_sequential) {
+  const auto in = shuffled(300000);
+  std::vector<meters<double>> out(in.size());
+  parallel_cast_n<meters<double>>(in.data(), in.size(), out.data(), 4);
+  for (std::size_t i = 0; i < in.size(); i += 997)
+    EXPECT_EQ(out[i], distance_cast<meters<double>>(in[i]));
+  EXPECT_EQ(out.back(), distance_cast<meters<double>>(in.back()));
+}
+
+TEST(ParallelTest, sort) {
+  for (std::size_t n : { std::size_t(0), std::size_t(1000), std::size_t(500001) }) {
+    auto v = shuffled(n);
+    auto w = v;
+    parallel_sort(v.data(), v.data() + v.size(), 3);
+    std::sort(w.begin(), w.end());
+    EXPECT_EQ(v, w);
+  }
+}
+
+TEST(ParallelTest, sum_is_independent_of_threads) {
+  std::vector<meters<double>> v(250000);
+  for (std::size_t i = 0; i < v.size(); ++i) v[i] = meters<double>(0.1 * static_cast<double>(i % 7));
+  const meters<double> s1 = parallel_sum(v.data(), v.size(), 1);
+  EXPECT_EQ(parallel_sum(v.data(), v.size(), 5), s1);
+  const auto ints = shuffled(12345);
+  std::int64_t expected = 0;
+  for (const auto& d : ints) expected += d.count();
+  EXPECT_EQ(parallel_sum(ints.data(), ints.size()).count(), expected);
+}
+
+TEST(ParallelTest, strided) {
+  struct record { std::int32_t id; millimeters<std::int64_t> range; };
+  const auto in = shuffled(100000);
+  std::vector<record> rs(in.size());
+  std::int64_t expected = 0;
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    rs[i].range = in[i];
+    expected += in[i].count();
+  }
+  const auto v = make_strided_view(rs.data(), rs.size(), &record::range);
+  std::vector<meters<double>> out(in.size());
+  parallel_cast_n<meters<double>>(v, out.data(), 3);
+  for (std::size_t i = 0; i < in.size(); i += 997) EXPECT_EQ(out[i], distance_cast<meters<double>>(in[i]));
+  EXPECT_EQ(parallel_sum(v, 3).count(), expected);
+}
+
+TEST(ParallelTest, convert_in_place) {
+  // chunks compacted in parallel, then moved to their final positions
+  const auto in = shuffled(3 * parallel_default_grain + 17);
+  distance_array<millimeters<std::int64_t>> a;
+  for (const auto& d : in) a.push_back(d);
+  const auto m = parallel_convert_in_place<meters<float>>(std::move(a), 3);
+  ASSERT_EQ(m.size(), in.size());
+  for (std::size_t i = 0; i < in.size(); ++i) ASSERT_EQ(m[i], distance_cast<meters<float>>(in[i])) << i;
+  const auto mm = parallel_convert_in_place<millimeters<std::int64_t>>(distance_array<micrometers<std::int64_t>>(5), 2);
+  EXPECT_EQ(mm[4].count(), 0);
+}
+
+TEST(ParallelTest, rethrows_first_exception) {
+  std::atomic<int> calls { 0 };
+  EXPECT_THROW(parallel_for("test", 100, 1, [&](std::size_t b, std::size_t) {
+    ++calls;
+    if (b == 10) throw std::runtime_error("chunk 10");
+  }, 4), std::runtime_error);
+  EXPECT_LE(calls.load(), 100);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "metric_polyline.h"
+
+using namespace metric;
+using namespace metric::literals;
+
+template <typename Repr>
+using degrees = distance<Repr>;  // angles travel through the same fixed-point codec
+
+TEST(PolylineTest, google_reference) {
+  // Example from the Google polyline algorithm documentation.
+  point_array<degrees<double>> pts;
+  pts.push_back({ degrees<double>(38.5), degrees<double>(-120.2) });
+  pts.push_back({ degrees<double>(40.7), degrees<double>(-120.95) });
+  pts.push_back({ degrees<double>(43.252), degrees<double>(-126.453) });
+  EXPECT_EQ(polyline_encode(pts), "_p~iF~ps|U_ulLnnqC_mqNvxq`@");
+
+  point_array<degrees<double>> back;
+  EXPECT_EQ(polyline_decode("_p~iF~ps|U_ulLnnqC_mqNvxq`@", back), 3u);
+  EXPECT_EQ(back.x(), pts.x());
+  EXPECT_EQ(back.y(), pts.y());
+}
+
+TEST(PolylineTest, integral_fixed_point) {
+  using cm = centimeters<std::int32_t>;
+  point_array<cm> pts;
+  for (std::int32_t i = 0; i < 1000; ++i)
+    pts.push_back({ cm(i * 37 - 5000), cm(-i * i) });
+  const std::string s = polyline_encode(pts, 0);
+  point_array<cm> back;
+  EXPECT_EQ(polyline_decode(s, back, 0), pts.size());
+  EXPECT_EQ(back.x(), pts.x());
+  EXPECT_EQ(back.y(), pts.y());
+}
+
+TEST(PolylineTest, precision_six) {
+  point_array<meters<double>, 3> pts;
+  pts.push_back({ meters<double>(1.000001), meters<double>(-2.5), meters<double>(9) });
+  const std::string s = polyline_encode(pts, 6);
+  point_array<meters<double>, 3> back;
+  polyline_decode(s, back, 6);
+  EXPECT_NEAR(back.x()[0].count(), 1.000001, 1e-9);
+  EXPECT_EQ(back.z()[0], meters<double>(0));
+  EXPECT_THROW(polyline_encode(pts, 16), std::invalid_argument);
+}
+
+TEST(PolylineTest, batch_decode) {
+  std::vector<std::string> lines { "_p~iF~ps|U", "", "_p~iF~ps|U_ulLnnqC" };
+  point_array<degrees<double>> pts;
+  std::vector<std::size_t> offsets;
+  polyline_decode(lines.begin(), lines.end(), pts, &offsets);
+  EXPECT_EQ(pts.size(), 3u);
+  EXPECT_EQ(offsets, (std::vector<std::size_t> { 0, 1, 1, 3 }));
+  EXPECT_EQ(pts.x()[2], degrees<double>(40.7));
+}
+
+TEST(PolylineTest, rejects_malformed) {
+  point_array<degrees<double>> pts;
+  pts.push_back({ degrees<double>(1), degrees<double>(2) });
+  EXPECT_THROW(polyline_decode("_p~iF~ps|", pts), std::runtime_error);
+  EXPECT_THROW(polyline_decode(std::string("_p~iF\x01ps|U_ulLnnqC_mqNvxq`@_p~iF~ps|U"), pts),
+               std::runtime_error);
+  EXPECT_EQ(pts.size(), 1u);
+  // 13 characters, then a value that does not terminate within 13 characters
+  const std::string overlong = std::string(12, '_') + "?" + std::string(13, '_');
+  const std::vector<char> buf(overlong.begin(), overlong.end());
+  EXPECT_THROW(polyline_decode(buf.data(), buf.size(), pts), std::runtime_error);
+  EXPECT_EQ(pts.size(), 1u);
+}
+
+TEST(PolylineTest, integral_decode_rounds) {
+  point_array<degrees<double>> pts;
+  pts.push_back({ degrees<double>(1.5), degrees<double>(-1.5) });
+  pts.push_back({ degrees<double>(1.4), degrees<double>(-1.6) });
+  const std::string s = polyline_encode(pts, 1);
+  point_array<degrees<std::int32_t>> back;
+  polyline_decode(s, back, 1);
+  EXPECT_EQ(back.x()[0].count(), 2);
+  EXPECT_EQ(back.y()[0].count(), -2);
+  EXPECT_EQ(back.x()[1].count(), 1);
+  EXPECT_EQ(back.y()[1].count(), -2);
+}
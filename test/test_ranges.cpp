@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <list>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+#include "metric_array.h"
+#include "metric_ranges.h"
+
+using namespace metric;
+
+namespace {
+
+std::vector<millimeters<std::int32_t>> ranges_mm(std::size_t n) {
+  std::vector<millimeters<std::int32_t>> v(n);
+  for (std::size_t i = 0; i < n; ++i) v[i] = millimeters<std::int32_t>(static_cast<std::int32_t>(i * 37 % 1000) - 200);
+  return v;
+}
+
+}  // namespace
+
+TEST(RangesTest, views) {
+  const auto v = ranges_mm(5);
+  auto m = v | views::as<meters<double>>;
+  static_assert(std::ranges::random_access_range<decltype(m)>, "random access");
+  EXPECT_DOUBLE_EQ(m[1].count(), -0.163);
+  auto c = v | views::counts;
+  static_assert(std::is_same<std::ranges::range_value_t<decltype(c)>, std::int32_t>::value, "counts");
+  EXPECT_EQ(c[2], -126);
+  const std::vector<std::int32_t> raw = { 1, 2, 3 };
+  auto d = raw | views::from_counts<centimeters<std::int32_t>> | views::as<millimeters<std::int32_t>>;
+  EXPECT_EQ(d[2].count(), 30);
+  EXPECT_EQ(std::ranges::distance(v | views::as<meters<double>> | std::views::take(3)), 3);
+}
+
+TEST(RangesTest, fusion) {
+  using vector_view = std::ranges::ref_view<const std::vector<millimeters<std::int32_t>>>;
+  static_assert(__fused_range<std::vector<std::int32_t>>::value, "contiguous");
+  static_assert(__fused_range<std::ranges::transform_view<vector_view, __as_fn<meters<double>>>>::value, "as");
+  static_assert(!__fused_range<std::list<std::int32_t>>::value, "not contiguous");
+  const auto v = ranges_mm(1000);
+  static_assert(!__fused_range<std::remove_cvref_t<decltype(v | std::views::reverse | views::counts)>>::value,
+                "not contiguous below the adaptor");
+}
+
+TEST(RangesTest, sum) {
+  const auto v = ranges_mm(1003);
+  std::int64_t expected = 0;
+  for (const auto& d : v) expected += d.count();
+  EXPECT_EQ(ranges::sum(v).count(), expected);
+  EXPECT_EQ(ranges::sum(v | views::counts), expected);
+  EXPECT_DOUBLE_EQ(ranges::sum(v | views::as<meters<double>>).count(), expected / 1000.0);
+  EXPECT_EQ(ranges::sum(v | views::as<micrometers<std::int64_t>>).count(), expected * 1000);
+  // not fused
+  EXPECT_EQ(ranges::sum(v | std::views::reverse | views::counts), expected);
+  const std::list<millimeters<std::int32_t>> l(v.begin(), v.end());
+  EXPECT_DOUBLE_EQ(ranges::sum(l | views::as<meters<double>>).count(), expected / 1000.0);
+  EXPECT_EQ(ranges::sum(std::vector<meters<int>>()).count(), 0);
+}
+
+TEST(RangesTest, minmax) {
+  const auto v = ranges_mm(1000);
+  const auto mm = ranges::minmax(v | views::as<centimeters<std::int32_t>>);
+  EXPECT_EQ(mm.first.count(), -20);
+  EXPECT_EQ(mm.second.count(), 79);
+  const auto c = ranges::minmax(v | std::views::reverse | views::counts);
+  EXPECT_EQ(c.first, -200);
+  EXPECT_EQ(c.second, 799);
+  EXPECT_THROW(ranges::minmax(std::vector<meters<int>>()), std::out_of_range);
+  EXPECT_THROW(ranges::minmax(std::list<meters<int>>()), std::out_of_range);
+}
+
+TEST(RangesTest, distance_cast_n) {
+  const auto v = ranges_mm(100);
+  std::vector<meters<double>> out(v.size());
+  distance_cast_n<meters<double>>(v | views::as<centimeters<std::int32_t>>, out.data());
+  for (std::size_t i = 0; i < v.size(); ++i)
+    EXPECT_DOUBLE_EQ(out[i].count(), distance_cast<centimeters<std::int32_t>>(v[i]).count() / 100.0) << i;
+  distance_cast_n<meters<double>>(v, out.data());
+  for (std::size_t i = 0; i < v.size(); ++i) EXPECT_DOUBLE_EQ(out[i].count(), v[i].count() / 1000.0) << i;
+  distance_array<millimeters<std::int32_t>> a;
+  for (const auto& d : v) a.push_back(d);
+  distance_cast_n<meters<double>>(a | std::views::reverse, out.data());
+  EXPECT_DOUBLE_EQ(out[0].count(), v.back().count() / 1000.0);
+}
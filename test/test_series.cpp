@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "metric_series.h"
+
+using namespace metric;
+using namespace std::chrono;
+
+namespace {
+
+using series = distance_series<millimeters<std::int64_t>, steady_clock, milliseconds>;
+using stamp = series::time_point;
+
+stamp at(std::int64_t ms) { return stamp(milliseconds(ms)); }
+
+}  // namespace
+
+TEST(SeriesTest, push_back_requires_ascending_times) {
+  series s;
+  s.push_back(at(10), millimeters<std::int64_t>(1));
+  s.push_back(at(10), millimeters<std::int64_t>(2));
+  EXPECT_THROW(s.push_back(at(9), millimeters<std::int64_t>(3)), std::invalid_argument);
+  EXPECT_EQ(s.size(), 2u);
+  EXPECT_THROW(series().interpolate(at(0)), std::out_of_range);
+}
+
+TEST(SeriesTest, as_of_matches_upper_bound) {
+  series s;
+  for (std::int64_t i = 0; i < 1000; ++i) s.push_back(at(10 + 3 * i - i % 2), millimeters<std::int64_t>(i));
+  std::vector<stamp> q;
+  for (std::int64_t t = 0; t < 3100; t += 7) q.push_back(at(t));
+  std::reverse(q.begin(), q.end());
+  std::vector<std::size_t> idx(q.size());
+  s.as_of_n(q.data(), q.size(), idx.data());
+  for (std::size_t k = 0; k < q.size(); ++k) {
+    const stamp* ub = std::upper_bound(s.times(), s.times() + s.size(), q[k]);
+    const std::size_t expected = ub == s.times() ? series::npos : static_cast<std::size_t>(ub - s.times()) - 1;
+    ASSERT_EQ(idx[k], expected) << k;
+    ASSERT_EQ(s.as_of(q[k]), expected) << k;
+  }
+}
+
+TEST(SeriesTest, interpolate) {
+  series s;
+  s.push_back(at(0), millimeters<std::int64_t>(0));
+  s.push_back(at(1000), millimeters<std::int64_t>(1000));
+  s.push_back(at(3000), millimeters<std::int64_t>(0));
+  EXPECT_EQ(s.interpolate(at(250)), millimeters<std::int64_t>(250));
+  EXPECT_EQ(s.interpolate(at(2000)), millimeters<std::int64_t>(500));
+  EXPECT_EQ(s.interpolate(at(2998)), millimeters<std::int64_t>(1));
+  EXPECT_EQ(s.interpolate(at(1001)), millimeters<std::int64_t>(999));  // 999.5 is rounded to nearest
+  EXPECT_EQ(s.interpolate(at(-5)), millimeters<std::int64_t>(0));
+  EXPECT_EQ(s.interpolate(at(5000)), millimeters<std::int64_t>(0));
+  std::vector<stamp> q;
+  for (std::int64_t t = -100; t <= 3100; t += 50) q.push_back(at(t));
+  std::vector<millimeters<std::int64_t>> out(q.size());
+  s.interpolate_n(q.data(), q.size(), out.data());
+  for (std::size_t k = 0; k < q.size(); ++k) ASSERT_EQ(out[k], s.interpolate(q[k])) << k;
+
+  distance_series<meters<double>> f;
+  f.push_back(steady_clock::time_point(seconds(1)), meters<double>(2.0));
+  f.push_back(steady_clock::time_point(seconds(3)), meters<double>(3.0));
+  EXPECT_DOUBLE_EQ(f.interpolate(steady_clock::time_point(milliseconds(1500))).count(), 2.25);
+}
+
+TEST(SeriesTest, interpolate_decreasing_unsigned) {
+  using useries = distance_series<millimeters<unsigned long long>, steady_clock, milliseconds>;
+  useries s;
+  s.push_back(at(0), millimeters<unsigned long long>(1000));
+  s.push_back(at(1000), millimeters<unsigned long long>(0));
+  s.push_back(at(3000), millimeters<unsigned long long>(20));
+  EXPECT_EQ(s.interpolate(at(250)).count(), 750u);
+  EXPECT_EQ(s.interpolate(at(999)).count(), 1u);
+  EXPECT_EQ(s.interpolate(at(1000)).count(), 0u);
+  EXPECT_EQ(s.interpolate(at(1100)).count(), 1u);
+  std::vector<stamp> q;
+  for (std::int64_t t = 0; t <= 1000; ++t) q.push_back(at(t));
+  std::vector<millimeters<unsigned long long>> out(q.size());
+  s.interpolate_n(q.data(), q.size(), out.data());
+  for (std::size_t k = 0; k < q.size(); ++k) ASSERT_EQ(out[k].count(), 1000u - k) << k;
+}
+
+TEST(SeriesTest, merge_resample) {
+  series a, b;
+  a.push_back(at(0), millimeters<std::int64_t>(0));
+  a.push_back(at(100), millimeters<std::int64_t>(100));
+  a.push_back(at(200), millimeters<std::int64_t>(300));
+  b.push_back(at(50), millimeters<std::int64_t>(10));
+  b.push_back(at(100), millimeters<std::int64_t>(20));
+  b.push_back(at(250), millimeters<std::int64_t>(50));
+  const auto r = merge_resample(a, b);
+  ASSERT_EQ(r.first.size(), 3u);
+  ASSERT_EQ(r.second.size(), 3u);
+  const stamp t[] = { at(50), at(100), at(200) };
+  const std::int64_t va[] = { 50, 100, 300 };
+  const std::int64_t vb[] = { 10, 20, 40 };
+  for (std::size_t k = 0; k < 3; ++k) {
+    EXPECT_EQ(r.first.time(k), t[k]);
+    EXPECT_EQ(r.second.time(k), t[k]);
+    EXPECT_EQ(r.first.value(k).count(), va[k]) << k;
+    EXPECT_EQ(r.second.value(k).count(), vb[k]) << k;
+  }
+  series c;
+  c.push_back(at(500), millimeters<std::int64_t>(0));
+  EXPECT_TRUE(merge_resample(a, c).first.empty());
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "metric_snapshot.h"
+
+using namespace metric;
+using namespace metric::literals;
+
+TEST(SnapshotTest, distance_array_round_trip) {
+  const std::string path = testing::TempDir() + "metric_snapshot_array.bin";
+  distance_array<millimeters<std::int64_t>> a;
+  for (std::int64_t i = 0; i < 1000; ++i) a.push_back(millimeters<std::int64_t>(i * i - 500));
+  write_snapshot(path, a);
+
+  mapped_snapshot<millimeters<std::int64_t>> m(path);
+  EXPECT_EQ(m.size(), a.size());
+  EXPECT_EQ(m.columns(), 1u);
+  EXPECT_TRUE(m.column().is_contiguous());
+  EXPECT_EQ(m.data()[999], a[999]);
+
+  distance_array<millimeters<std::int64_t>> b;
+  read_snapshot(path, b);
+  EXPECT_EQ(a, b);
+}
+
+TEST(SnapshotTest, point_array_async) {
+  const std::string path = testing::TempDir() + "metric_snapshot_points.bin";
+  point_array<meters<float>, 3> p;
+  for (int i = 0; i < 17; ++i)
+    p.push_back({ meters<float>(i), meters<float>(2.0f * i), meters<float>(-1.0f * i) });
+  write_snapshot_async(path, p).get();
+
+  mapped_snapshot<meters<float>> m(path);
+  EXPECT_EQ(m.columns(), 3u);
+  EXPECT_EQ(m.column(2)[16], meters<float>(-16.0f));
+  EXPECT_THROW(m.column(3), std::out_of_range);
+
+  point_array<meters<float>, 3> q;
+  read_snapshot(path, q);
+  EXPECT_EQ(q.y(), p.y());
+  point_array<meters<float>, 2> wrong_dims;
+  EXPECT_THROW(read_snapshot(path, wrong_dims), std::runtime_error);
+}
+
+TEST(SnapshotTest, rejects_mismatches) {
+  const std::string path = testing::TempDir() + "metric_snapshot_types.bin";
+  write_snapshot(path, distance_array<centimeters<std::int32_t>>(4));
+  EXPECT_THROW(mapped_snapshot<millimeters<std::int32_t>> { path }, std::runtime_error);
+  EXPECT_THROW(mapped_snapshot<centimeters<std::uint32_t>> { path }, std::runtime_error);
+  EXPECT_THROW(mapped_snapshot<centimeters<float>> { path }, std::runtime_error);
+  EXPECT_NO_THROW(mapped_snapshot<centimeters<std::int32_t>> { path });
+  EXPECT_THROW(mapped_snapshot<centimeters<std::int32_t>> { path + ".missing" }, std::system_error);
+}
+
+TEST(SnapshotTest, concurrent_writers) {
+  // every writer uses its own temporary file, the last rename wins
+  const std::string path = testing::TempDir() + "metric_snapshot_concurrent.bin";
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; ++t) {
+    writers.emplace_back([&path, t] {
+      for (int i = 0; i < 10; ++i)
+        write_snapshot(path, distance_array<meters<std::int32_t>>(1000 * (t + 1), meters<std::int32_t>(t)));
+    });
+  }
+  for (std::thread& w : writers) w.join();
+  distance_array<meters<std::int32_t>> a;
+  read_snapshot(path, a);
+  ASSERT_FALSE(a.empty());
+  EXPECT_EQ(a.size(), 1000u * static_cast<std::size_t>(a[0].count() + 1));
+  EXPECT_EQ(a.back(), a[0]);
+}
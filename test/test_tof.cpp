@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "metric_tof.h"
+
+using namespace metric;
+using namespace std::chrono;
+
+TEST(TofTest, speed_of_light) {
+  const nanoseconds t[] = { nanoseconds(0), nanoseconds(1), nanoseconds(667), nanoseconds(1000000), nanoseconds(-10) };
+  millimeters<std::int64_t> out[5];
+  tof_distance_n<millimeters<std::int64_t>>(t, 5, out);
+  EXPECT_EQ(out[0].count(), 0);
+  EXPECT_EQ(out[1].count(), 150);       // 149.896229 mm
+  EXPECT_EQ(out[2].count(), 99981);     // 99980.78 mm
+  EXPECT_EQ(out[3].count(), 149896229);
+  EXPECT_EQ(out[4].count(), -1499);     // -1498.96 mm
+  meters<double> f[5];
+  tof_distance_n<meters<double>>(t, 5, f);
+  EXPECT_DOUBLE_EQ(f[3].count(), 149896.229);
+}
+
+TEST(TofTest, integral_path_matches_floating_point) {
+  std::vector<nanoseconds> t;
+  for (std::int64_t i = 0; i < 100000; ++i) t.push_back(nanoseconds(i * 7919 % 2000000));
+  distance_array<distance<std::int32_t, std::ratio<1, 256>>> fixed;  // Q.8 fixed-point meters
+  tof_distance_n<distance<std::int32_t, std::ratio<1, 256>>>(t.data(), t.size(), fixed);
+  ASSERT_EQ(fixed.size(), t.size());
+  for (std::size_t i = 0; i < t.size(); ++i)
+    ASSERT_EQ(fixed.data()[i].count(), std::llround(t[i].count() * 299792458e-9 / 2 * 256)) << i;
+}
+
+TEST(TofTest, speed_of_sound) {
+  EXPECT_NEAR(speed_of_sound(0.0).count(), 331.3, 1e-12);
+  EXPECT_NEAR(speed_of_sound(20.0).count(), 343.2, 0.05);
+  const microseconds t[] = { microseconds(5831), microseconds(58309) };  // 1 m and 10 m at 20 degrees Celsius
+  millimeters<std::int32_t> fixed[2];
+  tof_distance_n<millimeters<std::int32_t>, speed_of_sound_20c>(t, 2, fixed);
+  EXPECT_EQ(fixed[0].count(), 1001);
+  EXPECT_EQ(fixed[1].count(), 10006);
+  millimeters<std::int32_t> warm[2];
+  tof_distance_n<millimeters<std::int32_t>>(t, 2, speed_of_sound(35.0), warm);
+  EXPECT_EQ(warm[0].count(), static_cast<std::int32_t>(std::lround(5831e-6 * speed_of_sound(35.0).count() / 2 * 1000)));
+  EXPECT_GT(warm[1], fixed[1]);
+  distance_array<meters<double>> m;
+  tof_distance_n<meters<double>>(t, 2, kilometers_per_hour<double>(3600.0), m);
+  EXPECT_NEAR(m.data()[1].count(), 58.309 / 2, 1e-12);
+  EXPECT_THROW(tof_distance_n<millimeters<std::int32_t>>(t, 2, meters_per_second<double>(-1.0), warm),
+               std::domain_error);
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "metric_parallel.h"
+#include "metric_trace.h"
+
+using namespace metric;
+
+TEST(TraceTest, disabled_records_nothing) {
+  trace_enable(false);
+  trace_clear();
+  { trace_scope s("idle", 1); }
+  EXPECT_TRUE(trace_events().empty());
+}
+
+TEST(TraceTest, records_parallel_chunks_per_thread) {
+  trace_clear();
+  trace_enable();
+  std::vector<millimeters<std::int32_t>> in(4 * parallel_default_grain + 17, millimeters<std::int32_t>(1));
+  std::vector<meters<float>> out(in.size());
+  parallel_cast_n<meters<float>>(in.data(), in.size(), out.data(), 2);
+  trace_enable(false);
+
+  std::uint64_t elements = 0;
+  std::size_t chunks = 0, workers = 0;
+  std::set<std::uint32_t> threads;
+  for (const trace_event& e : trace_events()) {
+    if (std::string(e.name) == "metric::worker") {
+      ++workers;
+      threads.insert(e.thread);
+    } else {
+      EXPECT_EQ(std::string(e.name), "metric::parallel_cast_n");
+      elements += e.elements;
+      ++chunks;
+    }
+  }
+  EXPECT_EQ(workers, 2u);
+  EXPECT_EQ(threads.size(), 2u);
+  EXPECT_EQ(chunks, 5u);
+  EXPECT_EQ(elements, in.size());
+
+  std::ostringstream os;
+  write_chrome_trace(os);
+  EXPECT_EQ(os.str().find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0u);
+  EXPECT_NE(os.str().find("\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(os.str().find("\"args\":{\"elements\":17}"), std::string::npos);
+  trace_clear();
+  EXPECT_TRUE(trace_events().empty());
+}
+
+TEST(TraceTest, reuses_buffers_of_exited_threads) {
+  trace_clear();
+  trace_enable();
+  std::vector<millimeters<std::int32_t>> in(4 * parallel_default_grain, millimeters<std::int32_t>(1));
+  std::vector<meters<float>> out(in.size());
+  for (int i = 0; i < 10; ++i) parallel_cast_n<meters<float>>(in.data(), in.size(), out.data(), 3);
+  trace_enable(false);
+  std::set<std::uint32_t> threads;
+  std::size_t workers = 0;
+  for (const trace_event& e : trace_events()) {
+    threads.insert(e.thread);
+    workers += std::string(e.name) == "metric::worker";
+  }
+  EXPECT_EQ(workers, 30u);
+  // the calling thread and at most two workers, which reuse their buffers across calls
+  EXPECT_GE(threads.size(), 2u);
+  EXPECT_LE(threads.size(), 3u);
+  trace_clear();
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "metric_array.h"
+#include "metric_bulk.h"
+#include "metric_core.h"
+#include "metric_ndjson.h"
+
+/* Tagged integer without `std::numeric_limits`, layout-compatible with `int32_t`. */
+struct tagged {
+  std::int32_t v;
+  tagged() = default;
+  constexpr explicit tagged(std::intmax_t x) : v(static_cast<std::int32_t>(x)) {}
+  tagged& operator+=(const tagged& o) { v += o.v; return *this; }
+  tagged& operator-=(const tagged& o) { v -= o.v; return *this; }
+  friend constexpr tagged operator*(const tagged& a, const tagged& b) { return tagged(a.v * b.v); }
+  friend constexpr tagged operator/(const tagged& a, const tagged& b) { return tagged(a.v / b.v); }
+  friend constexpr bool operator==(const tagged& a, const tagged& b) { return a.v == b.v; }
+  friend constexpr bool operator<(const tagged& a, const tagged& b) { return a.v < b.v; }
+};
+
+/* Floating-point wrapper, which is not `std::is_floating_point`. */
+struct real {
+  double v;
+  real() = default;
+  constexpr explicit real(double x) : v(x) {}
+  friend constexpr real operator-(const real& a, const real& b) { return real(a.v - b.v); }
+  friend constexpr real operator*(const real& a, const real& b) { return real(a.v * b.v); }
+  friend constexpr real operator/(const real& a, const real& b) { return real(a.v / b.v); }
+  friend constexpr bool operator==(const real& a, const real& b) { return a.v == b.v; }
+  friend constexpr bool operator>(const real& a, const real& b) { return a.v > b.v; }
+  friend constexpr bool operator<=(const real& a, const real& b) { return a.v <= b.v; }
+};
+
+namespace metric {
+template <> struct treat_as_floating_point<real> : std::true_type {};
+template <> struct simd_lane<real> { using type = double; };
+template <> struct simd_lane<tagged> { using type = std::int32_t; };
+template <> struct distance_values<tagged> {
+  static constexpr tagged zero() noexcept { return tagged(0); }
+  static constexpr tagged min() noexcept { return tagged(INT32_MIN); }
+  static constexpr tagged max() noexcept { return tagged(INT32_MAX); }
+};
+}  // namespace metric
+
+using namespace metric;
+
+TEST(TraitsTest, defaults) {
+  static_assert(treat_as_floating_point<float>::value, "float is floating-point");
+  static_assert(!treat_as_floating_point<int>::value, "int is not floating-point");
+  static_assert(std::is_same<simd_lane<std::int64_t>::type, std::int64_t>::value, "arithmetic lanes");
+  static_assert(std::is_void<simd_lane<tagged>::type>::value == false, "specialized lane");
+  static_assert(meters<int>::zero().count() == 0, "zero");
+  static_assert(meters<std::int16_t>::max().count() == INT16_MAX, "max");
+  EXPECT_EQ(meters<double>::min().count(), std::numeric_limits<double>::lowest());
+}
+
+TEST(TraitsTest, distance_values) {
+  EXPECT_EQ(millimeters<tagged>::zero().count().v, 0);
+  EXPECT_EQ(millimeters<tagged>::min().count().v, INT32_MIN);
+  EXPECT_EQ(millimeters<tagged>::max().count().v, INT32_MAX);
+  distance_array<millimeters<tagged>> a;
+  a.resize(3);
+  ASSERT_EQ(a.size(), 3u);
+  for (const auto& d : a) EXPECT_EQ(d.count().v, 0);
+}
+
+TEST(TraitsTest, treat_as_floating_point) {
+  static_assert(std::is_constructible<meters<real>, real>::value, "construction");
+  const millimeters<real> a(real(1500.0));
+  EXPECT_DOUBLE_EQ(distance_cast<meters<real>>(a).count().v, 1.5);
+  EXPECT_DOUBLE_EQ(distance_cast<micrometers<real>>(a).count().v, 1500000.0);
+  // compares within tolerance, like built-in floating-point representations
+  EXPECT_TRUE(meters<real>(real(1.0)) == meters<real>(real(1.0 + 1e-9)));
+  EXPECT_FALSE(meters<real>(real(1.0)) == meters<real>(real(1.001)));
+  EXPECT_TRUE(millimeters<tagged>(tagged(3)) == millimeters<tagged>(tagged(3)));
+  EXPECT_FALSE(millimeters<tagged>(tagged(3)) == millimeters<tagged>(tagged(4)));
+}
+
+TEST(TraitsTest, treat_as_floating_point_ndjson) {
+  ndjson_extractor<meters<real>> ex;
+  ex.add_field<std::milli>("d_mm");
+  std::vector<distance_array<meters<real>>> cols;
+  EXPECT_EQ(ex.extract(std::string("{\"d_mm\": 1499}\n{\"d_mm\": 2.5}\n{}\n"), cols), 3u);
+  ASSERT_EQ(cols[0].size(), 3u);
+  // converted like floating-point: neither truncated nor rounded
+  EXPECT_DOUBLE_EQ(cols[0][0].count().v, 1.499);
+  EXPECT_DOUBLE_EQ(cols[0][1].count().v, 0.0025);
+  EXPECT_TRUE(std::isnan(cols[0][2].count().v));
+}
+
+TEST(TraitsTest, integral_cast) {
+  const meters<tagged> m(tagged(7));
+  EXPECT_EQ(distance_cast<millimeters<tagged>>(m).count().v, 7000);
+  EXPECT_EQ(distance_cast<kilometers<tagged>>(millimeters<tagged>(tagged(7999))).count().v, 0);
+}
+
+TEST(TraitsTest, simd_lane) {
+  // tagged and real have no common type with the built-ins; bulk casts use their lanes
+  millimeters<tagged> in[100];
+  for (int i = 0; i < 100; ++i) in[i] = millimeters<tagged>(tagged(i * 37 - 1800));
+  meters<real> out[100];
+  distance_cast_n<meters<real>>(in, 100, out);
+  for (int i = 0; i < 100; ++i) EXPECT_DOUBLE_EQ(out[i].count().v, (i * 37 - 1800) / 1000.0) << i;
+  centimeters<tagged> back[100];
+  distance_cast_n<centimeters<tagged>>(out, 100, back);
+  for (int i = 0; i < 100; ++i) EXPECT_EQ(back[i].count().v, static_cast<std::int32_t>((i * 37 - 1800) / 1000.0 * 100)) << i;
+}
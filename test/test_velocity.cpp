@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <type_traits>
+#include "metric_velocity.h"
+
+using namespace metric;
+using namespace metric::literals;
+using namespace std::chrono;
+
+TEST(VelocityTest, distance_over_duration) {
+  const auto v = millimeters<std::int64_t>(1500) / milliseconds(500);
+  static_assert(std::is_same<decltype(v), const velocity<std::int64_t, std::milli, std::milli>>::value,
+                "velocity keeps the units of its operands");
+  EXPECT_EQ(v.count(), 3);
+  EXPECT_EQ(v, meters_per_second<std::int64_t>(3));
+  EXPECT_EQ(velocity_cast<millimeters_per_second<std::int64_t>>(v).count(), 3000);
+  EXPECT_NEAR(velocity_cast<kilometers_per_hour<double>>(v).count(), 10.8, 1e-12);
+  EXPECT_EQ(velocity_cast<meters_per_second<std::int32_t>>(kilometers_per_hour<std::int32_t>(36)).count(), 10);
+}
+
+TEST(VelocityTest, velocity_times_duration_is_exact) {
+  const millimeters_per_second<std::int64_t> v(3);
+  const auto d = v * milliseconds(7);
+  static_assert(std::is_same<decltype(d), const micrometers<std::int64_t>>::value,
+                "mm/s * ms yields micrometers");
+  EXPECT_EQ(d.count(), 21);
+  EXPECT_EQ(seconds(2) * v, millimeters<std::int64_t>(6));
+  const auto t = meters<std::int64_t>(6) / v;  // 6 m / (3 mm/s) = 2000 s
+  EXPECT_EQ(duration_cast<seconds>(t), seconds(2000));
+}
+
+TEST(VelocityTest, arithmetic_and_relations) {
+  const auto s = meters_per_second<std::int64_t>(1) + kilometers_per_hour<std::int64_t>(18);
+  EXPECT_EQ(s, meters_per_second<std::int64_t>(6));
+  EXPECT_EQ(s - meters_per_second<std::int64_t>(1), kilometers_per_hour<std::int64_t>(18));
+  EXPECT_TRUE(kilometers_per_hour<std::int64_t>(36) > meters_per_second<std::int64_t>(9));
+  EXPECT_TRUE(kilometers_per_hour<std::int64_t>(36) <= meters_per_second<std::int64_t>(10));
+  EXPECT_EQ(kilometers_per_hour<double>(36.0) / meters_per_second<double>(5.0), 2.0);
+  EXPECT_EQ((meters_per_second<int>(4) * 2).count(), 8);
+  EXPECT_EQ((2 * meters_per_second<int>(4) / 4).count(), 2);
+  meters_per_second<double> a(1.0);
+  a += meters_per_second<double>(2.0);
+  a *= 2.0;
+  EXPECT_EQ(a, meters_per_second<double>(6.0));
+}
+
+TEST(VelocityTest, bulk_and_stream) {
+  const kilometers_per_hour<std::int64_t> in[] = {
+    kilometers_per_hour<std::int64_t>(36), kilometers_per_hour<std::int64_t>(72),
+  };
+  millimeters_per_second<std::int64_t> out[2];
+  velocity_cast_n<millimeters_per_second<std::int64_t>>(in, 2, out);
+  EXPECT_EQ(out[1].count(), 20000);
+  std::ostringstream os;
+  os << out[0] << ", " << in[0] << ", " << velocity<int, std::milli, std::milli>(3);
+  EXPECT_EQ(os.str(), "10000 mm/s, 36 km/h, 3 1/1 m/s");
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "metric_wkb.h"
+
+using namespace metric;
+using namespace metric::literals;
+
+namespace {
+
+// Minimal WKB writer for the tests.
+struct wkb_writer {
+  explicit wkb_writer(bool big_endian) : big(big_endian) { put_byte(big ? 0 : 1); }
+
+  void put_byte(unsigned char b) { s.push_back(static_cast<char>(b)); }
+
+  template <typename T>
+  void put(T v) {
+    char b[sizeof(T)];
+    std::memcpy(b, &v, sizeof(T));
+    if (big) for (std::size_t i = 0; i < sizeof(T) / 2; ++i) std::swap(b[i], b[sizeof(T) - 1 - i]);
+    s.append(b, sizeof(T));
+  }
+
+  bool big;
+  std::string s;
+};
+
+std::string line_string(bool big, const std::vector<double>& xy) {
+  wkb_writer w(big);
+  w.put<std::uint32_t>(2);
+  w.put<std::uint32_t>(static_cast<std::uint32_t>(xy.size() / 2));
+  for (double c : xy) w.put(c);
+  return w.s;
+}
+
+std::string polygon(bool big, const std::vector<std::vector<double>>& rings) {
+  wkb_writer w(big);
+  w.put<std::uint32_t>(3);
+  w.put<std::uint32_t>(static_cast<std::uint32_t>(rings.size()));
+  for (const auto& r : rings) {
+    w.put<std::uint32_t>(static_cast<std::uint32_t>(r.size() / 2));
+    for (double c : r) w.put(c);
+  }
+  return w.s;
+}
+
+}  // namespace
+
+TEST(WkbTest, point_views) {
+  wkb_writer w(false);
+  w.put<std::uint32_t>(1001);  // ISO Point Z
+  w.put(1.5);
+  w.put(2.5);
+  w.put(3.5);
+  wkb_geometry<std::milli> g(w.s.data(), w.s.size());
+  EXPECT_EQ(g.type(), wkb_type::point);
+  EXPECT_EQ(g.dimensions(), 3u);
+  EXPECT_TRUE(g.has_z());
+  EXPECT_FALSE(g.has_m());
+  EXPECT_EQ(g.bytes(), w.s.size());
+  EXPECT_EQ(g.x()[0], 1.5_mm);
+  EXPECT_EQ(g.y()[0], 2.5_mm);
+  EXPECT_EQ(g.z()[0], 3.5_mm);
+  EXPECT_THROW(g.m(), std::domain_error);
+}
+
+TEST(WkbTest, line_string_views) {
+  const std::string b = line_string(false, { 0, 0, 1, 2, 3, 4 });
+  wkb_geometry<> g(b.data(), b.size());
+  EXPECT_EQ(g.type(), wkb_type::line_string);
+  EXPECT_EQ(g.size(), 3u);
+  auto x = g.x();
+  EXPECT_EQ(x.size(), 3u);
+  EXPECT_EQ(x[2], 3.0_m);
+  EXPECT_EQ(g.y()[1], 2.0_m);
+}
+
+TEST(WkbTest, big_endian_decode) {
+  const std::vector<double> xy { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+  const std::string be = line_string(true, xy);
+  const std::string le = line_string(false, xy);
+  wkb_geometry<> g(be.data(), be.size());
+  EXPECT_TRUE(g.big_endian());
+  EXPECT_THROW(g.x(), std::domain_error);
+  point_array<millimeters<std::int64_t>> from_be, from_le;
+  g.decode(from_be);
+  wkb_geometry<>(le.data(), le.size()).decode(from_le);
+  ASSERT_EQ(from_be.size(), 5u);
+  EXPECT_EQ(from_be.x(), from_le.x());
+  EXPECT_EQ(from_be.y(), from_le.y());
+  EXPECT_EQ(from_be.x()[4], 9_m);
+  EXPECT_EQ(from_be.y()[4], 10_m);
+}
+
+TEST(WkbTest, ewkb_srid_and_polygon_rings) {
+  wkb_writer w(false);
+  w.put<std::uint32_t>(0x20000003u);  // EWKB Polygon with SRID
+  w.put<std::uint32_t>(4326);
+  w.put<std::uint32_t>(0);            // no rings
+  wkb_geometry<> empty(w.s.data(), w.s.size());
+  EXPECT_EQ(empty.srid(), 4326u);
+  EXPECT_EQ(empty.rings(), 0u);
+
+  const std::string b = polygon(false, { { 0, 0, 4, 0, 4, 4, 0, 0 }, { 1, 1, 2, 1, 1, 1 } });
+  wkb_geometry<std::centi> g(b.data(), b.size());
+  EXPECT_EQ(g.rings(), 2u);
+  EXPECT_EQ(g.size(0), 4u);
+  EXPECT_EQ(g.size(1), 3u);
+  EXPECT_EQ(g.x(1)[1], 2.0_cm);
+  point_array<centimeters<double>, 3> pts;
+  g.decode(pts);
+  EXPECT_EQ(pts.size(), 7u);
+  EXPECT_EQ(pts.z()[3], 0.0_cm);
+}
+
+TEST(WkbTest, batch_decode) {
+  std::vector<std::string> blobs;
+  blobs.push_back(line_string(false, { 1, 1, 2, 2 }));
+  blobs.push_back(polygon(true, { { 0, 0, 1, 0, 0, 0 }, { 5, 5, 6, 6, 5, 5 } }));
+  blobs.push_back(line_string(true, { 7, 8 }));
+  point_array<millimeters<double>> pts;
+  wkb_offsets offs;
+  wkb_decode(blobs.begin(), blobs.end(), pts, &offs);
+  EXPECT_EQ(pts.size(), 9u);
+  EXPECT_EQ(offs.geometries, (std::vector<std::size_t> { 0, 1, 3, 4 }));
+  EXPECT_EQ(offs.rings, (std::vector<std::size_t> { 0, 2, 5, 8, 9 }));
+  EXPECT_EQ(pts.x()[5], 5_m);
+  EXPECT_EQ(pts.y()[8], 8_m);
+}
+
+TEST(WkbTest, integral_decode_rounds) {
+  const std::string blob = line_string(false, { 4.35, 1.005, -4.35, -1.005 });
+  const wkb_geometry<> g(blob.data(), blob.size());
+  point_array<centimeters<std::int32_t>> cm;
+  g.decode(cm);
+  EXPECT_EQ(cm.x()[0].count(), 435);
+  EXPECT_EQ(cm.x()[1].count(), -435);
+  point_array<millimeters<std::int32_t>> mm;
+  g.decode(mm);
+  EXPECT_EQ(mm.y()[0].count(), 1005);
+  EXPECT_EQ(mm.y()[1].count(), -1005);
+
+  // POINT EMPTY has NaN coordinates
+  const std::vector<std::string> blobs { line_string(false, { 1, 2 }),
+                                         line_string(false, { std::numeric_limits<double>::quiet_NaN(), 0 }) };
+  EXPECT_THROW(wkb_decode(blobs.begin(), blobs.end(), mm), std::runtime_error);
+  EXPECT_EQ(mm.size(), 2u);
+  const std::string huge = line_string(false, { 1e10, 0 });
+  EXPECT_THROW(wkb_geometry<>(huge.data(), huge.size()).decode(mm), std::runtime_error);
+  EXPECT_EQ(mm.size(), 2u);
+  point_array<meters<double>> m;
+  wkb_decode(blobs.begin(), blobs.end(), m);
+  EXPECT_TRUE(std::isnan(m.x()[1].count()));
+}
+
+TEST(WkbTest, rejects_malformed_blobs) {
+  std::string b = line_string(false, { 1, 2, 3, 4 });
+  EXPECT_THROW(wkb_geometry<>(b.data(), b.size() - 1), std::runtime_error);
+  b[0] = 7;
+  EXPECT_THROW(wkb_geometry<>(b.data(), b.size()), std::runtime_error);
+  wkb_writer w(false);
+  w.put<std::uint32_t>(7);  // GeometryCollection
+  EXPECT_THROW(wkb_geometry<>(w.s.data(), w.s.size()), std::runtime_error);
+  wkb_writer v(false);
+  v.put<std::uint32_t>(4001);  // no ISO dimension prefix 4000
+  v.put(1.0);
+  v.put(2.0);
+  v.put(3.0);
+  EXPECT_THROW(wkb_geometry<>(v.s.data(), v.s.size()), std::runtime_error);
+}